@@ -6,6 +6,12 @@ function [y,nz] = ompdenoise2(params,msgdelta)
 %  OMPDENOISE (approximately the size of the input signal), so if memory is
 %  limited, OMPDENOISE can be used instead.
 %
+%  When PARAMS.threads is specified and non-zero, the blocks are extracted,
+%  coded and accumulated tile by tile in native code, in single precision
+%  and with this many threads (negative: all available cores). Only one
+%  block per thread is held in memory. PARAMS.memusage and
+%  MSGDELTA are ignored in this mode.
+%
 %  See also OMPDENOISE.
 
 
@@ -95,6 +101,14 @@ else
 end
 
 
+% threads %
+if (isfield(params,'threads'))
+  threads = params.threads;
+else
+  threads = 0;
+end
+
+
 % msgdelta %
 if (nargin <2)
   msgdelta = 5;
@@ -149,6 +163,14 @@ end
 
 % denoise the signal %
 
+if (threads ~= 0)
+  [y,nz] = ompdenoise2mex(x,D,G,blocksize,stepsize,epsilon,maxatoms,threads);
+  nz = nz/prod(floor((size(x)-blocksize)./stepsize) + 1);
+  cnt = countcover(size(x),blocksize,stepsize);
+  y = (y+lambda*x)./(cnt + lambda);
+  return;
+end
+
 
 nz = 0;  % count non-zeros in block representations
 
@@ -38,3 +38,16 @@ for i = 1:length(sourcefiles)
   printf('Compiling %s...', sourcefiles{i}{1});
   mex(sourcefiles{i}{:},compile_params{:});
 end
+
+
+% the fused denoising pipeline uses the OMPBox Batch-OMP engine, with OpenMP
+
+if (ispc)
+  openmp_params = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+  openmp_params = {'CFLAGS="\$CFLAGS -fopenmp"','LDFLAGS="\$LDFLAGS -fopenmp"'};
+end
+ompboxdir = fullfile('..','..','ompbox10','private');
+
+printf('Compiling ompdenoise2mex.c...');
+mex('ompdenoise2mex.c','patchdenoise.c',fullfile(ompboxdir,'ompbatch.c'),['-I' ompboxdir],compile_params{:},openmp_params{:});
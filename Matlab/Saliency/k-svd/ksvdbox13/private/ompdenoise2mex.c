@@ -0,0 +1,162 @@
+/**************************************************************************
+ *
+ * File name: ompdenoise2mex.c
+ *
+ * MEX interface to the fused 2-D OMP denoising pipeline in patchdenoise.c.
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include "patchdenoise.h"
+#include "ompbatch.h"
+
+
+/* Input Arguments */
+
+#define	X_IN	      prhs[0]
+#define D_IN        prhs[1]
+#define G_IN        prhs[2]
+#define SZ_IN       prhs[3]
+#define S_IN        prhs[4]
+#define EPS_IN      prhs[5]
+#define MAXATOMS_IN prhs[6]
+#define THREADS_IN  prhs[7]
+#define TILE_IN     prhs[8]
+
+
+/* Output Arguments */
+
+#define	Y_OUT	 plhs[0]
+#define NZ_OUT plhs[1]
+
+
+/* copy a double array to a newly allocated float array */
+
+static float* tofloat(double A[], mwSize count)
+{
+  float *B;
+  mwIndex i;
+  
+  B = (float*)mxMalloc(count*sizeof(float));
+  for (i=0; i<count; ++i) {
+    B[i] = (float)A[i];
+  }
+  return B;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], 
+		             int nrhs, const mxArray*prhs[])
+     
+{ 
+    double *s, *y;
+    float *xf, *Df, *Gf, *yf;
+    int sz[2], stepsize[2], maxatoms, threads, tilecols;
+    mwSize n1, n2, n, m;
+    mwIndex i;
+    long nz;
+    
+    
+    /* Check for proper number of arguments */
+    
+    if (nrhs < 8 || nrhs > 9) {
+      mexErrMsgTxt("Invalid number of input arguments."); 
+    } else if (nlhs > 2) {
+      mexErrMsgTxt("Too many output arguments."); 
+    } 
+    
+    
+    /* Check the the input dimensions */ 
+    
+    if (!mxIsDouble(X_IN) || mxIsComplex(X_IN) || mxGetNumberOfDimensions(X_IN)>2) {
+      mexErrMsgTxt("X should be a 2-D double matrix.");
+    }
+    if (!mxIsDouble(D_IN) || mxIsComplex(D_IN) || mxGetNumberOfDimensions(D_IN)>2) {
+      mexErrMsgTxt("D should be a double matrix.");
+    }
+    if (!mxIsDouble(SZ_IN) || mxIsComplex(SZ_IN) || mxGetM(SZ_IN)*mxGetN(SZ_IN)!=2) {
+      mexErrMsgTxt("Invalid block size.");
+    }
+    if (!mxIsDouble(S_IN) || mxIsComplex(S_IN) || mxGetM(S_IN)*mxGetN(S_IN)!=2) {
+      mexErrMsgTxt("Invalid step size.");
+    }
+    
+    
+    /* Get parameters */
+    
+    s = mxGetPr(SZ_IN);
+    if (s[0]<1 || s[1]<1) {
+      mexErrMsgTxt("Invalid block size.");
+    }
+    sz[0] = (int)(s[0] + 0.01);
+    sz[1] = (int)(s[1] + 0.01);
+    
+    s = mxGetPr(S_IN);
+    if (s[0]<1 || s[1]<1) {
+      mexErrMsgTxt("Invalid step size.");
+    }
+    stepsize[0] = (int)(s[0] + 0.01);
+    stepsize[1] = (int)(s[1] + 0.01);
+    
+    n1 = mxGetM(X_IN);
+    n2 = mxGetN(X_IN);
+    n = mxGetM(D_IN);
+    m = mxGetN(D_IN);
+    
+    if (n1<(mwSize)sz[0] || n2<(mwSize)sz[1]) {
+      mexErrMsgTxt("Block size too large.");
+    }
+    if (n != (mwSize)(sz[0]*sz[1])) {
+      mexErrMsgTxt("D and the block size have incompatible sizes.");
+    }
+    if (!mxIsEmpty(G_IN) && (mxGetM(G_IN)!=m || mxGetN(G_IN)!=m)) {
+      mexErrMsgTxt("D and G have incompatible sizes.");
+    }
+    
+    maxatoms = mxGetScalar(MAXATOMS_IN) < -1e-5 ? -1 : (int)(mxGetScalar(MAXATOMS_IN) + 0.01);
+    threads = (int)(mxGetScalar(THREADS_IN) + (mxGetScalar(THREADS_IN)<0 ? -0.5 : 0.5));
+    tilecols = nrhs > 8 ? (int)(mxGetScalar(TILE_IN) + 0.01) : 0;
+    
+    
+    /* Convert the inputs */
+    
+    xf = tofloat(mxGetPr(X_IN), n1*n2);
+    Df = tofloat(mxGetPr(D_IN), n*m);
+    if (mxIsEmpty(G_IN)) {
+      Gf = (float*)mxMalloc(m*m*sizeof(float));
+      ompbatch_gram(Df, Gf, (int)n, (int)m, threads);
+    }
+    else {
+      Gf = tofloat(mxGetPr(G_IN), m*m);
+    }
+    yf = (float*)mxMalloc(n1*n2*sizeof(float));
+    
+    
+    /* Do the actual computation */
+    
+    nz = patchdenoise2(xf, yf, (int)n1, (int)n2, sz, stepsize, Df, Gf, (int)m, 
+                       (float)mxGetScalar(EPS_IN), maxatoms, tilecols, threads);
+    if (nz < 0) {
+      mexErrMsgTxt("Out of memory in the denoising threads.");
+    }
+    
+    
+    /* Create the return arguments */
+    
+    Y_OUT = mxCreateDoubleMatrix(n1, n2, mxREAL);
+    y = mxGetPr(Y_OUT);
+    for (i=0; i<n1*n2; ++i) {
+      y[i] = yf[i];
+    }
+    if (nlhs > 1) {
+      NZ_OUT = mxCreateDoubleScalar((double)nz);
+    }
+    
+    mxFree(yf);
+    mxFree(Gf);
+    mxFree(Df);
+    mxFree(xf);
+    
+    return;
+}
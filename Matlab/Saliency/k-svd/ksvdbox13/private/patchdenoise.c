@@ -0,0 +1,172 @@
+/**************************************************************************
+ *
+ * File name: patchdenoise.c
+ *
+ * Fused 2-D OMP denoising pipeline, see patchdenoise.h.
+ *
+ *************************************************************************/
+
+
+#include "patchdenoise.h"
+#include "ompbatch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/* default number of block columns per tile */
+
+#define DEFAULT_TILE_COLS 8
+
+
+
+/* working arrays of one thread, allocated once and reused for all the
+   blocks of all the tiles the thread handles */
+
+typedef struct tile_arena
+{
+  float *block;           /* n */
+  int *ind;               /* atoms */
+  float *coefs;           /* atoms */
+  ompbatch_arena *omp;
+} tile_arena;
+
+
+static int alloc_tile(tile_arena *a, int n, int m, int maxatoms)
+{
+  int atoms = ompbatch_atoms(maxatoms, m, n);
+  
+  a->block = (float*)malloc(n*sizeof(float));
+  a->ind = (int*)malloc(atoms*sizeof(int));
+  a->coefs = (float*)malloc(atoms*sizeof(float));
+  a->omp = ompbatch_arena_alloc(n, m, maxatoms);
+  return a->block && a->ind && a->coefs && a->omp;
+}
+
+
+static void free_tile(tile_arena *a)
+{
+  ompbatch_arena_free(a->omp);
+  free(a->coefs);
+  free(a->ind);
+  free(a->block);
+}
+
+
+/* extract, code and accumulate the blocks whose column positions are
+   block columns [first, last) */
+
+static long denoise_tile(tile_arena *a, const float x[], float y[], int n1, const int blocksize[2], const int stepsize[2],
+                         int rowblocks, int first, int last, const float D[], const float G[], float eps)
+{
+  int n = blocksize[0]*blocksize[1];
+  int bi, bj, i, l, k, count;
+  long nz = 0;
+  float *block = a->block;
+  
+  for (bj=first; bj<last; ++bj) {
+    for (bi=0; bi<rowblocks; ++bi) {
+      const float *src = x + (size_t)bj*stepsize[1]*n1 + bi*stepsize[0];
+      float *dst = y + (size_t)bj*stepsize[1]*n1 + bi*stepsize[0];
+      float sum = 0, dc;
+      
+      /* extract the block, im2colstep order, and remove its DC */
+      for (l=0; l<blocksize[1]; ++l) {
+        memcpy(block + l*blocksize[0], src + (size_t)l*n1, blocksize[0]*sizeof(float));
+      }
+      for (i=0; i<n; ++i) {
+        sum += block[i];
+      }
+      dc = sum/n;
+      for (i=0; i<n; ++i) {
+        block[i] -= dc;
+      }
+      
+      /* sparse-code it on this thread */
+      count = ompbatch_signal(a->omp, D, block, G, eps, 1, a->ind, a->coefs);
+      nz += count;
+      
+      /* reconstruct D*gamma + dc in place of the block and add to y */
+      for (i=0; i<n; ++i) {
+        block[i] = dc;
+      }
+      for (k=0; k<count; ++k) {
+        const float *atom = D + (size_t)n*a->ind[k];
+        float coef = a->coefs[k];
+        for (i=0; i<n; ++i) {
+          block[i] += coef*atom[i];
+        }
+      }
+      for (l=0; l<blocksize[1]; ++l) {
+        float *col = dst + (size_t)l*n1;
+        const float *blockcol = block + l*blocksize[0];
+        for (i=0; i<blocksize[0]; ++i) {
+          col[i] += blockcol[i];
+        }
+      }
+    }
+  }
+  
+  return nz;
+}
+
+
+long patchdenoise2(const float x[], float y[], int n1, int n2, const int blocksize[2], const int stepsize[2],
+                   const float D[], const float G[], int m, float eps, int maxatoms, int tilecols, int threads)
+{
+  int n = blocksize[0]*blocksize[1];
+  int rowblocks = (n1-blocksize[0])/stepsize[0] + 1;
+  int colblocks = (n2-blocksize[1])/stepsize[1] + 1;
+  int tilenum, parity;
+  long nz = 0;
+  int failed = 0;
+  
+  memset(y, 0, (size_t)n1*n2*sizeof(float));
+  
+  /* a tile must span at least one block, so that tiles two apart are disjoint */
+  if (tilecols <= 0) {
+    tilecols = DEFAULT_TILE_COLS;
+  }
+  if (tilecols*stepsize[1] < blocksize[1]) {
+    tilecols = (blocksize[1] + stepsize[1] - 1)/stepsize[1];
+  }
+  tilenum = (colblocks + tilecols - 1)/tilecols;
+  
+#ifdef _OPENMP
+  if (threads <= 0) {
+    threads = omp_get_max_threads();
+  }
+#pragma omp parallel num_threads(threads) reduction(+:nz, failed) private(parity)
+#else
+  (void)threads;
+#endif
+  {
+    tile_arena arena;
+    int tile;
+    
+    if (!alloc_tile(&arena, n, m, maxatoms)) {
+      failed = 1;
+    }
+    
+    for (parity=0; parity<2; ++parity) {
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+      for (tile=parity; tile<tilenum; tile+=2) {
+        if (!failed) {
+          nz += denoise_tile(&arena, x, y, n1, blocksize, stepsize, rowblocks, tile*tilecols, 
+                             tile*tilecols+tilecols < colblocks ? tile*tilecols+tilecols : colblocks,
+                             D, G, eps);
+        }
+      }
+      /* the implicit barrier of the loop separates the two passes */
+    }
+    
+    free_tile(&arena);
+  }
+  
+  return failed ? -1 : nz;
+}
@@ -0,0 +1,62 @@
+/**************************************************************************
+ *
+ * File name: patchdenoise.h
+ *
+ * Fused patch extraction, OMP coding and reconstruction for 2-D OMP
+ * denoising, as done by OMPDENOISE2 with IM2COLSTEP / OMP2 / COL2IMSTEP.
+ *
+ * The block positions are split into tiles of whole block columns. For
+ * each block of a tile, the block is extracted, its DC removed, coded
+ * with the single-precision OMP engine (ompbatch_signal, one arena per
+ * thread) and the reconstructed block added to the output, so only one
+ * block per thread is ever held in memory. Tiles are at least one block wide, so even tiles never overlap
+ * each other in the output: all even tiles are done in parallel, then
+ * all odd ones, and every output pixel receives its sums in the same
+ * order whatever the number of threads.
+ *
+ * Does not depend on the MEX API.
+ *
+ *************************************************************************/
+
+
+#ifndef __PATCH_DENOISE_H__
+#define __PATCH_DENOISE_H__
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**************************************************************************
+ * Denoise the blocks of a 2-D signal and accumulate them.
+ *
+ * Parameters:
+ *   x - the noisy signal, of size n1 X n2 (column major)
+ *   y - output, the sum of the denoised blocks covering each pixel, of
+ *       size n1 X n2. It is overwritten.
+ *   blocksize, stepsize - block size and distance between blocks, as in
+ *       IM2COLSTEP
+ *   D - the dictionary, of size prod(blocksize) X m, unit-norm atoms
+ *   G - D'*D, of size m X m
+ *   eps - target residual norm of each block
+ *   maxatoms - maximal number of atoms per block, non-positive: no limit
+ *   tilecols - number of block columns per tile, non-positive: default
+ *   threads - number of threads, non-positive: as many as available
+ *
+ * Returns:
+ *   The total number of atoms used, or -1 if memory ran out.
+ *
+ **************************************************************************/
+long patchdenoise2(const float x[], float y[], int n1, int n2, const int blocksize[2], const int stepsize[2],
+                   const float D[], const float G[], int m, float eps, int maxatoms, int tilecols, int threads);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
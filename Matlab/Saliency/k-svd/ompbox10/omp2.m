@@ -59,6 +59,11 @@ function gamma = omp2(varargin)
 %    'profile'   - Can be either 'on' or 'off'. When 'on', profiling
 %                  information is displayed at the end of the funciton
 %                  execution.
+%    'threads'   - When non-zero, the signals are coded by the multithreaded
+%                  single precision Batch-OMP engine, using this many
+%                  threads (negative: all available cores). Messages and
+%                  profiling are not available in this mode. The default
+%                  0 uses the original double precision implementation.
 %
 %
 %  Summary of OMP2 versions:
@@ -94,6 +99,7 @@ msgdelta = -1;
 maxatoms = -1;
 checkdict = 1;
 profile = 0;
+threads = 0;
 
 
 % determine number of parameters
@@ -146,6 +152,9 @@ for i = paramnum+1:2:length(varargin)
         error('Invalid profile mode');
       end
 
+    case 'threads'
+      threads = paramval;
+
     otherwise
       error(['Unknown option: ' paramname]);
   end
@@ -202,4 +211,4 @@ end
 
 % omp
 
-gamma = omp2mex(D,X,DtX,XtX,G,epsilon,sparse_gamma,msgdelta,maxatoms,profile);
+gamma = omp2mex(D,X,DtX,XtX,G,epsilon,sparse_gamma,msgdelta,maxatoms,profile,threads);
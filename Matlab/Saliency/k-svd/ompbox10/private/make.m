@@ -36,6 +36,14 @@ ompsources = {'mexutils.c','ompcore.c','omputils.c','myblas.c','ompprof.c'};
 disp('Compiling ompmex...');
 mex('ompmex.c', ompsources{:},compile_params{:});
 
+% omp2mex also links the multithreaded engine, built with OpenMP
+
+if (ispc)
+  openmp_params = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+  openmp_params = {'CFLAGS="\$CFLAGS -fopenmp"','LDFLAGS="\$LDFLAGS -fopenmp"'};
+end
+
 disp('Compiling omp2mex...');
-mex('omp2mex.c',ompsources{:},compile_params{:});
+mex('omp2mex.c','ompbatch.c',ompsources{:},compile_params{:},openmp_params{:});
 
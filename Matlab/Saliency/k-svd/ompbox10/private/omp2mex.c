@@ -14,6 +14,8 @@
 #include "ompcore.h"
 #include "omputils.h"
 #include "mexutils.h"
+#include "ompbatch.h"
+#include <math.h>
 
 
 /* Input Arguments */
@@ -28,6 +30,7 @@
 #define IN_MSGDELTA   prhs[7]
 #define IN_MAXATOMS   prhs[8]
 #define IN_PROFILE    prhs[9]
+#define IN_THREADS    prhs[10]     /* optional */
 
 
 /* Output Arguments */
@@ -38,11 +41,113 @@
 /***************************************************************************************/
 
 
+/* copy a double array to a newly allocated float array, 0 for an empty input */
+
+static float* tofloat(double A[], mwSize count)
+{
+  float *B;
+  mwIndex i;
+  
+  if (!A) {
+    return 0;
+  }
+  B = (float*)mxMalloc(count*sizeof(float));
+  for (i=0; i<count; ++i) {
+    B[i] = (float)A[i];
+  }
+  return B;
+}
+
+
+/* error-omp through the multithreaded single-precision engine */
+
+static mxArray* ompbatchmex(double D[], double x[], double DtX[], double XtX[], double G[], mwSize n, mwSize m, mwSize L,
+                            int T, double eps, int gamma_mode, int threads)
+{
+  mxArray *Gamma;
+  float *Df, *xf, *DtXf, *XtXf, *Gf;
+  ompbatch_result result;
+  long total, j;
+  mwIndex signum, *gammaIr, *gammaJc;
+  double *gammaPr;
+  
+  /* the engine only needs D'*x, sum(x.*x) and G */
+  
+  Df = tofloat(D, n*m);
+  xf = tofloat(x, n*L);
+  DtXf = tofloat(DtX, m*L);
+  XtXf = tofloat(XtX, L);
+  Gf = tofloat(G, m*m);
+  
+  if (!DtXf) {
+    DtXf = (float*)mxMalloc(m*L*sizeof(float));
+    XtXf = (float*)mxMalloc(L*sizeof(float));
+    ompbatch_dtx(Df, xf, DtXf, XtXf, (int)n, (int)m, (int)L, threads);
+  }
+  if (!Gf) {
+    Gf = (float*)mxMalloc(m*m*sizeof(float));
+    ompbatch_gram(Df, Gf, (int)n, (int)m, threads);
+  }
+  
+  /* only the selected atoms are kept, in the layout of a sparse gamma */
+  
+  total = ompbatch(DtXf, XtXf, Gf, (int)n, (int)m, (int)L, T, (float)eps, 1, threads, &result);
+  if (total < 0) {
+    mexErrMsgTxt("Out of memory in the OMP worker threads.");
+  }
+  
+  
+  /* write the representations to gamma */
+  
+  if (gamma_mode == FULL_GAMMA) {
+    Gamma = mxCreateDoubleMatrix(m, L, mxREAL);
+    gammaPr = mxGetPr(Gamma);
+    for (signum=0; signum<L; ++signum) {
+      for (j=result.start[signum]; j<result.start[signum+1]; ++j) {
+        gammaPr[m*signum + result.ind[j]] = result.coefs[j];
+      }
+    }
+  }
+  else {
+    Gamma = mxCreateSparse(m, L, total>0 ? total : 1, mxREAL);
+    gammaPr = mxGetPr(Gamma);
+    gammaIr = mxGetIr(Gamma);
+    gammaJc = mxGetJc(Gamma);
+    for (signum=0; signum<=L; ++signum) {
+      gammaJc[signum] = result.start[signum];
+    }
+    for (j=0; j<total; ++j) {
+      gammaPr[j] = result.coefs[j];
+      gammaIr[j] = result.ind[j];
+    }
+  }
+  
+  
+  /* free memory */
+  
+  ompbatch_free(&result);
+  mxFree(Gf);
+  mxFree(XtXf);
+  mxFree(DtXf);
+  if (xf) {
+    mxFree(xf);
+  }
+  if (Df) {
+    mxFree(Df);
+  }
+  
+  return Gamma;
+}
+
+
+/***************************************************************************************/
+
+
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
 
 {
   double *D, *x, *DtX, *XtX, *G, eps, msgdelta;
-  int gmode, maxatoms, profile;
+  int gmode, maxatoms, profile, threads;
   mwSize m, n, L;    /* D is n x m , X is n x L, DtX is m x L */
 
   
@@ -59,6 +164,9 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
   checkscalar(IN_MSGDELTA, "OMP2", "msgdelta");
   checkscalar(IN_MAXATOMS, "OMP2", "maxatoms");
   checkscalar(IN_PROFILE, "OMP2", "profile");
+  if (nrhs > 10) {
+    checkscalar(IN_THREADS, "OMP2", "threads");
+  }
   
   
   /* get parameters */
@@ -96,6 +204,12 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
   }
   profile = (int)(mxGetScalar(IN_PROFILE)+1e-2);
   
+  /* 0: the double precision single-threaded core, negative: all cores */
+  threads = 0;
+  if (nrhs > 10) {
+    threads = (int)floor(mxGetScalar(IN_THREADS)+0.5);
+  }
+  
   
   /* check sizes */
   
@@ -150,6 +264,11 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
   
   /* Do OMP! */
   
+  if (threads != 0) {
+    GAMMA_OUT = ompbatchmex(D, x, DtX, XtX, G, n, m, L, maxatoms, eps, gmode, threads);
+    return;
+  }
+  
   GAMMA_OUT = ompcore(D, x, DtX, XtX, G, n, m, L, maxatoms, eps, gmode, profile, msgdelta, 1);
   
   return;
@@ -0,0 +1,545 @@
+/**************************************************************************
+ *
+ * File name: ompbatch.c
+ *
+ * Multithreaded single-precision Batch-OMP, see ompbatch.h.
+ *
+ *************************************************************************/
+
+
+#include "ompbatch.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+
+/******************************************************************************
+ *                                                                            *
+ *                         Single precision kernels                           *
+ *                                                                            *
+ ******************************************************************************/
+
+/* The loops below keep independent accumulators and unit strides so the
+   compiler can vectorize them; the double precision versions in myblas.c
+   are left as they are for the MEX path. */
+
+
+/* a'*b, for vectors of length n */
+
+static float dotprod_f(const float a[], const float b[], int n)
+{
+  float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  int i;
+  
+  for (i=0; i+3<n; i+=4) {
+    sum0 += a[i]*b[i];
+    sum1 += a[i+1]*b[i+1];
+    sum2 += a[i+2]*b[i+2];
+    sum3 += a[i+3]*b[i+3];
+  }
+  for (; i<n; ++i) {
+    sum0 += a[i]*b[i];
+  }
+  return (sum0+sum1) + (sum2+sum3);
+}
+
+
+/* y := A'*x, A of size n X m */
+
+static void matT_vec_f(const float A[], const float x[], float y[], int n, int m)
+{
+  int j;
+  
+  for (j=0; j<m; ++j) {
+    y[j] = dotprod_f(A+j*n, x, n);
+  }
+}
+
+
+/* y := b - A*x, A of size n X k, with k small (the number of selected atoms) */
+
+static void vec_sub_mat_vec_f(const float b[], const float A[], const float x[], float y[], int n, int k)
+{
+  int i, j;
+  
+  memcpy(y, b, n*sizeof(float));
+  for (j=0; j<k; ++j) {
+    const float *col = A+j*n;
+    float coef = x[j];
+    for (i=0; i<n; ++i) {
+      y[i] -= coef*col[i];
+    }
+  }
+}
+
+
+/* index of the entry with largest absolute value */
+
+static int maxabs_f(const float x[], int n)
+{
+  int i, maxi = 0;
+  float maxval = (float)fabs(x[0]);
+  
+  for (i=1; i<n; ++i) {
+    if ((float)fabs(x[i]) > maxval) {
+      maxval = (float)fabs(x[i]);
+      maxi = i;
+    }
+  }
+  return maxi;
+}
+
+
+/* solve L*x = b, L lower triangular stored with stride n */
+
+static void backsubst_L_f(const float L[], const float b[], float x[], int n, int k)
+{
+  int i, j;
+  float rhs;
+  
+  for (i=0; i<k; ++i) {
+    rhs = b[i];
+    for (j=0; j<i; ++j) {
+      rhs -= L[j*n+i]*x[j];
+    }
+    x[i] = rhs/L[i*n+i];
+  }
+}
+
+
+/* solve L*L'*x = b */
+
+static void cholsolve_L_f(const float L[], const float b[], float x[], float tmp[], int n, int k)
+{
+  int i, j;
+  float rhs;
+  
+  backsubst_L_f(L, b, tmp, n, k);
+  for (i=k; i>=1; --i) {
+    rhs = tmp[i-1];
+    for (j=i; j<k; ++j) {
+      rhs -= L[(i-1)*n+j]*x[j];
+    }
+    x[i-1] = rhs/L[(i-1)*n+i-1];
+  }
+}
+
+
+/* sort the atoms of one representation by index, k is small */
+
+static void sort_atoms(int ind[], float c[], int k)
+{
+  int i, j, key;
+  float val;
+  
+  for (i=1; i<k; ++i) {
+    key = ind[i];
+    val = c[i];
+    for (j=i-1; j>=0 && ind[j]>key; --j) {
+      ind[j+1] = ind[j];
+      c[j+1] = c[j];
+    }
+    ind[j+1] = key;
+    c[j+1] = val;
+  }
+}
+
+
+
+/******************************************************************************
+ *                                                                            *
+ *                           Batch-OMP Implementation                         *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* working arrays of one thread, allocated once in a single block and
+   reused for all the signals the thread handles */
+
+struct ompbatch_arena
+{
+  int n, m, T;
+  float *DtX;            /* D'*x of the signal passed to ompbatch_signal, m */
+  float *alpha;          /* D'*residual, m */
+  float *Gsub;           /* G(:,ind), m X T */
+  float *Lchol;          /* Cholesky factor of G(ind,ind), T X T */
+  float *c;              /* coefficients, T */
+  float *tempvec1;       /* m */
+  float *tempvec2;       /* m */
+  int *ind;              /* selected atoms, T */
+  char *selected_atoms;  /* m */
+  void *block;
+};
+
+
+static int alloc_arena(ompbatch_arena *arena, int n, int m, int T)
+{
+  size_t floats = (size_t)m*4 + (size_t)m*T + (size_t)T*T + T;
+  float *f;
+  
+  memset(arena, 0, sizeof(ompbatch_arena));
+  arena->n = n;
+  arena->m = m;
+  arena->T = T;
+  arena->block = malloc(floats*sizeof(float) + (size_t)T*sizeof(int) + m);
+  if (!arena->block) {
+    return 0;
+  }
+  f = (float*)arena->block;
+  arena->DtX = f;        f += m;
+  arena->alpha = f;      f += m;
+  arena->tempvec1 = f;   f += m;
+  arena->tempvec2 = f;   f += m;
+  arena->Gsub = f;       f += (size_t)m*T;
+  arena->Lchol = f;      f += (size_t)T*T;
+  arena->c = f;          f += T;
+  arena->ind = (int*)f;
+  arena->selected_atoms = (char*)(arena->ind + T);
+  return 1;
+}
+
+
+/* omp for one signal, returns the number of atoms written to ind/coefs */
+
+static int omp_signal(ompbatch_arena *a, const float DtX[], float XtX, const float G[], int m,
+                      int T, float eps2, int erroromp, int ind[], float coefs[])
+{
+  int i, j, pos;
+  float sum, resnorm, delta, deltaprev = 0;
+  float *Lchol = a->Lchol;
+  
+  resnorm = erroromp ? XtX : 1;
+  if (!erroromp) {
+    eps2 = 0;
+  }
+  if (resnorm<=eps2 || T<=0) {
+    return 0;
+  }
+  
+  memcpy(a->alpha, DtX, m*sizeof(float));
+  memset(a->selected_atoms, 0, m);
+  
+  i = 0;
+  while (resnorm>eps2 && i<T) {
+    
+    /* index of next atom */
+    pos = maxabs_f(a->alpha, m);
+    
+    /* stop criterion: selected same atom twice, or inner product too small */
+    if (a->selected_atoms[pos] || a->alpha[pos]*a->alpha[pos]<1e-14) {
+      break;
+    }
+    
+    a->ind[i] = pos;
+    a->selected_atoms[pos] = 1;
+    memcpy(a->Gsub+i*m, G+(size_t)pos*m, m*sizeof(float));
+    
+    /* incremental Cholesky update: next row of Lchol */
+    if (i==0) {
+      *Lchol = 1;
+    }
+    else {
+      for (j=0; j<i; ++j) {
+        a->tempvec1[j] = a->Gsub[i*m + a->ind[j]];
+      }
+      backsubst_L_f(Lchol, a->tempvec1, a->tempvec2, T, i);
+      sum = 0;
+      for (j=0; j<i; ++j) {
+        Lchol[j*T+i] = a->tempvec2[j];
+        sum += a->tempvec2[j]*a->tempvec2[j];
+      }
+      if ( (1-sum) <= 1e-7 ) {     /* selected atoms are dependent, at float precision */
+        break;
+      }
+      Lchol[i*T+i] = (float)sqrt(1-sum);
+    }
+    
+    i++;
+    
+    /* orthogonal projection */
+    for (j=0; j<i; ++j) {
+      a->tempvec1[j] = DtX[a->ind[j]];
+    }
+    cholsolve_L_f(Lchol, a->tempvec1, a->c, a->tempvec2, T, i);
+    
+    /* alpha := D'*x - Gsub*c */
+    vec_sub_mat_vec_f(DtX, a->Gsub, a->c, a->alpha, m, i);
+    
+    /* residual norm update, Gsub(ind,:)*c is DtX(ind) - alpha(ind) */
+    if (erroromp) {
+      delta = 0;
+      for (j=0; j<i; ++j) {
+        delta += a->c[j]*(DtX[a->ind[j]] - a->alpha[a->ind[j]]);
+      }
+      resnorm = resnorm - delta + deltaprev;
+      deltaprev = delta;
+    }
+  }
+  
+  memcpy(ind, a->ind, i*sizeof(int));
+  memcpy(coefs, a->c, i*sizeof(float));
+  sort_atoms(ind, coefs, i);
+  return i;
+}
+
+
+int ompbatch_atoms(int T, int m, int n)
+{
+  int maxatoms = m<n ? m : n;
+  return (T<=0 || T>maxatoms) ? maxatoms : T;
+}
+
+
+ompbatch_arena* ompbatch_arena_alloc(int n, int m, int T)
+{
+  ompbatch_arena *arena = (ompbatch_arena*)malloc(sizeof(ompbatch_arena));
+  
+  if (!arena) {
+    return 0;
+  }
+  if (!alloc_arena(arena, n, m, ompbatch_atoms(T, m, n))) {
+    free(arena);
+    return 0;
+  }
+  return arena;
+}
+
+
+void ompbatch_arena_free(ompbatch_arena *arena)
+{
+  if (arena) {
+    free(arena->block);
+    free(arena);
+  }
+}
+
+
+int ompbatch_signal(ompbatch_arena *arena, const float D[], const float x[], const float G[],
+                    float eps, int erroromp, int ind[], float coefs[])
+{
+  float XtX = erroromp ? dotprod_f(x, x, arena->n) : 0;
+  
+  matT_vec_f(D, x, arena->DtX, arena->n, arena->m);
+  return omp_signal(arena, arena->DtX, XtX, G, arena->m, arena->T, eps*eps, erroromp, ind, coefs);
+}
+
+
+/* signals coded as one unit of work, their representations are collected
+   in a buffer of the block and compacted once all blocks are done */
+
+#define OMPBATCH_BLOCK 256
+
+/* growth of a block buffer, as MAT_INC_FACTOR in omputils.h */
+
+#define OMPBATCH_INC_FACTOR (1.6)
+
+typedef struct ompbatch_block
+{
+  int *ind;
+  float *coefs;
+  long count;
+  long allocated;
+} ompbatch_block;
+
+
+/* make room for T more atoms in a block buffer */
+
+static int grow_block(ompbatch_block *out, int T)
+{
+  long allocated;
+  int *ind;
+  float *coefs;
+  
+  if (out->count+T <= out->allocated) {
+    return 1;
+  }
+  allocated = (long)(out->allocated*OMPBATCH_INC_FACTOR) + 1;
+  if (allocated < out->count+T) {
+    allocated = out->count+T;
+  }
+  ind = (int*)realloc(out->ind, allocated*sizeof(int));
+  if (!ind) {
+    return 0;
+  }
+  out->ind = ind;
+  coefs = (float*)realloc(out->coefs, allocated*sizeof(float));
+  if (!coefs) {
+    return 0;
+  }
+  out->coefs = coefs;
+  out->allocated = allocated;
+  return 1;
+}
+
+
+void ompbatch_free(ompbatch_result *result)
+{
+  free(result->start);
+  free(result->ind);
+  free(result->coefs);
+  result->start = 0;
+  result->ind = 0;
+  result->coefs = 0;
+}
+
+
+long ompbatch(const float DtX[], const float XtX[], const float G[], int n, int m, int L,
+              int T, float eps, int erroromp, int threads, ompbatch_result *result)
+{
+  long total = 0;
+  int failed = 0;
+  int blocknum = (L + OMPBATCH_BLOCK - 1)/OMPBATCH_BLOCK;
+  int initial, block, signum;
+  float eps2 = eps*eps;
+  ompbatch_block *out;
+  
+  T = ompbatch_atoms(T, m, n);
+  
+  /* error-omp typically selects far fewer than T atoms, start as ompcore
+     does with sqrt(n)/2 per signal and grow */
+  initial = T;
+  if (erroromp && (int)(sqrt((double)n)/2) + 1 < T) {
+    initial = (int)(sqrt((double)n)/2) + 1;
+  }
+  
+  result->ind = 0;
+  result->coefs = 0;
+  result->start = (long*)malloc((L+1)*sizeof(long));
+  out = (ompbatch_block*)calloc(blocknum, sizeof(ompbatch_block));
+  if (!result->start || !out) {
+    free(out);
+    ompbatch_free(result);
+    return -1;
+  }
+  
+#ifdef _OPENMP
+  if (threads <= 0) {
+    threads = omp_get_max_threads();
+  }
+#pragma omp parallel num_threads(threads) reduction(+:failed) private(block, signum)
+#else
+  (void)threads;
+#endif
+  {
+    ompbatch_arena arena;
+    
+    if (!alloc_arena(&arena, n, m, T)) {
+      failed = 1;
+    }
+    
+    /* representations differ in length, hand out blocks one at a time */
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (block=0; block<blocknum; ++block) {
+      int first = block*OMPBATCH_BLOCK;
+      int last = first+OMPBATCH_BLOCK < L ? first+OMPBATCH_BLOCK : L;
+      ompbatch_block *blockout = out+block;
+      
+      if (!arena.block) {
+        continue;
+      }
+      blockout->allocated = (long)initial*(last-first);
+      blockout->ind = (int*)malloc(blockout->allocated*sizeof(int));
+      blockout->coefs = (float*)malloc(blockout->allocated*sizeof(float));
+      if (!blockout->ind || !blockout->coefs) {
+        failed = 1;
+        continue;
+      }
+      
+      for (signum=first; signum<last; ++signum) {
+        int count;
+        if (!grow_block(blockout, T)) {
+          failed = 1;
+          break;
+        }
+        count = omp_signal(&arena, DtX+(size_t)m*signum, XtX ? XtX[signum] : 0, G, m, T, eps2,
+                           erroromp, blockout->ind+blockout->count, blockout->coefs+blockout->count);
+        blockout->count += count;
+        result->start[signum+1] = count;
+      }
+    }
+    
+    free(arena.block);
+  }
+  
+  
+  /* compact the blocks into the result */
+  
+  if (!failed) {
+    result->start[0] = 0;
+    for (signum=0; signum<L; ++signum) {
+      result->start[signum+1] += result->start[signum];
+    }
+    total = result->start[L];
+    result->ind = (int*)malloc((total>0 ? total : 1)*sizeof(int));
+    result->coefs = (float*)malloc((total>0 ? total : 1)*sizeof(float));
+    if (!result->ind || !result->coefs) {
+      failed = 1;
+    }
+    else {
+      for (block=0; block<blocknum; ++block) {
+        long offset = result->start[block*OMPBATCH_BLOCK];
+        memcpy(result->ind+offset, out[block].ind, out[block].count*sizeof(int));
+        memcpy(result->coefs+offset, out[block].coefs, out[block].count*sizeof(float));
+      }
+    }
+  }
+  
+  for (block=0; block<blocknum; ++block) {
+    free(out[block].ind);
+    free(out[block].coefs);
+  }
+  free(out);
+  
+  if (failed) {
+    ompbatch_free(result);
+    return -1;
+  }
+  return total;
+}
+
+
+void ompbatch_dtx(const float D[], const float x[], float DtX[], float XtX[], int n, int m, int L, int threads)
+{
+  int signum;
+  
+#ifdef _OPENMP
+  if (threads <= 0) {
+    threads = omp_get_max_threads();
+  }
+#pragma omp parallel for num_threads(threads)
+#else
+  (void)threads;
+#endif
+  for (signum=0; signum<L; ++signum) {
+    const float *signal = x+(size_t)n*signum;
+    matT_vec_f(D, signal, DtX+(size_t)m*signum, n, m);
+    if (XtX) {
+      XtX[signum] = dotprod_f(signal, signal, n);
+    }
+  }
+}
+
+
+void ompbatch_gram(const float D[], float G[], int n, int m, int threads)
+{
+  int j;
+  
+#ifdef _OPENMP
+  if (threads <= 0) {
+    threads = omp_get_max_threads();
+  }
+#pragma omp parallel for num_threads(threads)
+#else
+  (void)threads;
+#endif
+  for (j=0; j<m; ++j) {
+    matT_vec_f(D, D+(size_t)j*n, G+(size_t)j*m, n, m);
+  }
+}
@@ -0,0 +1,158 @@
+/**************************************************************************
+ *
+ * File name: ompbatch.h
+ *
+ * Multithreaded single-precision Batch-OMP.
+ *
+ * Same algorithm as the Batch-OMP path of ompcore(), for the case where
+ * G = D'*D is available: the signals are split between threads, which
+ * share G and D'*x read-only and keep their own working arrays. Storage
+ * is float throughout. Does not depend on the MEX API, so it can be
+ * called from native C/C++ code as well as from omp2mex.
+ *
+ *************************************************************************/
+
+
+#ifndef __OMP_BATCH_H__
+#define __OMP_BATCH_H__
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**************************************************************************
+ * Compute D'*x and the squared norms of the signals in x.
+ *
+ * Parameters:
+ *   D - the dictionary, of size n X m
+ *   x - the signals, of size n X L
+ *   DtX - output D'*x, of size m X L
+ *   XtX - output sum(x.*x), of length L (may be null)
+ *   threads - number of threads, non-positive: as many as available
+ *
+ **************************************************************************/
+void ompbatch_dtx(const float D[], const float x[], float DtX[], float XtX[], int n, int m, int L, int threads);
+
+
+
+/**************************************************************************
+ * Compute the Gram matrix G = D'*D, of size m X m.
+ **************************************************************************/
+void ompbatch_gram(const float D[], float G[], int n, int m, int threads);
+
+
+
+/**************************************************************************
+ * Sparse representations of a set of signals, stored column by column as
+ * in a Matlab sparse matrix: the atoms of signal i are ind[start[i]] to
+ * ind[start[i+1]-1], sorted by index, with coefficients in coefs.
+ **************************************************************************/
+typedef struct ompbatch_result
+{
+  long *start;    /* L+1 entries */
+  int *ind;
+  float *coefs;
+} ompbatch_result;
+
+
+
+/**************************************************************************
+ * Perform Batch-OMP on a set of signals, using either a fixed number of
+ * atoms or an error bound.
+ *
+ * Parameters:
+ *
+ *   DtX - D'*x, of size m X L
+ *   XtX - squared norms of the signals, of length L (error-omp only)
+ *   G - D'*D, of size m X m
+ *   n - length of the signals, at most n independent atoms can be selected
+ *   T - target sparsity, or maximal number of atoms for error-based OMP
+ *       (non-positive or larger than min(m,n): no limit)
+ *   eps - target residual norm for error-based OMP
+ *   erroromp - if nonzero indicates error-based OMP, otherwise fixed sparsity OMP
+ *   threads - number of threads, non-positive: as many as available
+ *   result - output representations, allocated by ompbatch() and released
+ *            with ompbatch_free(). Only the atoms actually selected are
+ *            stored.
+ *
+ * Returns:
+ *   The total number of atoms selected, or -1 if memory ran out (result
+ *   is then left empty).
+ *
+ **************************************************************************/
+long ompbatch(const float DtX[], const float XtX[], const float G[], int n, int m, int L,
+              int T, float eps, int erroromp, int threads, ompbatch_result *result);
+
+
+
+/**************************************************************************
+ * Release the arrays of an ompbatch_result.
+ **************************************************************************/
+void ompbatch_free(ompbatch_result *result);
+
+
+
+/**************************************************************************
+ * Maximal number of atoms per signal for the given T: T limited to
+ * min(m,n).
+ **************************************************************************/
+int ompbatch_atoms(int T, int m, int n);
+
+
+
+/**************************************************************************
+ * Working arrays of one thread, for coding signals one at a time from
+ * inside a caller's own parallel region: no threads are started and no
+ * memory is allocated per signal. An arena must not be shared between
+ * threads.
+ **************************************************************************/
+typedef struct ompbatch_arena ompbatch_arena;
+
+
+
+/**************************************************************************
+ * Allocate an arena for signals of length n, a dictionary of m atoms and
+ * target sparsity (or maximal number of atoms) T, limited as in
+ * ompbatch_atoms(). Returns null if memory ran out.
+ **************************************************************************/
+ompbatch_arena* ompbatch_arena_alloc(int n, int m, int T);
+
+
+
+/**************************************************************************
+ * Release an arena allocated with ompbatch_arena_alloc() (may be null).
+ **************************************************************************/
+void ompbatch_arena_free(ompbatch_arena *arena);
+
+
+
+/**************************************************************************
+ * Perform OMP on a single signal, on the calling thread.
+ *
+ * Parameters:
+ *   arena - working arrays from ompbatch_arena_alloc()
+ *   D - the dictionary, of size n X m
+ *   x - the signal, of length n
+ *   G - D'*D, of size m X m
+ *   eps, erroromp - as in ompbatch()
+ *   ind, coefs - output atoms sorted by index and their coefficients,
+ *                with room for ompbatch_atoms(T,m,n) entries
+ *
+ * Returns:
+ *   The number of atoms selected.
+ *
+ **************************************************************************/
+int ompbatch_signal(ompbatch_arena *arena, const float D[], const float x[], const float G[],
+                    float eps, int erroromp, int ind[], float coefs[]);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,98 @@
+#include "StdAfx.h"
+#include "ClusterEnergyFunction.h"
+
+int dataFunctionCluster(int node, int label, void* extraData)
+{
+	ForDataCluster* data = (ForDataCluster*) extraData;
+	vector<CvPoint*>* points = data->clusterMap->GetPixels(node)->points;
+	CvSize outputSize = data->pixelData->outputSize;
+
+	int energy = 0;
+	for(int i = 0; i < (int)points->size(); i++)
+	{
+		int pixel = GetLabel(*(*points)[i], outputSize);
+		int cost = dataFunctionShiftmap(pixel, label, data->pixelData);
+		// mapped outside
+		if(cost >= 100000)
+			return CLUSTER_MAX_COST;
+		energy += cost;
+	}
+	return MIN(energy, CLUSTER_MAX_COST);
+}
+
+int smoothFunctionCluster(int node1, int node2, int label1, int label2, void* extraData)
+{
+	// same shift on both sides, the border is not seen
+	if(label1 == label2)
+		return 0;
+
+	ForSmoothCluster* data = (ForSmoothCluster*) extraData;
+	vector<PointPair*>* pairs = data->clusterMap->_neighborMap->GetNeighbors(node1, node2).relationShip;
+	CvSize outputSize = data->pixelSmooth->outputSize;
+
+	int energy = 0;
+	for(int i = 0; i < (int)pairs->size(); i++)
+	{
+		PointPair* pointPair = (*pairs)[i];
+		int cost = smoothFunctionShiftmap(GetLabel(pointPair->point1, outputSize), GetLabel(pointPair->point2, outputSize), 
+			label1, label2, data->pixelSmooth);
+		if(cost >= 100000)
+			return CLUSTER_MAX_COST;
+		energy += cost;
+	}
+	return MIN(energy, CLUSTER_MAX_COST);
+}
+
+int dataFunctionClusterRefine(int node, int label, void* extraData)
+{
+	ForDataClusterRefine* data = (ForDataClusterRefine*) extraData;
+	CvPoint point = (*(data->pointMapping))[node];
+	CvSize outputSize = data->pixelData->outputSize;
+	CvSize shiftSize = data->pixelData->shiftSize;
+
+	CvPoint guess = GetLabel(point, data->guess);
+	CvPoint shift = GetShift(label, data->refineSize);
+	int shiftLabel = GetShiftLabel(cvPoint(guess.x + shift.x, guess.y + shift.y), shiftSize);
+	if(shiftLabel < 0)
+		return CLUSTER_MAX_COST;
+
+	int pixel = GetLabel(point, outputSize);
+	int energy = dataFunctionShiftmap(pixel, shiftLabel, data->pixelData);
+
+	// smooth cost with the neighbors which are not refined
+	CvPoint neighbors[4] = {cvPoint(point.x - 1, point.y), cvPoint(point.x + 1, point.y),
+		cvPoint(point.x, point.y - 1), cvPoint(point.x, point.y + 1)};
+	for(int k = 0; k < 4; k++)
+	{
+		if(IsOutside(neighbors[k], outputSize))
+			continue;
+		int neighborPixel = GetLabel(neighbors[k], outputSize);
+		if(data->refineMapping[neighborPixel] >= 0)
+			continue;
+		int neighborLabel = GetShiftLabel(GetLabel(neighbors[k], data->guess), shiftSize);
+		energy += smoothFunctionShiftmap(pixel, neighborPixel, shiftLabel, neighborLabel, data->pixelSmooth);
+	}
+	return MIN(energy, CLUSTER_MAX_COST);
+}
+
+int smoothFunctionClusterRefine(int node1, int node2, int label1, int label2, void* extraData)
+{
+	ForSmoothClusterRefine* data = (ForSmoothClusterRefine*) extraData;
+	CvPoint point1 = (*(data->pointMapping))[node1];
+	CvPoint point2 = (*(data->pointMapping))[node2];
+	CvSize outputSize = data->pixelSmooth->outputSize;
+	CvSize shiftSize = data->pixelSmooth->shiftSize;
+
+	CvPoint guess1 = GetLabel(point1, data->guess);
+	CvPoint guess2 = GetLabel(point2, data->guess);
+	CvPoint shift1 = GetShift(label1, data->refineSize);
+	CvPoint shift2 = GetShift(label2, data->refineSize);
+	int shiftLabel1 = GetShiftLabel(cvPoint(guess1.x + shift1.x, guess1.y + shift1.y), shiftSize);
+	int shiftLabel2 = GetShiftLabel(cvPoint(guess2.x + shift2.x, guess2.y + shift2.y), shiftSize);
+	if(shiftLabel1 < 0 || shiftLabel2 < 0)
+		return CLUSTER_MAX_COST;
+
+	int energy = smoothFunctionShiftmap(GetLabel(point1, outputSize), GetLabel(point2, outputSize), 
+		shiftLabel1, shiftLabel2, data->pixelSmooth);
+	return MIN(energy, CLUSTER_MAX_COST);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cv.h>
+#include <vector>
+using namespace std;
+
+#include "Label.h"
+#include "EnergyFunction.h"
+#include "ClusterMap.h"
+
+// cost of a label which does not fit a node, kept low enough that the
+// energy of the whole graph does not overflow
+#define CLUSTER_MAX_COST 1000000
+
+// a cluster takes one shift for all of its pixels
+struct ForDataCluster
+{
+	ClusterMap* clusterMap;
+	ForDataFunction* pixelData;
+};
+
+struct ForSmoothCluster
+{
+	ClusterMap* clusterMap;
+	ForSmoothFunction* pixelSmooth;
+};
+
+// pixel level refinement of a cluster solution
+// labels are shifts of refineSize around the shift in guess
+struct ForDataClusterRefine
+{
+	vector<CvPoint>* pointMapping;
+	// node of each output pixel, -1 if the pixel keeps its guess
+	int* refineMapping;
+	CvMat* guess;
+	CvSize refineSize;
+	ForDataFunction* pixelData;
+	ForSmoothFunction* pixelSmooth;
+};
+
+struct ForSmoothClusterRefine
+{
+	vector<CvPoint>* pointMapping;
+	CvMat* guess;
+	CvSize refineSize;
+	ForSmoothFunction* pixelSmooth;
+};
+
+// sum of the data costs of the pixels of a cluster
+int dataFunctionCluster(int node, int label, void* extraData);
+// sum of the smooth costs of the pixel pairs along the border of 2 clusters
+int smoothFunctionCluster(int node1, int node2, int label1, int label2, void* extraData);
+
+// data cost of a pixel, with the smooth cost to its neighbors which keep their guess
+int dataFunctionClusterRefine(int node, int label, void* extraData);
+int smoothFunctionClusterRefine(int node1, int node2, int label1, int label2, void* extraData);
@@ -1,14 +1,32 @@
 #include "stdafx.h"
 #include "ClusterMap.h"
 #include "Label.h"
+#include <float.h>
 
 // this file implement cluster map algorithm
 ClusterMap::ClusterMap()
 {
+	_neighborMap = NULL;
+	_nodeMapping = NULL;
+	_pixelMapping = NULL;
 }
 
 ClusterMap::~ClusterMap()
 {
+	if(_pixelMapping != NULL)
+	{
+		for(int i = 0; i < (int)_pixelMapping->size(); i++)
+		{
+			vector<CvPoint*>* points = (*_pixelMapping)[i]->points;
+			for(int j = 0; j < (int)points->size(); j++)
+				delete (*points)[j];
+			delete points;
+			delete (*_pixelMapping)[i];
+		}
+		delete _pixelMapping;
+	}
+	delete[] _nodeMapping;
+	delete _neighborMap;
 }
 
 
@@ -41,6 +59,8 @@ int ClusterMap::CheckClusterNeighbor(int* mapping, int currentLabel, CvPoint nei
 void ClusterMap::CreateClusterOutputMap(IplImage* mask)
 {
 	int index = 0;
+	_width = mask->width;
+	_height = mask->height;
 	_labelCount = mask->width * mask->height;
 	_nodeMapping = new int[_labelCount];
 	_pixelMapping = new vector<PixelList*>();
@@ -99,7 +119,6 @@ void ClusterMap::CreateClusterOutputMap(IplImage* mask)
 void ClusterMap::AssignNeighborHood(int* mapping, CvSize imageSize, int numLabel, GCoptimizationGeneralGraph * gc)
 {
 	int totalPixel = imageSize.width * imageSize.height;
-	vector<PointPair*>* neighborhood = new vector<PointPair*>(totalPixel);
 	_neighborMap = new ClusterMapNeighbor(NodeCount());
 	for(int i = 0; i < totalPixel; i++)
 	{
@@ -138,4 +157,195 @@ int ClusterMap::GetMapping(int pixelId)
 int ClusterMap::NodeCount()
 {
 	return _pixelMapping->size();
-}
\ No newline at end of file
+}
+
+PixelList* ClusterMap::GetPixels(int nodeId)
+{
+	return (*_pixelMapping)[nodeId];
+}
+
+int ClusterMap::AddNode(vector<CvPoint*>* points)
+{
+	int nodeId = _pixelMapping->size();
+	PixelList* list = new PixelList();
+	list->points = points;
+	_pixelMapping->push_back(list);
+	for(int i = 0; i < (int)points->size(); i++)
+		_nodeMapping[GetLabel(*(*points)[i], cvSize(_width, _height))] = nodeId;
+	return nodeId;
+}
+
+void ClusterMap::CreateSuperpixelMap(IplImage* image, IplImage* mask, int regionSize, double compactness)
+{
+	_width = image->width;
+	_height = image->height;
+	CvSize imageSize = cvSize(_width, _height);
+	_labelCount = _width * _height;
+	_nodeMapping = new int[_labelCount];
+	_pixelMapping = new vector<PixelList*>();
+
+	IplImage* lab = cvCreateImage(imageSize, IPL_DEPTH_8U, 3);
+	cvCvtColor(image, lab, CV_BGR2Lab);
+	bool* clustered = new bool[_labelCount];
+	for(int j = 0; j < _height; j++)
+		for(int i = 0; i < _width; i++)
+		{
+			CvScalar value = cvGet2D(mask, j, i);
+			clustered[j * _width + i] = value.val[0] < 100;
+			_nodeMapping[j * _width + i] = -1;
+		}
+
+	// seeds on a regular grid: l, a, b, x, y
+	int step = regionSize;
+	vector<double> centers;
+	for(int y = step / 2; y < _height; y += step)
+		for(int x = step / 2; x < _width; x += step)
+		{
+			unsigned char* pixel = (unsigned char*)(lab->imageData + y * lab->widthStep) + x * 3;
+			centers.push_back(pixel[0]);
+			centers.push_back(pixel[1]);
+			centers.push_back(pixel[2]);
+			centers.push_back(x);
+			centers.push_back(y);
+		}
+	int seedCount = centers.size() / 5;
+
+	int* seedMapping = new int[_labelCount];
+	double* distance = new double[_labelCount];
+	double spatialWeight = (compactness / step) * (compactness / step);
+	for(int iteration = 0; iteration < 5; iteration++)
+	{
+		for(int i = 0; i < _labelCount; i++)
+		{
+			seedMapping[i] = -1;
+			distance[i] = DBL_MAX;
+		}
+
+		// each seed only searches a 2 step x 2 step window around it
+		for(int s = 0; s < seedCount; s++)
+		{
+			double* center = &centers[s * 5];
+			int left = MAX((int)center[3] - step, 0);
+			int right = MIN((int)center[3] + step, _width - 1);
+			int top = MAX((int)center[4] - step, 0);
+			int bottom = MIN((int)center[4] + step, _height - 1);
+			for(int y = top; y <= bottom; y++)
+			{
+				unsigned char* row = (unsigned char*)(lab->imageData + y * lab->widthStep);
+				for(int x = left; x <= right; x++)
+				{
+					int id = y * _width + x;
+					if(!clustered[id])
+						continue;
+					unsigned char* pixel = row + x * 3;
+					double dl = pixel[0] - center[0];
+					double da = pixel[1] - center[1];
+					double db = pixel[2] - center[2];
+					double dx = x - center[3];
+					double dy = y - center[4];
+					double d = dl * dl + da * da + db * db + spatialWeight * (dx * dx + dy * dy);
+					if(d < distance[id])
+					{
+						distance[id] = d;
+						seedMapping[id] = s;
+					}
+				}
+			}
+		}
+
+		// move the seeds to the mean of their pixels
+		vector<double> sums(seedCount * 6, 0);
+		for(int y = 0; y < _height; y++)
+		{
+			unsigned char* row = (unsigned char*)(lab->imageData + y * lab->widthStep);
+			for(int x = 0; x < _width; x++)
+			{
+				int s = seedMapping[y * _width + x];
+				if(s < 0)
+					continue;
+				unsigned char* pixel = row + x * 3;
+				double* sum = &sums[s * 6];
+				sum[0] += pixel[0];
+				sum[1] += pixel[1];
+				sum[2] += pixel[2];
+				sum[3] += x;
+				sum[4] += y;
+				sum[5] += 1;
+			}
+		}
+		for(int s = 0; s < seedCount; s++)
+		{
+			double* sum = &sums[s * 6];
+			if(sum[5] > 0)
+				for(int k = 0; k < 5; k++)
+					centers[s * 5 + k] = sum[k] / sum[5];
+		}
+	}
+	delete[] distance;
+	cvReleaseImage(&lab);
+
+	// a superpixel may be split, every connected part becomes a node.
+	// Small parts are merged into a cluster next to them
+	int minSize = MAX(step * step / 8, 1);
+	vector<CvPoint> stack;
+	for(int j = 0; j < _height; j++)
+		for(int i = 0; i < _width; i++)
+		{
+			int id = j * _width + i;
+			if(_nodeMapping[id] != -1)
+				continue;
+
+			vector<CvPoint*>* points = new vector<CvPoint*>();
+			if(!clustered[id] || seedMapping[id] < 0)
+			{
+				points->push_back(CreateCvPoint(i, j));
+				AddNode(points);
+				continue;
+			}
+
+			// flood fill the part, marked -2 while it is collected
+			int seed = seedMapping[id];
+			int adjacent = -1;
+			stack.push_back(cvPoint(i, j));
+			_nodeMapping[id] = -2;
+			while(!stack.empty())
+			{
+				CvPoint point = stack.back();
+				stack.pop_back();
+				points->push_back(CreateCvPoint(point.x, point.y));
+
+				CvPoint neighbors[4] = {cvPoint(point.x - 1, point.y), cvPoint(point.x + 1, point.y),
+					cvPoint(point.x, point.y - 1), cvPoint(point.x, point.y + 1)};
+				for(int k = 0; k < 4; k++)
+				{
+					if(IsOutside(neighbors[k], imageSize))
+						continue;
+					int neighborId = GetLabel(neighbors[k], imageSize);
+					if(_nodeMapping[neighborId] == -1 && clustered[neighborId] && seedMapping[neighborId] == seed)
+					{
+						_nodeMapping[neighborId] = -2;
+						stack.push_back(neighbors[k]);
+					}
+					else
+					if(_nodeMapping[neighborId] >= 0 && clustered[neighborId])
+						adjacent = _nodeMapping[neighborId];
+				}
+			}
+
+			if((int)points->size() < minSize && adjacent >= 0)
+			{
+				vector<CvPoint*>* adjacentPoints = (*_pixelMapping)[adjacent]->points;
+				for(int k = 0; k < (int)points->size(); k++)
+				{
+					adjacentPoints->push_back((*points)[k]);
+					_nodeMapping[GetLabel(*(*points)[k], imageSize)] = adjacent;
+				}
+				delete points;
+			}
+			else
+				AddNode(points);
+		}
+
+	delete[] seedMapping;
+	delete[] clustered;
+}
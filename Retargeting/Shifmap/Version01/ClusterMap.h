@@ -18,8 +18,15 @@ public:
 
 	int GetMapping(int pixelId);
 	void CreateClusterOutputMap(IplImage* mask);
+	// over-segment the grid into superpixels (SLIC, Achanta et al. 2010)
+	// image: color of the grid, used for clustering
+	// mask: white pixels stay single nodes, the others are clustered
+	// regionSize: grid step of the seeds
+	// compactness: weight of the distance in position against distance in color
+	void CreateSuperpixelMap(IplImage* image, IplImage* mask, int regionSize, double compactness);
 	void AssignNeighborHood(int* mapping, CvSize imageSize, int numLabel, GCoptimizationGeneralGraph * gc);
 	int NodeCount();
+	PixelList* GetPixels(int nodeId);
 	// neighborhood:
 	// vectors of pairs of vectors?
 public:
@@ -29,6 +36,8 @@ protected:
 	
 	vector<PixelList*>* _pixelMapping;
 	int _labelCount;
+	int _width;
+	int _height;
 protected:
 	// flexible neighborhood system
 	// building the cluster map
@@ -37,6 +46,8 @@ protected:
 	// return cluster index
 	int AssignToCluster(int* mapping, CvPoint point, CvSize imageSize);
 	int CheckClusterNeighbor(int* mapping, int currentLabel, CvPoint neighbor, CvSize imageSize);
+	// new node with the given points
+	int AddNode(vector<CvPoint*>* points);
 	
 	void SetNeighborPointPair(int* mapping, CvSize imageSize, int nodeId1, CvPoint currentPoint, CvPoint neighbor, ClusterMapNeighbor* neighborMap);
 	
@@ -3,38 +3,53 @@
 
 ClusterMapNeighbor::ClusterMapNeighbor(int nodeCount)
 {
-	// int relationCount = nodeCount * (nodeCount - 1);
-	int relationCount = nodeCount * nodeCount;
+	// a node only touches a few others, a nodeCount x nodeCount table
+	// does not fit for superpixel maps
 	_nodeCount = nodeCount;
-	_neighborhoodList = new NeighborhoodList[relationCount];	
-	for(int i = 0; i < relationCount; i++)
-	{
-		_neighborhoodList[i].relationShip = new vector<PointPair*>();
-	}
+	_neighborhoodList = new map<int, NeighborhoodList>[nodeCount];
+	_empty = new vector<PointPair*>();
 }
 
 ClusterMapNeighbor::~ClusterMapNeighbor(void)
 {
+	for(int i = 0; i < _nodeCount; i++)
+	{
+		map<int, NeighborhoodList>::iterator it;
+		for(it = _neighborhoodList[i].begin(); it != _neighborhoodList[i].end(); it++)
+		{
+			vector<PointPair*>* pairs = it->second.relationShip;
+			for(int j = 0; j < (int)pairs->size(); j++)
+				delete (*pairs)[j];
+			delete pairs;
+		}
+	}
+	delete[] _neighborhoodList;
+	delete _empty;
 }
 
 void ClusterMapNeighbor::AddNeighbor(int nodeId1, int nodeId2, PointPair* pointPair)
 {
-	NeighborhoodList list;
-	//if(nodeId1 > nodeId2)
-	//	list = _neighborhoodList[(nodeId1) * (nodeId1 - 1) + nodeId2];
-	//else
-	//	list = _neighborhoodList[(nodeId2) * (nodeId2 - 1) + nodeId1];
-	list = _neighborhoodList[nodeId1 * _nodeCount + nodeId2];
- 	list.relationShip->push_back(pointPair);
- 
- 
+	map<int, NeighborhoodList>::iterator found = _neighborhoodList[nodeId1].find(nodeId2);
+	if(found == _neighborhoodList[nodeId1].end())
+	{
+		NeighborhoodList list;
+		list.relationShip = new vector<PointPair*>();
+		found = _neighborhoodList[nodeId1].insert(pair<int, NeighborhoodList>(nodeId2, list)).first;
+	}
+ 	found->second.relationShip->push_back(pointPair);
 }
 
 NeighborhoodList ClusterMapNeighbor::GetNeighbors(int nodeId1, int nodeId2)
 {
-	//if(nodeId1 > nodeId2)
-	//	return _neighborhoodList[(nodeId1 - 1) * (nodeId1 - 2) + nodeId2];
-	//else
-	//	return _neighborhoodList[(nodeId2 - 1) * (nodeId2 - 2) + nodeId1];
-	return _neighborhoodList[nodeId1 * _nodeCount + nodeId2];
+	map<int, NeighborhoodList>::iterator found = _neighborhoodList[nodeId1].find(nodeId2);
+	if(found != _neighborhoodList[nodeId1].end())
+		return found->second;
+	NeighborhoodList list;
+	list.relationShip = _empty;
+	return list;
+}
+
+map<int, NeighborhoodList>* ClusterMapNeighbor::GetNeighborList(int nodeId)
+{
+	return &_neighborhoodList[nodeId];
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <cv.h>
 #include <vector>
+#include <map>
 using namespace std;
 
 struct PointPair
@@ -22,8 +23,13 @@ public:
 	~ClusterMapNeighbor(void);
 
 	void AddNeighbor(int nodeId1, int nodeId2, PointPair* pointPair);
+	// point pairs with point1 in nodeId1 and point2 in nodeId2
 	NeighborhoodList GetNeighbors(int nodeId1, int nodeId2);
+	// all neighbors of a node, by node id
+	map<int, NeighborhoodList>* GetNeighborList(int nodeId);
 protected:
-	NeighborhoodList* _neighborhoodList;	
+	// one map per node, only neighboring nodes have an entry
+	map<int, NeighborhoodList>* _neighborhoodList;	
 	int _nodeCount;
+	vector<PointPair*>* _empty;
 };
@@ -3,41 +3,262 @@
 
 ClusterShiftMap::ClusterShiftMap(void)
 {
+	_gcGeneral = NULL;
+	_labelMap = NULL;
+	_regionSize = 10;
+	_compactness = 10;
+	_salientThreshold = 100;
+	_refineRadius = 1;
 }
 
 ClusterShiftMap::~ClusterShiftMap(void)
 {
+	if(_labelMap != NULL)
+		cvReleaseMat(&_labelMap);
+}
+
+void ClusterShiftMap::SetRegionSize(int regionSize)
+{
+	_regionSize = regionSize;
+}
+
+void ClusterShiftMap::SetSalientThreshold(int threshold)
+{
+	_salientThreshold = threshold;
+}
+
+void ClusterShiftMap::SetRefineRadius(int radius)
+{
+	_refineRadius = radius;
+}
+
+void ClusterShiftMap::ComputeShiftMap(IplImage* input, IplImage* saliency, CvSize output, CvSize shiftSize)
+{
+	// the output is not known yet, cluster on the input squeezed to the output size
+	IplImage* mask = CreateMask(saliency, output);
+	IplImage* image = cvCreateImage(output, input->depth, input->nChannels);
+	cvResize(input, image);
+
+	ClusterMap* clusterMap = new ClusterMap();
+	clusterMap->CreateSuperpixelMap(image, mask, _regionSize, _compactness);
+	Solve(input, saliency, clusterMap, output, shiftSize);
+
+	delete clusterMap;
+	cvReleaseImage(&image);
+	cvReleaseImage(&mask);
 }
 
 void ClusterShiftMap::ComputeShiftMap(IplImage* input, IplImage* saliency, IplImage* mask, CvSize output, CvSize shiftSize)
 {	
-	//int *data = new int[num_pixels*num_labels];
-	//int *smooth = new int[num_labels*num_labels];
-	// IplImage* mask = CreateMask(saliency, output);
-
 	ClusterMap* clusterMap = new ClusterMap();
 	clusterMap->CreateClusterOutputMap(mask);
-	clusterMap->AssignNeighborHood(clusterMap->_nodeMapping, cvSize(mask->width, mask->height), clusterMap->NodeCount(), _gcGeneral);
+	Solve(input, saliency, clusterMap, output, shiftSize);
+	delete clusterMap;
+}
+
+void ClusterShiftMap::Solve(IplImage* input, IplImage* saliency, ClusterMap* clusterMap, CvSize output, CvSize shiftSize)
+{
+	_inputSize = cvSize(input->width, input->height);
+	_outputSize = output;
+	_shiftSize = shiftSize;
+	_input = input;
+
+	clusterMap->AssignNeighborHood(clusterMap->_nodeMapping, output, clusterMap->NodeCount(), _gcGeneral);
+	printf("%i nodes for %i pixels\n", clusterMap->NodeCount(), output.width * output.height);
+
+	ForDataFunction dataFn;
+	dataFn.inputSize = _inputSize;
+	dataFn.outputSize = _outputSize;
+	dataFn.shiftSize = _shiftSize;
+	dataFn.saliency = saliency;
+
+	ForSmoothFunction smoothFn;
+	smoothFn.inputSize = _inputSize;
+	smoothFn.outputSize = _outputSize;
+	smoothFn.shiftSize = _shiftSize;
+	smoothFn.image = input;
+	smoothFn.gradient = cvCloneImage(input);
+	cvSobel(input, smoothFn.gradient, 1, 1);
+
+	SolveClusters(clusterMap, &dataFn, &smoothFn);
+	RefineShiftMap(clusterMap, &dataFn, &smoothFn);
+
+	cvReleaseImage(&smoothFn.gradient);
+}
+
+void ClusterShiftMap::SolveClusters(ClusterMap* clusterMap, ForDataFunction* dataFn, ForSmoothFunction* smoothFn)
+{
 	int nodeCount = clusterMap->NodeCount();
-	_gcGeneral = new GCoptimizationGeneralGraph(nodeCount, output.width * output.height);
-	
-	// now set up a neighborhood system according to clustermap
+	try{
+		_gcGeneral = new GCoptimizationGeneralGraph(nodeCount, _shiftSize.width * _shiftSize.height);
+		
+		// now set up a neighborhood system according to clustermap
+		for(int i = 0; i < nodeCount; i++)
+		{
+			map<int, NeighborhoodList>* neighbors = clusterMap->_neighborMap->GetNeighborList(i);
+			map<int, NeighborhoodList>::iterator it;
+			for(it = neighbors->begin(); it != neighbors->end(); it++)
+				if(it->first > i)
+					_gcGeneral->setNeighbors(i, it->first);
+		}
+
+		// now set up data cost and energy cost
+		ForDataCluster dataCost;
+		dataCost.clusterMap = clusterMap;
+		dataCost.pixelData = dataFn;
+		_gcGeneral->setDataCost(&dataFunctionCluster, &dataCost);
+
+		ForSmoothCluster smoothCost;
+		smoothCost.clusterMap = clusterMap;
+		smoothCost.pixelSmooth = smoothFn;
+		_gcGeneral->setSmoothCost(&smoothFunctionCluster, &smoothCost);
+
+		// start from no shift, label 0 maps most clusters outside
+		int zeroLabel = GetShiftLabel(cvPoint(0, 0), _shiftSize);
+		for(int i = 0; i < nodeCount; i++)
+			_gcGeneral->setLabel(i, zeroLabel);
+
+		printf("\nBefore optimization energy is %d \n", _gcGeneral->compute_energy());
+		_gcGeneral->expansion(2);
+		printf("\nAfter optimization energy is %d \n", _gcGeneral->compute_energy()); 
+	}
+	catch (GCException e){
+		e.Report();
+	}
+
+	if(_labelMap != NULL)
+		cvReleaseMat(&_labelMap);
+	_labelMap = cvCreateMat(_outputSize.height, _outputSize.width, CV_32SC2);
 	for(int i = 0; i < nodeCount; i++)
-		for(int j = 0; j < nodeCount; j++)
+	{
+		CvPoint shift = GetShift(_gcGeneral->whatLabel(i), _shiftSize);
+		vector<CvPoint*>* points = clusterMap->GetPixels(i)->points;
+		for(int j = 0; j < (int)points->size(); j++)
+			SetLabel(*(*points)[j], shift, _labelMap);
+	}
+	delete _gcGeneral;
+	_gcGeneral = NULL;
+}
+
+void ClusterShiftMap::RefineShiftMap(ClusterMap* clusterMap, ForDataFunction* dataFn, ForSmoothFunction* smoothFn)
+{
+	int pixelCount = _outputSize.width * _outputSize.height;
+	int* refineMapping = new int[pixelCount];
+	vector<CvPoint>* pointMapping = new vector<CvPoint>();
+	for(int j = 0; j < _outputSize.height; j++)
+		for(int i = 0; i < _outputSize.width; i++)
 		{
-			NeighborhoodList list = clusterMap->_neighborMap->GetNeighbors(i, j);
-			if(list.relationShip->size() != 0)
+			int pixel = j * _outputSize.width + i;
+			int node = clusterMap->GetMapping(pixel);
+			bool refine = clusterMap->GetPixels(node)->points->size() == 1;
+
+			CvPoint shift = GetLabel(cvPoint(i, j), _labelMap);
+			CvPoint neighbors[4] = {cvPoint(i - 1, j), cvPoint(i + 1, j), cvPoint(i, j - 1), cvPoint(i, j + 1)};
+			for(int k = 0; k < 4 && !refine; k++)
+			{
+				if(IsOutside(neighbors[k], _outputSize))
+					continue;
+				int neighborNode = clusterMap->GetMapping(GetLabel(neighbors[k], _outputSize));
+				CvPoint neighborShift = GetLabel(neighbors[k], _labelMap);
+				if(neighborNode != node && (neighborShift.x != shift.x || neighborShift.y != shift.y))
+					refine = true;
+			}
+
+			if(refine)
 			{
-				_gcGeneral->setNeighbors(i,j);
+				refineMapping[pixel] = pointMapping->size();
+				pointMapping->push_back(cvPoint(i, j));
 			}
+			else
+				refineMapping[pixel] = -1;
 		}
 
-	// now set up data cost and energy cost
+	int nodeCount = pointMapping->size();
+	printf("refining %i pixels\n", nodeCount);
+	if(nodeCount > 0 && _refineRadius > 0)
+	{
+		CvSize refineSize = cvSize(_refineRadius * 2 + 1, _refineRadius * 2 + 1);
+		try{
+			GCoptimizationGeneralGraph* gc = new GCoptimizationGeneralGraph(nodeCount, refineSize.width * refineSize.height);
+			for(int n = 0; n < nodeCount; n++)
+			{
+				// setup neighbors to the right and down only
+				CvPoint point = (*pointMapping)[n];
+				if(point.x + 1 < _outputSize.width && refineMapping[point.y * _outputSize.width + point.x + 1] >= 0)
+					gc->setNeighbors(n, refineMapping[point.y * _outputSize.width + point.x + 1]);
+				if(point.y + 1 < _outputSize.height && refineMapping[(point.y + 1) * _outputSize.width + point.x] >= 0)
+					gc->setNeighbors(n, refineMapping[(point.y + 1) * _outputSize.width + point.x]);
+			}
+
+			ForDataClusterRefine dataCost;
+			dataCost.pointMapping = pointMapping;
+			dataCost.refineMapping = refineMapping;
+			dataCost.guess = _labelMap;
+			dataCost.refineSize = refineSize;
+			dataCost.pixelData = dataFn;
+			dataCost.pixelSmooth = smoothFn;
+			gc->setDataCost(&dataFunctionClusterRefine, &dataCost);
+
+			ForSmoothClusterRefine smoothCost;
+			smoothCost.pointMapping = pointMapping;
+			smoothCost.guess = _labelMap;
+			smoothCost.refineSize = refineSize;
+			smoothCost.pixelSmooth = smoothFn;
+			gc->setSmoothCost(&smoothFunctionClusterRefine, &smoothCost);
+
+			int zeroLabel = GetShiftLabel(cvPoint(0, 0), refineSize);
+			for(int n = 0; n < nodeCount; n++)
+				gc->setLabel(n, zeroLabel);
+
+			printf("\nBefore optimization energy is %d \n", gc->compute_energy());
+			gc->expansion(2);
+			printf("\nAfter optimization energy is %d \n", gc->compute_energy()); 
+
+			// the costs read the guess, write back only when done
+			for(int n = 0; n < nodeCount; n++)
+			{
+				CvPoint point = (*pointMapping)[n];
+				CvPoint guess = GetLabel(point, _labelMap);
+				CvPoint shift = GetShift(gc->whatLabel(n), refineSize);
+				SetLabel(point, cvPoint(guess.x + shift.x, guess.y + shift.y), _labelMap);
+			}
+			delete gc;
+		}
+		catch (GCException e){
+			e.Report();
+		}
+	}
+
+	delete pointMapping;
+	delete[] refineMapping;
+}
+
+IplImage* ClusterShiftMap::CalculateRetargetImage()
+{
+	return GetImageFromLabelMap(_labelMap, _input);
+}
+
+CvMat* ClusterShiftMap::GetLabelMap()
+{
+	return _labelMap;
 }
 
 IplImage* ClusterShiftMap::CreateMask(IplImage* saliency, CvSize output)
 {
-	IplImage* mask = cvCreateImage(output, saliency->depth, saliency->nChannels);
-	// from saliency create mask
+	IplImage* resized = cvCreateImage(output, saliency->depth, saliency->nChannels);
+	cvResize(saliency, resized);
+
+	// from saliency create mask: white for salient pixels, which stay single nodes
+	IplImage* mask = cvCreateImage(output, IPL_DEPTH_8U, 1);
+	for(int i = 0; i < output.width; i++)
+		for(int j = 0; j < output.height; j++)
+		{
+			CvScalar value = cvGet2D(resized, j, i);
+			if(value.val[0] < _salientThreshold)
+				cvSet2D(mask, j, i, cvScalar(255));
+			else
+				cvSet2D(mask, j, i, cvScalar(0));
+		}
+	cvReleaseImage(&resized);
 	return mask;
-}
\ No newline at end of file
+}
@@ -1,21 +1,49 @@
 #pragma once
 #include "ShiftMap.h"
 #include "ClusterMap.h"
+#include "ClusterEnergyFunction.h"
 #include "Label.h"
 #include <vector>
 
+// shift-map on a reduced graph: the output grid is grouped into clusters
+// which take one shift each, then pixels along the borders of the clusters
+// and single pixel nodes are solved again around that shift
 class ClusterShiftMap : public ShiftMap
 {
 public:
 	ClusterShiftMap(void);
 	~ClusterShiftMap(void);
 
+	// superpixel mode: regions of low saliency are over-segmented into
+	// superpixels, salient pixels stay single nodes
+	virtual void ComputeShiftMap(IplImage* input, IplImage* saliency, CvSize output, CvSize shiftSize);	
+	// clusters given by a mask of the output size, see ClusterMap::CreateClusterOutputMap
 	virtual void ComputeShiftMap(IplImage* input, IplImage* saliency, IplImage* mask, CvSize output, CvSize shiftSize);	
+	virtual IplImage* CalculateRetargetImage();
+	CvMat* GetLabelMap();
+
+	// grid step of the superpixels
+	void SetRegionSize(int regionSize);
+	// pixels with a saliency cost below this stay single nodes
+	void SetSalientThreshold(int threshold);
+	// refined pixels search shifts within this radius of the cluster shift
+	void SetRefineRadius(int radius);
 	
 public:
 	// scan saliency map to produce a cluster output map
 	// which is used as the graph for the GCOptimization
 protected:
+	// saliency is the cost map given to the data term, so salient pixels have low values
 	IplImage* CreateMask(IplImage* saliency, CvSize output);
+	void Solve(IplImage* input, IplImage* saliency, ClusterMap* clusterMap, CvSize output, CvSize shiftSize);
+	// one label per cluster, sets _labelMap for every output pixel
+	void SolveClusters(ClusterMap* clusterMap, ForDataFunction* dataFn, ForSmoothFunction* smoothFn);
+	// pixel level, along cluster borders where the shift changes and for single pixel nodes
+	void RefineShiftMap(ClusterMap* clusterMap, ForDataFunction* dataFn, ForSmoothFunction* smoothFn);
 	GCoptimizationGeneralGraph* _gcGeneral;
+	CvMat* _labelMap;
+	int _regionSize;
+	double _compactness;
+	int _salientThreshold;
+	int _refineRadius;
 };
@@ -1,3 +1,15 @@
 #include "StdAfx.h"
 #include "EnergyFunctionFeedback.h"
- 
\ No newline at end of file
+
+int dataFunctionFeedback(int pixel, int label, void *extraData)
+{
+	ForDataFunctionFeedback* data = (ForDataFunctionFeedback*) extraData;
+
+	CvPoint origin = GetMappedPoint(pixel, label, data->outputSize, data->shiftSize);
+	if(IsOutside(origin, data->inputSize)) 
+		return 100000;
+
+	CvScalar value = cvGet2D(data->saliency, origin.y, origin.x);
+	int saliency = value.val[0] + value.val[1] + value.val[2];
+	return saliency + CV_MAT_ELEM(*(data->feedbackCost), int, origin.y, origin.x);
+}
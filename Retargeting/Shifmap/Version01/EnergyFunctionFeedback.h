@@ -1,3 +1,19 @@
 #pragma once
+#include <cv.h>
+#include "Label.h"
+#include "EnergyFunction.h"
 
- 
\ No newline at end of file
+// shift-map data term with a feedback cost on the input, which is updated
+// from the labeling of the previous round
+struct ForDataFunctionFeedback
+{
+	CvSize outputSize;
+	CvSize shiftSize;
+	CvSize inputSize;
+	IplImage* saliency;
+	// cost of using each input pixel, CV_32SC1 of the input size
+	CvMat* feedbackCost;
+};
+
+// same as dataFunctionShiftmap plus the feedback cost of the source pixel
+int dataFunctionFeedback(int pixel, int label, void *extraData);
@@ -3,31 +3,104 @@
 
 FeedbackRetargeting::FeedbackRetargeting(void)
 {
+	_gc = NULL;
+	_feedbackCost = NULL;
+	_useCount = NULL;
+	_maxRound = 10;
+	_energyThreshold = 0.001;
+	_feedbackWeight = 50;
+	_roundCount = 0;
 }
 
 FeedbackRetargeting::~FeedbackRetargeting(void)
 {
+	if(_gc != NULL)
+		delete _gc;
+	if(_feedbackCost != NULL)
+		cvReleaseMat(&_feedbackCost);
+	if(_useCount != NULL)
+		cvReleaseMat(&_useCount);
+}
+
+void FeedbackRetargeting::SetFeedbackSetting(int maxRound, double energyThreshold, int feedbackWeight)
+{
+	_maxRound = maxRound;
+	_energyThreshold = energyThreshold;
+	_feedbackWeight = feedbackWeight;
+}
+
+int FeedbackRetargeting::GetRoundCount()
+{
+	return _roundCount;
+}
+
+int FeedbackRetargeting::UpdateFeedbackCost()
+{
+	CvMat* useCount = cvCreateMat(_inputSize.height, _inputSize.width, CV_32SC1);
+	cvSetZero(useCount);
+	int num_pixels = _outputSize.width * _outputSize.height;
+	for(int i = 0; i < num_pixels; i++)
+	{
+		CvPoint pointLabel = GetMappedPoint(i, _gc->whatLabel(i), _outputSize, _shiftSize);
+		if(!IsOutside(pointLabel, _inputSize))
+			CV_MAT_ELEM(*useCount, int, pointLabel.y, pointLabel.x)++;
+	}
+
+	// only pixels whose count changed get a new cost
+	int changed = 0;
+	for(int j = 0; j < _inputSize.height; j++)
+		for(int i = 0; i < _inputSize.width; i++)
+		{
+			int count = CV_MAT_ELEM(*useCount, int, j, i);
+			if(count == CV_MAT_ELEM(*_useCount, int, j, i))
+				continue;
+			CV_MAT_ELEM(*_useCount, int, j, i) = count;
+			CV_MAT_ELEM(*_feedbackCost, int, j, i) = count > 1 ? (count - 1) * _feedbackWeight : 0;
+			changed++;
+		}
+	cvReleaseMat(&useCount);
+	return changed;
 }
 
 void FeedbackRetargeting::ComputeShiftMap(IplImage* input, IplImage* saliency, CvSize output, CvSize shiftSize)
 {
 		try{
+		// keep the graph, and so its labeling, when the problem has the same size
+		bool warmStart = _gc != NULL && _inputSize.width == input->width && _inputSize.height == input->height 
+			&& _outputSize.width == output.width && _outputSize.height == output.height
+			&& _shiftSize.width == shiftSize.width && _shiftSize.height == shiftSize.height;
+
 		_inputSize.width = input->width;
 		_inputSize.height = input->height;
 		_outputSize = output;
 		_shiftSize = shiftSize;
 		_input = input; 
 
-		_gc = new GCoptimizationGridGraph(_outputSize.width, _outputSize.height, _shiftSize.width * _shiftSize.height);
+		if(!warmStart)
+		{
+			if(_gc != NULL)
+				delete _gc;
+			_gc = new GCoptimizationGridGraph(_outputSize.width, _outputSize.height, _shiftSize.width * _shiftSize.height);
+
+			if(_feedbackCost != NULL)
+				cvReleaseMat(&_feedbackCost);
+			if(_useCount != NULL)
+				cvReleaseMat(&_useCount);
+			_feedbackCost = cvCreateMat(_inputSize.height, _inputSize.width, CV_32SC1);
+			_useCount = cvCreateMat(_inputSize.height, _inputSize.width, CV_32SC1);
+			cvSetZero(_feedbackCost);
+			cvSetZero(_useCount);
+		}
 
 		// set up the needed data to pass to function for the data costs
-		ForDataFunction dataFn;
+		ForDataFunctionFeedback dataFn;
 		dataFn.inputSize = _inputSize;
 		dataFn.outputSize = _outputSize;
 		dataFn.shiftSize = _shiftSize;
 		dataFn.saliency = saliency;
+		dataFn.feedbackCost = _feedbackCost;
  
-		_gc->setDataCost(&dataFunctionShiftmap,&dataFn);
+		_gc->setDataCost(&dataFunctionFeedback,&dataFn);
 		
 		// smoothness comes from function pointer
 		ForSmoothFunction smoothFn;
@@ -39,17 +112,26 @@ void FeedbackRetargeting::ComputeShiftMap(IplImage* input, IplImage* saliency, C
 		cvSobel(input, smoothFn.gradient, 1, 1);	 
 		_gc->setSmoothCost(&smoothFunctionShiftmap, &smoothFn);
 		
-		printf("\nBefore optimization energy is %d \n", _gc->compute_energy());
-		//gc->swap(20);
-		_gc->expansion(2);// run expansion for 2 iterations. For swap use gc->swap(num_iterations);
-		printf("\nAfter optimization energy is %d \n", _gc->compute_energy()); 
+		int energy = _gc->compute_energy();
+		printf("\nBefore optimization energy is %d \n", energy);
+		for(_roundCount = 0; _roundCount < _maxRound; )
+		{
+			_gc->expansion(1);
+			_roundCount++;
+			int roundEnergy = _gc->compute_energy();
+			printf("Round %i energy is %d \n", _roundCount, roundEnergy);
 
-		//cvNamedWindow("test");
-		//while(1)
-		//{
-		//	cvShowImage("test", dataFn._visited);
-		//	cvWaitKey(100);
-		//}
+			int changed = UpdateFeedbackCost();
+			if(changed == 0 || energy - roundEnergy <= _energyThreshold * energy)
+				break;
+
+			// setting the cost again makes the graph refresh the costs it keeps
+			// for the current labeling, the labeling itself is kept
+			_gc->setDataCost(&dataFunctionFeedback,&dataFn);
+			energy = _gc->compute_energy();
+		}
+		printf("\nAfter optimization energy is %d \n", _gc->compute_energy()); 
+		cvReleaseImage(&smoothFn.gradient);
 	}
 	catch (GCException e){
 		e.Report();
@@ -3,12 +3,33 @@
 #include "EnergyFunctionFeedback.h"
 #include "Shiftmap.h"
 
+// shift-map solved in rounds. After each round the feedback cost of the input
+// is updated from the labeling, and the same graph continues from that labeling
 class FeedbackRetargeting : public ShiftMap
 {
 public:
 	FeedbackRetargeting(void);
 	~FeedbackRetargeting(void);
 	
+	// a graph of the same size is kept from the last call and starts from its labeling
 	virtual void ComputeShiftMap(IplImage* input, IplImage* saliency, CvSize output, CvSize shiftSize);
-
+	// maxRound: most rounds of expansion
+	// energyThreshold: stop when a round lowers the energy by less than this ratio
+	// feedbackWeight: cost of every extra use of an input pixel
+	void SetFeedbackSetting(int maxRound, double energyThreshold, int feedbackWeight);
+	// rounds run by the last ComputeShiftMap
+	int GetRoundCount();
+protected:
+	// cost of using each input pixel, read by dataFunctionFeedback
+	CvMat* _feedbackCost;
+	// how many output pixels use each input pixel
+	CvMat* _useCount;
+	int _maxRound;
+	double _energyThreshold;
+	int _feedbackWeight;
+	int _roundCount;
+protected:
+	// recount the uses of the input pixels from the labeling, and update the
+	// cost of those whose count changed. Return number of changed pixels
+	int UpdateFeedbackCost();
 };
@@ -4,10 +4,10 @@
 int dataFunctionFH(int pixel, int label, void *extraData)
 {
 	ForDataFH* forData = (ForDataFH*) extraData;
-	CvPoint* point = (*(forData->pointMapping))[pixel];
+	CvPoint* point = &(*(forData->pointMapping))[pixel];
 	
 	CvPoint origin;
-	CvPoint shift = GetShift(label, forData->shiftSize);
+	CvPoint shift = (*(forData->labelShifts))[label];
 	origin.x = point->x + shift.x;
 	origin.y = point->y + shift.y;
 	
@@ -22,7 +22,7 @@ int dataFunctionFH(int pixel, int label, void *extraData)
 	
 	// smooth cost with predefined region
 	int energy = 0;
-	value = cvGet2D(forData->maskNeighbor, point->y, point->x);
+	value = (*(forData->maskNeighbor))[pixel];
 	if(value.val[0] == 1)
 	{
 		// compare with up position
@@ -54,10 +54,10 @@ int dataFunctionFH(int pixel, int label, void *extraData)
 int dataFunctionFH2(int pixel, int label, void *extraData)
 {
 	ForDataFH2* forData = (ForDataFH2*) extraData;
-	CvPoint* point = (*(forData->pointMapping))[pixel];
+	CvPoint* point = &(*(forData->pointMapping))[pixel];
 	
 	CvPoint origin;
-	CvPoint shift = GetShift(label, forData->shiftSize);
+	CvPoint shift = (*(forData->labelShifts))[label];
 	origin.x = point->x + shift.x;
 	origin.y = point->y + shift.y;
 	
@@ -72,7 +72,7 @@ int dataFunctionFH2(int pixel, int label, void *extraData)
 	
 	// smooth cost with predefined region
 	int energy = 0;
-	value = cvGet2D(forData->maskNeighbor, point->y, point->x);
+	value = (*(forData->maskNeighbor))[pixel];
 	if(value.val[0] == 1)
 	{
 		// compare with up position
@@ -102,10 +102,10 @@ int dataFunctionFH2(int pixel, int label, void *extraData)
 int smoothFunctionFH(int pixel1, int pixel2, int label1, int label2, void* extraData)
 {
 	ForSmoothFH* data = (ForSmoothFH*)extraData;
-	CvPoint* point1 = (*(data->pointMapping))[pixel1];
-	CvPoint* point2 = (*(data->pointMapping))[pixel2];
-	CvPoint shift1 = GetShift(label1, data->shiftSize);
-	CvPoint shift2 = GetShift(label2, data->shiftSize);
+	CvPoint* point1 = &(*(data->pointMapping))[pixel1];
+	CvPoint* point2 = &(*(data->pointMapping))[pixel2];
+	CvPoint shift1 = (*(data->labelShifts))[label1];
+	CvPoint shift2 = (*(data->labelShifts))[label2];
 	CvPoint origin1 = cvPoint(shift1.x + point1->x, shift1.y + point1->y);
 	CvPoint origin2 = cvPoint(shift2.x + point2->x, shift2.y + point2->y);
 	CvPoint neighbor1 = GetNeighbor(*point1, *point2, origin1);
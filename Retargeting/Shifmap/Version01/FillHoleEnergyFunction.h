@@ -13,8 +13,9 @@ struct ForDataFH2
 	IplImage* saliency;	
 	IplImage* input;
 	IplImage* inputGradient;
-	IplImage* maskNeighbor;
-	vector<CvPoint*>* pointMapping;
+	vector<CvScalar>* maskNeighbor;
+	vector<CvPoint>* pointMapping;
+	vector<CvPoint>* labelShifts;
 	CvSize inputSize;
 	CvSize shiftSize;
 };
@@ -26,8 +27,11 @@ struct ForDataFH
 	IplImage* maskDataGradient;
 	IplImage* input;
 	IplImage* inputGradient;
-	IplImage* maskNeighbor;
-	vector<CvPoint*>* pointMapping;
+	// known neighbors of each node, see SetMaskNeighbor
+	vector<CvScalar>* maskNeighbor;
+	// node points and shift of each label
+	vector<CvPoint>* pointMapping;
+	vector<CvPoint>* labelShifts;
 	CvSize inputSize;
 	CvSize shiftSize;
 };
@@ -36,7 +40,8 @@ struct ForSmoothFH
 {
 	IplImage* input;
 	IplImage* inputGradient;
-	vector<CvPoint*>* pointMapping;
+	vector<CvPoint>* pointMapping;
+	vector<CvPoint>* labelShifts;
 	CvSize inputSize;
 	CvSize shiftSize;
 };
@@ -20,7 +20,7 @@ void FillHoleShiftMap::ComputeShiftMap(IplImage* input, IplImage* saliency, CvSi
 
 		// first processing the mask (including neighborhood)	
 		// ProcessMask();
-		ProcessMask(_mask);
+		ProcessMask(_mask, true);
 
 		// setup data cost & smooth cost for masked data
 		ForDataFH dataCost;
@@ -29,6 +29,7 @@ void FillHoleShiftMap::ComputeShiftMap(IplImage* input, IplImage* saliency, CvSi
 		cvSobel(_maskData, maskDataGradient, 1, 1);
 		dataCost.maskDataGradient = maskDataGradient;
 		dataCost.pointMapping = _pointMapping;
+		dataCost.labelShifts = _labelShifts;
 		dataCost.shiftSize = shiftSize;
 		dataCost.saliency = saliency;
 		dataCost.inputSize = cvSize(input->width, input->height);
@@ -43,6 +44,7 @@ void FillHoleShiftMap::ComputeShiftMap(IplImage* input, IplImage* saliency, CvSi
 		smoothCost.inputGradient = inputGradient;
 		smoothCost.inputSize = cvSize(input->width, input->height);
 		smoothCost.pointMapping = _pointMapping;
+		smoothCost.labelShifts = _labelShifts;
 		smoothCost.shiftSize = shiftSize;
 		_gcGeneral->setSmoothCost(&smoothFunctionFH, &smoothCost);
 
@@ -66,7 +68,7 @@ void FillHoleShiftMap::ComputeShiftMap2(IplImage* input, IplImage* saliency, CvS
 
 		// first processing the mask (including neighborhood)	
 		// ProcessMask();
-		ProcessMask(maskShift);
+		ProcessMask(maskShift, true);
 
 		// setup data cost & smooth cost for masked data
 		ForDataFH2 dataCost;
@@ -76,6 +78,7 @@ void FillHoleShiftMap::ComputeShiftMap2(IplImage* input, IplImage* saliency, CvS
 		cvSobel(_maskData, maskDataGradient, 1, 1);
 		 
 		dataCost.pointMapping = _pointMapping;
+		dataCost.labelShifts = _labelShifts;
 		dataCost.shiftSize = shiftSize;
 		dataCost.saliency = saliency;
 		dataCost.inputSize = cvSize(input->width, input->height);
@@ -90,6 +93,7 @@ void FillHoleShiftMap::ComputeShiftMap2(IplImage* input, IplImage* saliency, CvS
 		smoothCost.inputGradient = inputGradient;
 		smoothCost.inputSize = cvSize(input->width, input->height);
 		smoothCost.pointMapping = _pointMapping;
+		smoothCost.labelShifts = _labelShifts;
 		smoothCost.shiftSize = shiftSize;
 		_gcGeneral->setSmoothCost(&smoothFunctionFH, &smoothCost);
 
@@ -119,211 +123,203 @@ void FillHoleShiftMap::SetMask(IplImage *mask, IplImage *maskData)
 	_mask = mask;
 	_maskData = maskData;
 }
-void FillHoleShiftMap::ProcessMapping(IplImage* mask, CvMat* mapping, vector<CvPoint*>* pointMapping)
+CvRect FillHoleShiftMap::GetNodeRegion(IplImage* mask)
 {
-	// counting number of nodes and set up mapping
-	//CvMat* mapping = cvCreateMat(_mask->height, _mask->width, CV_32SC2);
-	//_pointMapping = new vector<CvPoint*>();	
+	int left = mask->width;
+	int top = mask->height;
+	int right = -1;
+	int bottom = -1;
+	for(int j = 0; j < mask->height; j++)
+	{
+		unsigned char* row = (unsigned char*)(mask->imageData + j * mask->widthStep);
+		for(int i = 0; i < mask->width; i++)
+		{
+			if(row[i * mask->nChannels] > 100) // white
+			{
+				if(i < left) left = i;
+				if(i > right) right = i;
+				if(j < top) top = j;
+				if(j > bottom) bottom = j;
+			}
+		}
+	}
+	if(right < 0)
+		return cvRect(0, 0, 0, 0);
+	return cvRect(left, top, right - left + 1, bottom - top + 1);
+}
+CvRect FillHoleShiftMap::GetNodeRegion(MaskShift* mask)
+{
+	int width = mask->GetWidth();
+	int height = mask->GetHeight();
+	int left = width;
+	int top = height;
+	int right = -1;
+	int bottom = -1;
+	for(int j = 0; j < height; j++)
+		for(int i = 0; i < width; i++)
+		{
+			if(!mask->IsMaskedPixel(i, j))
+			{
+				if(i < left) left = i;
+				if(i > right) right = i;
+				if(j < top) top = j;
+				if(j > bottom) bottom = j;
+			}
+		}
+	if(right < 0)
+		return cvRect(0, 0, 0, 0);
+	return cvRect(left, top, right - left + 1, bottom - top + 1);
+}
+void FillHoleShiftMap::ProcessMapping(IplImage* mask, CvRect region, CvMat* mapping, vector<CvPoint>* pointMapping)
+{
+	// counting number of nodes and set up mapping, inside the region only
 	int count = 0;
-	for(int i = 0; i < _mask->width; i++)
-		for(int j = 0; j < _mask->height; j++)
+	for(int i = 0; i < region.width; i++)
+		for(int j = 0; j < region.height; j++)
 		{
-			CvScalar value = cvGet2D(_mask, j, i);
+			CvScalar value = cvGet2D(mask, region.y + j, region.x + i);
 			if(value.val[0] > 100) // white
 			{
-				CvPoint* point = new CvPoint();
-				point->x = i;
-				point->y = j;
-				pointMapping->push_back(point);					
-				cvSet2D(mapping, j, i, cvScalar(count, count, count));								
+				pointMapping->push_back(cvPoint(region.x + i, region.y + j));
+				CV_MAT_ELEM(*mapping, int, j, i) = count;
 				count++;
 			}
 		}	
 
 }
-void FillHoleShiftMap::ProcessMapping(MaskShift* mask, CvMat* mapping, vector<CvPoint*>* pointMapping)
+void FillHoleShiftMap::ProcessMapping(MaskShift* mask, CvRect region, CvMat* mapping, vector<CvPoint>* pointMapping)
 {
-	// counting number of nodes and set up mapping
-	//CvMat* mapping = cvCreateMat(_mask->height, _mask->width, CV_32SC2);
-	//_pointMapping = new vector<CvPoint*>();	
+	// counting number of nodes and set up mapping, inside the region only
 	int count = 0;
-	int width = mask->GetWidth();
-	int height = mask->GetHeight();
-	for(int i = 0; i < width; i++)
-		for(int j = 0; j < height; j++)
+	for(int i = 0; i < region.width; i++)
+		for(int j = 0; j < region.height; j++)
 		{
-			if(!mask->IsMaskedPixel(i, j))
+			if(!mask->IsMaskedPixel(region.x + i, region.y + j))
 			{
-				CvPoint* point = new CvPoint();
-				point->x = i;
-				point->y = j;
-				pointMapping->push_back(point);					
-				cvSet2D(mapping, j, i, cvScalar(count, count, count));								
+				pointMapping->push_back(cvPoint(region.x + i, region.y + j));
+				CV_MAT_ELEM(*mapping, int, j, i) = count;
 				count++;
 			}
 		}	
 
 }
 
-void FillHoleShiftMap::ProcessMask(IplImage* mask)
+void FillHoleShiftMap::ProcessMask(IplImage* mask, bool restrictLabels)
 {
-	// counting number of nodes and set up mapping
-	CvMat* mapping = cvCreateMat(mask->height, mask->width, CV_32SC2);
-	for(int i = 0; i < mapping->width; i++)
-		for(int j = 0; j < mapping->height; j++)
-		{
-			cvSet2D(mapping, j, i, cvScalar(-1));
-		}
-
-	vector<CvPoint*>* pointMapping = new vector<CvPoint*>();
-	ProcessMapping(mask, mapping, pointMapping);
+	// only the bounding box of the hole takes part in the graph
+	_region = GetNodeRegion(mask);
+	CvMat* mapping = cvCreateMat(MAX(_region.height, 1), MAX(_region.width, 1), CV_32SC1);
+	cvSet(mapping, cvScalar(-1));
+
+	vector<CvPoint>* pointMapping = new vector<CvPoint>();
+	pointMapping->reserve(_region.width * _region.height);
+	ProcessMapping(mask, _region, mapping, pointMapping);
 	
 	_pointMapping = pointMapping;
-	_gcGeneral = new GCoptimizationGeneralGraph(_pointMapping->size(), _shiftSize.width * _shiftSize.height);
+	SetupLabels(restrictLabels);
+	_gcGeneral = new GCoptimizationGeneralGraph(_pointMapping->size(), _labelShifts->size());
 	
 	SetupGCOptimizationNeighbor(_gcGeneral, mapping);
-	_maskNeighbor = cvCreateImage(cvSize(_mask->width, _mask->height), IPL_DEPTH_8U, 4);
+	_maskNeighbor = new vector<CvScalar>(_pointMapping->size(), cvScalar(0));
 	SetupMaskNeighbor(_maskNeighbor, mask);
-	 
+	cvReleaseMat(&mapping);
 }
-void FillHoleShiftMap::ProcessMask(MaskShift* mask)
+void FillHoleShiftMap::ProcessMask(MaskShift* mask, bool restrictLabels)
 {
-	// compute mask and mask data
-	int width = mask->GetWidth();
-	int height = mask->GetHeight();
-	for(int i = 0; i < width; i++)
-		for(int j = 0; j < width; j++)
-		{
-		}
-	// counting number of nodes and set up mapping
-	CvMat* mapping = cvCreateMat(mask->GetHeight(), mask->GetWidth(), CV_32SC2);
-	for(int i = 0; i < mapping->width; i++)
-		for(int j = 0; j < mapping->height; j++)
-		{
-			cvSet2D(mapping, j, i, cvScalar(-1));
-		}
-
-	vector<CvPoint*>* pointMapping = new vector<CvPoint*>();
-	ProcessMapping(mask, mapping, pointMapping);
+	// only the bounding box of the hole takes part in the graph
+	_region = GetNodeRegion(mask);
+	CvMat* mapping = cvCreateMat(MAX(_region.height, 1), MAX(_region.width, 1), CV_32SC1);
+	cvSet(mapping, cvScalar(-1));
+
+	vector<CvPoint>* pointMapping = new vector<CvPoint>();
+	pointMapping->reserve(_region.width * _region.height);
+	ProcessMapping(mask, _region, mapping, pointMapping);
 	
 	_pointMapping = pointMapping;
-	_gcGeneral = new GCoptimizationGeneralGraph(_pointMapping->size(), _shiftSize.width * _shiftSize.height);
+	SetupLabels(restrictLabels);
+	_gcGeneral = new GCoptimizationGeneralGraph(_pointMapping->size(), _labelShifts->size());
 	
 	SetupGCOptimizationNeighbor(_gcGeneral, mapping);
-
-	
-	_maskNeighbor = cvCreateImage(cvSize(_mask->width, _mask->height), IPL_DEPTH_8U, 4);
+	_maskNeighbor = new vector<CvScalar>(_pointMapping->size(), cvScalar(0));
 	SetupMaskNeighbor(_maskNeighbor, mask);
-	 
+	cvReleaseMat(&mapping);
+}
+void FillHoleShiftMap::SetupLabels(bool restrictLabels)
+{
+	_labelShifts = new vector<CvPoint>();
+	int labelCount = _shiftSize.width * _shiftSize.height;
+	for(int label = 0; label < labelCount; label++)
+	{
+		CvPoint shift = GetShift(label, _shiftSize);
+		if(restrictLabels)
+		{
+			// no node of the region maps inside the input with this shift
+			if(_region.x + shift.x >= _input->width || _region.x + _region.width + shift.x <= 0 ||
+				_region.y + shift.y >= _input->height || _region.y + _region.height + shift.y <= 0)
+				continue;
+		}
+		_labelShifts->push_back(shift);
+	}
 }
 void FillHoleShiftMap::SetupGCOptimizationNeighbor(GCoptimizationGeneralGraph* gcGeneral, CvMat* mapping)
 {	
-	for(int i = 0; i < mapping->width-1; i++)
-		for(int j = 0; j < mapping->height-1; j++)
+	for(int i = 0; i < mapping->width; i++)
+		for(int j = 0; j < mapping->height; j++)
 		{
-			int nodeId1 = cvGet2D(mapping, j, i).val[0];
+			int nodeId1 = CV_MAT_ELEM(*mapping, int, j, i);
+			if(nodeId1 < 0)
+				continue;
 			int nodeId2;
-			nodeId2 = cvGet2D(mapping, j, i + 1).val[0];
  
 			// setup neighbors to the right and down only
-			if(nodeId2 >= 0 && nodeId1 >= 0)
-				gcGeneral->setNeighbors(nodeId1, nodeId2);
-			nodeId2 = cvGet2D(mapping, j + 1, i).val[0];
-			if(nodeId2 >= 0 && nodeId1 >= 0)
-				gcGeneral->setNeighbors(nodeId1, nodeId2); 
+			if(i + 1 < mapping->width)
+			{
+				nodeId2 = CV_MAT_ELEM(*mapping, int, j, i + 1);
+				if(nodeId2 >= 0)
+					gcGeneral->setNeighbors(nodeId1, nodeId2);
+			}
+			if(j + 1 < mapping->height)
+			{
+				nodeId2 = CV_MAT_ELEM(*mapping, int, j + 1, i);
+				if(nodeId2 >= 0)
+					gcGeneral->setNeighbors(nodeId1, nodeId2); 
+			}
 		}
 }
 
-void FillHoleShiftMap::SetupMaskNeighbor(IplImage* maskNeighbor, IplImage* mask)
-{
-	for(int i = 0; i < mask->width - 1; i++)
-		for(int j = 0; j < mask->height - 1; j++)
-		{
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i+1,j), maskNeighbor, mask);
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i,j+1), maskNeighbor, mask);
-		}
-}
-void FillHoleShiftMap::SetupMaskNeighbor(IplImage* maskNeighbor, MaskShift* mask)
+void FillHoleShiftMap::SetupMaskNeighbor(vector<CvScalar>* maskNeighbor, IplImage* mask)
 {
-	int width = mask->GetWidth();
-	int height = mask->GetHeight();
-	for(int i = 0; i < width - 1; i++)
-		for(int j = 0; j < height - 1; j++)
+	// NOTE: up 0, right 1, down 2, left 3
+	CvPoint offsets[4] = {cvPoint(0, -1), cvPoint(1, 0), cvPoint(0, 1), cvPoint(-1, 0)};
+	CvSize maskSize = cvSize(mask->width, mask->height);
+	int count = maskNeighbor->size();
+	for(int n = 0; n < count; n++)
+	{
+		CvPoint point = (*_pointMapping)[n];
+		for(int k = 0; k < 4; k++)
 		{
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i+1,j), maskNeighbor, mask);
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i,j+1), maskNeighbor, mask);
+			CvPoint neighbor = cvPoint(point.x + offsets[k].x, point.y + offsets[k].y);
+			if(!IsOutside(neighbor, maskSize) && IsMaskedPixel(neighbor.x, neighbor.y, mask))
+				SetMaskNeighbor(point, neighbor, &(*maskNeighbor)[n]);
 		}
-}
-void FillHoleShiftMap::ProcessNeighbor(CvPoint currentPoint, CvPoint neighborPoint, IplImage* maskNeighbor, IplImage* mask)
-{
-	if(!IsMaskedPixel(currentPoint.x, currentPoint.y, mask) && IsMaskedPixel(neighborPoint.x, neighborPoint.y, mask))
-	{
-		CvScalar value = cvGet2D(maskNeighbor, currentPoint.y, currentPoint.x);
-		SetMaskNeighbor(currentPoint, neighborPoint, &value);					
-		cvSet2D(maskNeighbor, currentPoint.y, currentPoint.x, value);
-	}
-	else
-	if(IsMaskedPixel(currentPoint.x, currentPoint.y, mask) && !IsMaskedPixel(neighborPoint.x, neighborPoint.y, mask))
-	{
-		CvScalar value = cvGet2D(maskNeighbor, currentPoint.y, currentPoint.x);
-		SetMaskNeighbor(neighborPoint, currentPoint, &value);					
-		cvSet2D(maskNeighbor, neighborPoint.y, neighborPoint.x, value);
 	}
 }
-void FillHoleShiftMap::ProcessNeighbor(CvPoint currentPoint, CvPoint neighborPoint, IplImage* maskNeighbor, MaskShift* mask)
-{
-	if(!mask->IsMaskedPixel(currentPoint.x, currentPoint.y) && mask->IsMaskedPixel(neighborPoint.x, neighborPoint.y))
-	{
-		CvScalar value = cvGet2D(maskNeighbor, currentPoint.y, currentPoint.x);
-		SetMaskNeighbor(currentPoint, neighborPoint, &value);					
-		cvSet2D(maskNeighbor, currentPoint.y, currentPoint.x, value);
-	}
-	else
-	if(mask->IsMaskedPixel(currentPoint.x, currentPoint.y) && !mask->IsMaskedPixel(neighborPoint.x, neighborPoint.y))
-	{
-		CvScalar value = cvGet2D(maskNeighbor, currentPoint.y, currentPoint.x);
-		SetMaskNeighbor(neighborPoint, currentPoint, &value);					
-		cvSet2D(maskNeighbor, neighborPoint.y, neighborPoint.x, value);
-	}
-}
-
-
-void FillHoleShiftMap::ProcessMask()
+void FillHoleShiftMap::SetupMaskNeighbor(vector<CvScalar>* maskNeighbor, MaskShift* mask)
 {
-	// counting number of nodes and set up mapping
-	CvMat* mapping = cvCreateMat(_mask->height, _mask->width, CV_32SC2);
-	_pointMapping = new vector<CvPoint*>();
-	int count = 0;
-	for(int i = 0; i < _mask->width; i++)
-		for(int j = 0; j < _mask->height; j++)
-		{
-			CvScalar value = cvGet2D(_mask, j, i);
-			if(value.val[0] > 100) // white
-			{
-				CvPoint* point = new CvPoint();
-				point->x = i;
-				point->y = j;
-				_pointMapping->push_back(point);					
-				cvSet2D(mapping, j, i, cvScalar(count, count, count));				
-				count++;
-			}
-		}	
-			_gcGeneral = new GCoptimizationGeneralGraph(count, _input->width * _input->height);
-	
-	// now setup neighborhood system
-	_maskNeighbor = cvCreateImage(cvSize(_mask->width, _mask->height), IPL_DEPTH_8U, 4);
 	// NOTE: up 0, right 1, down 2, left 3
-	for(int i = 0; i < _mask->width; i++)
-		for(int j = 0; j < _mask->height; j++)
+	CvPoint offsets[4] = {cvPoint(0, -1), cvPoint(1, 0), cvPoint(0, 1), cvPoint(-1, 0)};
+	CvSize maskSize = cvSize(mask->GetWidth(), mask->GetHeight());
+	int count = maskNeighbor->size();
+	for(int n = 0; n < count; n++)
+	{
+		CvPoint point = (*_pointMapping)[n];
+		for(int k = 0; k < 4; k++)
 		{
-			int nodeId2;
-			int nodeId1 = cvGet2D(mapping, j, i).val[0];
-
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i-1,j), _maskNeighbor, mapping, _gcGeneral);
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i+1,j), _maskNeighbor, mapping, _gcGeneral);
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i,j-1), _maskNeighbor, mapping, _gcGeneral);
-			ProcessNeighbor(cvPoint(i,j), cvPoint(i,j+1), _maskNeighbor, mapping, _gcGeneral);			
+			CvPoint neighbor = cvPoint(point.x + offsets[k].x, point.y + offsets[k].y);
+			if(!IsOutside(neighbor, maskSize) && mask->IsMaskedPixel(neighbor.x, neighbor.y))
+				SetMaskNeighbor(point, neighbor, &(*maskNeighbor)[n]);
 		}
+	}
 }
 
 bool FillHoleShiftMap::IsMaskedPixel(int x, int y, IplImage* mask)
@@ -341,33 +337,6 @@ bool FillHoleShiftMap::IsMaskedPixel(int x, int y, IplImage* mask)
 	}
 }
 
-void FillHoleShiftMap::ProcessNeighbor(CvPoint currentPoint, CvPoint neighborPoint,
-									   IplImage* maskNeighbor, CvMat* mapping, GCoptimizationGeneralGraph* gcGeneral)
-{
-	CvScalar value =  cvGet2D(mapping, currentPoint.y, currentPoint.x);
-	int nodeId1 = value.val[0];
-	if(nodeId1 >= 0)
-	{
-		if(!IsOutside(currentPoint, cvSize(maskNeighbor->width, maskNeighbor->height)) &&
-			!IsOutside(neighborPoint, cvSize(maskNeighbor->width, maskNeighbor->height)))
-		{
-			// printf("i: %i, j: %i\n", neighborPoint.x, neighborPoint.y);
-			CvScalar value = cvGet2D(mapping, neighborPoint.y, neighborPoint.x);
-			int nodeId2 = value.val[0];
-			if(nodeId2 >= 0)
-			{	
-				gcGeneral->setNeighbors(nodeId1, nodeId2);				
-			}
-			if(!IsMaskedPixel(currentPoint.x, currentPoint.y,_mask) && IsMaskedPixel(neighborPoint.x,neighborPoint.y,_mask))
-			{
-				CvScalar value = cvGet2D(maskNeighbor, currentPoint.y, currentPoint.x);
-				SetMaskNeighbor(currentPoint, neighborPoint, &value);					
-				cvSet2D(maskNeighbor, currentPoint.y, currentPoint.x, value);
-			}
-		}
-	}
-}
-
 IplImage* FillHoleShiftMap::CalculatedRetargetImage()
 {	 
 	IplImage* output = cvCloneImage(_maskData);
@@ -378,8 +347,8 @@ IplImage* FillHoleShiftMap::CalculatedRetargetImage()
 	for(int i = 0; i < num_pixels; i++)
 	{
 		int label = _gcGeneral->whatLabel(i);
-		CvPoint* point = (*(_pointMapping))[i];
-		CvPoint shift = GetShift(label, _shiftSize);		 
+		CvPoint* point = &(*(_pointMapping))[i];
+		CvPoint shift = (*_labelShifts)[label];		 
 		CvPoint pointLabel = cvPoint(point->x + shift.x, point->y + shift.y);
 
 		if(!IsOutside(pointLabel, cvSize(_input->width, _input->height)))
@@ -417,8 +386,8 @@ CvMat* FillHoleShiftMap::CalculateLabelMap()
 	for(int i = 0; i < num_pixels; i++)
 	{
 		int label = _gcGeneral->whatLabel(i);		
-		CvPoint* point = (*(_pointMapping))[i];
-		CvPoint pointLabel = GetShift(label, _shiftSize);		
+		CvPoint* point = &(*(_pointMapping))[i];
+		CvPoint pointLabel = (*_labelShifts)[label];		
 		
 		SetLabel(*point, pointLabel, output);
 	}
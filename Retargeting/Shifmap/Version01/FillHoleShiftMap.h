@@ -21,43 +21,46 @@ protected:
 	IplImage* _mask;
 	IplImage* _maskData;
 	GCoptimizationGeneralGraph* _gcGeneral;
-	vector<CvPoint*>* _pointMapping;
+	// nodes of the graph, in the order of their ids
+	vector<CvPoint>* _pointMapping;
 	IplImage* _input;
-	IplImage* _maskNeighbor; // carry neighbor info with mask
+	// known neighbors of each node (up, right, down, left), see SetMaskNeighbor
+	vector<CvScalar>* _maskNeighbor;
+	// shift of each label of the graph
+	vector<CvPoint>* _labelShifts;
+	// bounding box of the nodes in the mask
+	CvRect _region;
 	CvSize _shiftSize;
 protected:
 	void ClearGC();
-	void ProcessMask();
 	bool IsMaskedPixel(int x, int y, IplImage* mask);
 	
+	// bounding box of the pixels to be filled, empty if there is none
+	CvRect GetNodeRegion(IplImage* mask);
+	CvRect GetNodeRegion(MaskShift* mask);
+
 	// process the mapping
 	// pointMapping is an empty vector
-	// mapping is a matrix which has the same size as the mask	
+	// mapping is a matrix of the size of region, set to -1
 	// mask is the input
-	// return total number of nodes
-	void ProcessMapping(IplImage* mask, CvMat* mapping, vector<CvPoint*>* pointMapping);
-	void ProcessMapping(MaskShift* mask, CvMat* mapping, vector<CvPoint*>* pointMapping);
-	// 
-	void ProcessMask(IplImage* mask);
-	void ProcessMask(MaskShift* mask);
+	void ProcessMapping(IplImage* mask, CvRect region, CvMat* mapping, vector<CvPoint>* pointMapping);
+	void ProcessMapping(MaskShift* mask, CvRect region, CvMat* mapping, vector<CvPoint>* pointMapping);
+	// build the graph over the region of the mask only
+	// restrictLabels: labels are absolute shifts, keep only those which can map
+	// a node inside the input. Otherwise every shift of _shiftSize is a label
+	void ProcessMask(IplImage* mask, bool restrictLabels);
+	void ProcessMask(MaskShift* mask, bool restrictLabels);
+	void SetupLabels(bool restrictLabels);
 	
 	// setup neighborhood system for GC
+	// mapping covers the region, as given by ProcessMapping
 	void SetupGCOptimizationNeighbor(GCoptimizationGeneralGraph* gcGeneral, CvMat* mapping);
 
 	// setup neighborhood system for nodes & masked pixels
-	// maskNeighbor & mask should have the same size
-	// action: scan through the mask and set info for pixel which is a neighbor of a masked pixel
-	// 
-	void SetupMaskNeighbor(IplImage* maskNeighbor, IplImage* mask);
-	void SetupMaskNeighbor(IplImage* maskNeighbor, MaskShift* mask);
-	// helpful function for SetupMaskNeighbor
-	// doesn't check whether currentPoint & neighborPoint is neighbor
-	// and inside the image 
-	// tradeoff safety for performance
-	void ProcessNeighbor(CvPoint currentPoint, CvPoint neighborPoint, IplImage* maskNeighbor, IplImage* mask);
-	void ProcessNeighbor(CvPoint currentPoint, CvPoint neighborPoint, IplImage* maskNeighbor, MaskShift* mask);
+	// action: for each node, set info for its neighbors which are masked pixels
+	void SetupMaskNeighbor(vector<CvScalar>* maskNeighbor, IplImage* mask);
+	void SetupMaskNeighbor(vector<CvScalar>* maskNeighbor, MaskShift* mask);
 	
-	void ProcessNeighbor(CvPoint currentPoint, CvPoint neighborPoint, IplImage* maskNeighbor, CvMat* mapping, GCoptimizationGeneralGraph* gcGeneral);
 	IplImage* CalculatedRetargetImage();
 	CvMat* CalculateLabelMap();
 };
@@ -1,31 +1,79 @@
 #include "StdAfx.h"
 #include "GCAlgorithm.h"
+#include "ScaleEnergyFunction.h"
+#include "WarpEnergyFunction.h"
+#include "HorizontalScaleEnergyFunction.h"
+#include "GCScaleStackHorizontalEnergy.h"
+#include <typeinfo>
 
-int dataFunctionGCA(int pixel, int label, void *extraData)
+// ScaleEnergyFunction with the data cost type resolved when the binding is 
+// made rather than switched on for every term
+template <int DataCostType>
+class GCScaleEnergyBinding : public GCEnergyBinding
 {
-	// GCEnergyFunction* energyFunction = (GCScaleStackEnergy*) extraData;
-	GCEnergyFunction* energyFunction = (GCEnergyFunction*) extraData;
-	int energy = energyFunction->GetDataCost(label, pixel);
-	return energy;
-}
+public:
+	GCScaleEnergyBinding(ScaleEnergyFunction* energyFunction) { _energyFunction = energyFunction; }
+protected:
+	ScaleEnergyFunction* _energyFunction;
+public:
+	virtual GCoptimization::EnergyTermType compute(GCoptimization::SiteID s, GCoptimization::LabelID l)
+	{
+		if(DataCostType == DATA_AREA)
+			return _energyFunction->ScaleEnergyFunction::GetDataCostAreaCost(l, s, SCALE_DATA_PENALTY);
+		return _energyFunction->ScaleEnergyFunction::GetDataCostOrigin(l, s, SCALE_DATA_PENALTY);
+	}
+	virtual GCoptimization::EnergyTermType compute(GCoptimization::SiteID s1, GCoptimization::SiteID s2, 
+		GCoptimization::LabelID l1, GCoptimization::LabelID l2)
+	{
+		return _energyFunction->ScaleEnergyFunction::GetSmoothCostOrigin(l1, l2, s1, s2, SCALE_SMOOTH_PENALTY);
+	}
+};
 
-int smoothFunctionGCA(int pixel1, int pixel2, int label1, int label2, void* extraData)
+GCEnergyBinding* CreateEnergyBinding(GCEnergyFunction* energyFunction)
 {
-	GCEnergyFunction* energyFunction = (GCScaleStackEnergy*) extraData;
-	return energyFunction->GetSmoothCost(label1, label2, pixel1, pixel2);
+	const type_info& type = typeid(*energyFunction);
+
+	if(type == typeid(ScaleEnergyFunction))
+	{
+		ScaleEnergyFunction* scaleEnergy = (ScaleEnergyFunction*) energyFunction;
+		if(scaleEnergy->GetDataCostType() == DATA_AREA)
+			return new GCScaleEnergyBinding<DATA_AREA>(scaleEnergy);
+		return new GCScaleEnergyBinding<DATA_ORIGIN>(scaleEnergy);
+	}
+	if(type == typeid(WarpEnergyFunction))
+		return new GCEnergyBindingT<WarpEnergyFunction>((WarpEnergyFunction*) energyFunction);
+	if(type == typeid(HorizontalScaleEnergyFunction))
+		return new GCEnergyBindingT<HorizontalScaleEnergyFunction>((HorizontalScaleEnergyFunction*) energyFunction);
+	if(type == typeid(GCScaleStackHorizontalEnergy))
+		return new GCEnergyBindingT<GCScaleStackHorizontalEnergy>((GCScaleStackHorizontalEnergy*) energyFunction);
+	if(type == typeid(GCScaleStackEnergy))
+		return new GCEnergyBindingT<GCScaleStackEnergy>((GCScaleStackEnergy*) energyFunction);
+
+	// virtual calls for everything else
+	return new GCVirtualEnergyBinding(energyFunction);
 }
 
 GCAlgorithm::GCAlgorithm(void)
 {
+	_gc = NULL;
+	_binding = NULL;
+	_autoBinding = false;
 }
 
 GCAlgorithm::GCAlgorithm(GCEnergyFunction* energyFunction)
 {
 	_gcEnergyFunction = energyFunction;
+	_gc = NULL;
+	_binding = NULL;
+	_autoBinding = false;
 }
 
 GCAlgorithm::~GCAlgorithm(void)
 {
+	if(_binding != NULL)
+		delete _binding;
+	if(_gc != NULL)
+		delete _gc;
 }
 int GCAlgorithm::GetSitesCount()
 {
@@ -35,14 +83,26 @@ int GCAlgorithm::GetSitesCount()
 void GCAlgorithm::SetEnergyFunction(GCEnergyFunction* energyFunction)
 {
 	_gcEnergyFunction = energyFunction;
+	if(_binding != NULL)
+		delete _binding;
+	_binding = NULL;
+	_autoBinding = false;
 }
 
 void GCAlgorithm::ComputeGC()
 {
 	try{
 		
-		_gc->setDataCost(&dataFunctionGCA, _gcEnergyFunction);
-		_gc->setSmoothCost(&smoothFunctionGCA, _gcEnergyFunction);
+		// rebuild the binding, e.g. the data cost type of a ScaleEnergyFunction may have changed
+		if(_binding == NULL || _autoBinding)
+		{
+			if(_binding != NULL)
+				delete _binding;
+			_binding = CreateEnergyBinding(_gcEnergyFunction);
+			_autoBinding = true;
+		}
+		_gc->setDataCostFunctor(_binding);
+		_gc->setSmoothCostFunctor(_binding);
 
 		printf("\nBefore optimization energy is %d \n", _gc->compute_energy());
 		//gc->swap(20);
@@ -2,9 +2,58 @@
 #include "GCEnergyFunction.h"
 #include "GCOptimization.h"
 #include "GCScaleStackEnergy.h"
-int dataFunctionGCA(int pixel, int label, void *extraData);
-int smoothFunctionGCA(int pixel1, int pixel2, int label1, int label2, void* extraData);
 
+// costs of an energy function handed to GCoptimization as functors, so each 
+// term costs the one indirect call GCoptimization makes into the functor
+class GCEnergyBinding : public GCoptimization::DataCostFunctor, public GCoptimization::SmoothCostFunctor
+{
+public:
+	virtual ~GCEnergyBinding(void) {}
+};
+
+// binding for a known energy class: its costs are called non-virtually, so 
+// EnergyT must be the exact type of the object
+template <class EnergyT>
+class GCEnergyBindingT : public GCEnergyBinding
+{
+public:
+	GCEnergyBindingT(EnergyT* energyFunction) { _energyFunction = energyFunction; }
+protected:
+	EnergyT* _energyFunction;
+public:
+	virtual GCoptimization::EnergyTermType compute(GCoptimization::SiteID s, GCoptimization::LabelID l)
+	{
+		return _energyFunction->EnergyT::GetDataCost(l, s);
+	}
+	virtual GCoptimization::EnergyTermType compute(GCoptimization::SiteID s1, GCoptimization::SiteID s2, 
+		GCoptimization::LabelID l1, GCoptimization::LabelID l2)
+	{
+		return _energyFunction->EnergyT::GetSmoothCost(l1, l2, s1, s2);
+	}
+};
+
+// binding for any other energy class, through the virtual GCEnergyFunction interface
+class GCVirtualEnergyBinding : public GCEnergyBinding
+{
+public:
+	GCVirtualEnergyBinding(GCEnergyFunction* energyFunction) { _energyFunction = energyFunction; }
+protected:
+	GCEnergyFunction* _energyFunction;
+public:
+	virtual GCoptimization::EnergyTermType compute(GCoptimization::SiteID s, GCoptimization::LabelID l)
+	{
+		return _energyFunction->GetDataCost(l, s);
+	}
+	virtual GCoptimization::EnergyTermType compute(GCoptimization::SiteID s1, GCoptimization::SiteID s2, 
+		GCoptimization::LabelID l1, GCoptimization::LabelID l2)
+	{
+		return _energyFunction->GetSmoothCost(l1, l2, s1, s2);
+	}
+};
+
+// picks the binding for the run-time type of energyFunction, again for every graph cut; 
+// unknown classes get a binding through the virtual GCEnergyFunction interface
+GCEnergyBinding* CreateEnergyBinding(GCEnergyFunction* energyFunction);
 
 // generalized class for graph cut
 class GCAlgorithm
@@ -12,16 +61,27 @@ class GCAlgorithm
 public:
 	GCAlgorithm(void);
 	GCAlgorithm(GCEnergyFunction* energyFunction);
-	~GCAlgorithm(void);
+	virtual ~GCAlgorithm(void);
 protected:
 	GCEnergyFunction* _gcEnergyFunction;
+	GCEnergyBinding* _binding;
+	// _binding was made by CreateEnergyBinding and is made again for every cut, 
+	// since it depends on state of the energy function that may have changed
+	bool _autoBinding;
 	GCoptimization* _gc;
 public:
 	int GetSitesCount();
 	void SetupGC(int numSites, int numLabel);
 	void SetEnergyFunction(GCEnergyFunction* energyFunction);
+	// same as SetEnergyFunction with the energy class fixed at compile time
+	template <class EnergyT> void BindEnergyFunction(EnergyT* energyFunction)
+	{
+		SetEnergyFunction(energyFunction);
+		_binding = new GCEnergyBindingT<EnergyT>(energyFunction);
+		_autoBinding = false;
+	}
 	void ComputeGC();
 	GCoptimization* GetGCoptimization();
 	int GetSmoothEnergy();
 	int GetDataEnergy();
-};
+};
\ No newline at end of file
@@ -54,29 +54,34 @@ IplImage* GCImageRender::GetVisualizedImage()
 IplImage* GCImageRender::GetRenderedImage()
 {	 
 	IplImage* image = cvCreateImage(cvSize(_width, _height), IPL_DEPTH_8U, 3);
+
+	// gather where each pixel reads from, then render the rows in parallel
+	RenderSample* samples = new RenderSample[_width * _height];
+	for(int i = 0; i < _width * _height; i++)
+		samples[i].sourceId = -1;
 	for(int i = 0; i < _numSites; i++)
 	{
 		int label = _gc->whatLabel(i);
 		Point3D mappedPoint = _mapper->GetMappedPoint(label, i);
-		//CvPoint point = GetPoint(i, cvSize(_width, _height));
 		Point3D point = _mapper->GetPoint(i);
-		
-		if(_imageSource->IsOutsideSource(mappedPoint))
-		{
-			printf("Map outside");
-			cvSet2D(image, point.y, point.x, cvScalar(255));
-		}
-		else
-		{
-			CvScalar value = _imageSource->GetImageValue(mappedPoint);
-			cvSet2D(image, point.y, point.x, value);
-			if(mappedPoint.z == 1)
-			{
-				printf("smaller scale");
-			}
-		}
-		
+
+		RenderSample* sample = samples + point.y * _width + point.x;
+		sample->x = mappedPoint.x;
+		sample->y = mappedPoint.y;
+		sample->sourceId = _imageSource->IsOutsideSource(mappedPoint) ? -1 : mappedPoint.z;
 	}
+
+	int levelCount = _imageSource->GetLevelCount();
+	IplImage** sources = new IplImage*[levelCount];
+	for(int i = 0; i < levelCount; i++)
+		sources[i] = _imageSource->GetImage(i);
+
+	int outsideCount = RenderImage(image, samples, sources, RENDER_NEAREST, cvScalar(255));
+	if(outsideCount > 0)
+		printf("Map outside: %d pixels\n", outsideCount);
+
+	delete[] sources;
+	delete[] samples;
 	//DisplayImage(image, "TEST");
 	return image;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "ScaleStackImageSource.h"
 #include "MappingCubic.h"
 #include "DebugTool.h"
+#include "RenderKernel.h"
 // rendering the graph-cut result
 class GCImageRender
 {
@@ -17,6 +17,11 @@ void GCScaleStackEnergy::SetSource(ScaleStackImageSource* source, ScaleStackImag
 {
 	_imageSource = source;
 	_imageSaliency = saliency;
+	// the costs read the packed stacks directly
+	if(!_imageSource->IsPacked())
+		_imageSource->Pack();
+	if(!_imageSaliency->IsPacked())
+		_imageSaliency->Pack();
 }
  int GCScaleStackEnergy::GetDataCost(int labelId, int nodeId)
  {
@@ -24,17 +29,15 @@ void GCScaleStackEnergy::SetSource(ScaleStackImageSource* source, ScaleStackImag
 	 Point3D shift = _mappingCubicShift->GetMappedPoint(labelId);
      Point3D mappedPoint = point3D(nodePoint.x + shift.x, nodePoint.y + shift.y, nodePoint.z + shift.z);
 	 
-	 if(!_imageSaliency->IsOutsideSource(mappedPoint))
+	 if(!_imageSaliency->IsOutsidePacked(mappedPoint))
 	 {
-		CvScalar saliency = _imageSaliency->GetImageValue(mappedPoint);
-
 		// higher level receive more saliency
 		//if(mappedPoint.z != 0)
 		//	for(int i = 0; i < 4; i++)
 		//	{
 		//		saliency.val[i] /= (mappedPoint.z + 1.5);
 		//	}
-		return saliency.val[0] + saliency.val[1] + saliency.val[2];
+		return _imageSaliency->ImageSum(mappedPoint);
 	 }
 	 else
 		 return 100000;
@@ -49,7 +52,7 @@ void GCScaleStackEnergy::SetSource(ScaleStackImageSource* source, ScaleStackImag
 	Point3D mappedPoint1 = point3D(pixelPoint1.x + labelPoint1.x, pixelPoint1.y + labelPoint1.y, pixelPoint1.z + labelPoint1.z);
 	Point3D mappedPoint2 = point3D(pixelPoint2.x + labelPoint2.x, pixelPoint2.y + labelPoint2.y, pixelPoint2.z + labelPoint2.z);
 
-	if(_imageSource->IsOutsideSource(mappedPoint1) || _imageSource->IsOutsideSource(mappedPoint2))
+	if(_imageSource->IsOutsidePacked(mappedPoint1) || _imageSource->IsOutsidePacked(mappedPoint2))
 		return 10000;
 	//return 50;
 	
@@ -62,16 +65,12 @@ void GCScaleStackEnergy::SetSource(ScaleStackImageSource* source, ScaleStackImag
 
 	int energy = 0;
 
-	if(_imageSource->IsOutsideSource(neighbor2) ||
-		_imageSource->IsOutsideSource(neighbor1))
+	if(_imageSource->IsOutsidePacked(neighbor2) ||
+		_imageSource->IsOutsidePacked(neighbor1))
 		return 10000;
 
-	energy += _imageSource->GetSquareColorDifference(mappedPoint1, neighbor2);
-	energy += _imageSource->GetSquareColorDifference(mappedPoint2, neighbor1);  
-
-	// gradient different term 
-	energy += 2 * _imageSource->GetSquareGradientDifference(mappedPoint2, neighbor1);
-	energy += 2 * _imageSource->GetSquareGradientDifference(mappedPoint1, neighbor2);
+	// color and (twice weighted) gradient different terms
+	energy += _imageSource->GetSmoothDifference(mappedPoint1, neighbor2, mappedPoint2, neighbor1, 2);
 	
 	// scale down the energy
 	if(energy < 50) energy = 0;
@@ -16,20 +16,17 @@ Point3D nodePoint = _mappingCubicData->GetMappedPoint(nodeId);
 
 	int penaltyCost = 100000;
 
-	if(!_imageSaliency->IsOutsideSource(mappedPoint))
+	if(!_imageSaliency->IsOutsidePacked(mappedPoint))
 	{	 
 		// ensure boundary
 		if(nodePoint.x == 0 && (mappedPoint.x != 0 || nodePoint.y != mappedPoint.y || mappedPoint.z != 0))
 			return penaltyCost;
  
 		if(nodePoint.x == _mappingCubicData->GetWidth() - 1
-			&& (mappedPoint.x != _imageSource->GetImageSize(0).width - 1 || mappedPoint.y != nodePoint.y) )
+			&& (mappedPoint.x != _imageSource->GetLevelWidth(0) - 1 || mappedPoint.y != nodePoint.y) )
 			return penaltyCost;
 	 
-		CvScalar saliency = _imageSaliency->GetImageValue(mappedPoint);
-
-	 
-		return saliency.val[0] + saliency.val[1] + saliency.val[2];
+		return _imageSaliency->ImageSum(mappedPoint);
 	}
 	else
 		return penaltyCost;
@@ -42,25 +39,22 @@ Point3D nodePoint = _mappingCubicData->GetMappedPoint(nodeId);
 
 	int penaltyCost = 200000;
 
-	if(!_imageSaliency->IsOutsideSource(mappedPoint))
+	if(!_imageSaliency->IsOutsidePacked(mappedPoint))
 	{	 
 		// ensure boundary
 		if(nodePoint.x == 0 && (mappedPoint.x != 0 || nodePoint.y != mappedPoint.y || mappedPoint.z != 0))
 			return penaltyCost;
  
 		if(nodePoint.x == _mappingCubicData->GetWidth() - 1
-			&& (mappedPoint.x != _imageSource->GetImageSize(0).width - 1 || mappedPoint.y != nodePoint.y) )
+			&& (mappedPoint.x != _imageSource->GetLevelWidth(0) - 1 || mappedPoint.y != nodePoint.y) )
 			return penaltyCost;
 	 
-		CvScalar saliency = _imageSaliency->GetImageValue(mappedPoint);
+		int saliency = _imageSaliency->ImageSum(mappedPoint);
 
 			//// higher level receive less saliency
 			if(mappedPoint.z != 0)
-				for(int i = 0; i < 4; i++)
-				{
-					saliency.val[i] *= (mappedPoint.z + 0.1);
-				}
-		return saliency.val[0] + saliency.val[1] + saliency.val[2];
+				return saliency * (mappedPoint.z + 0.1);
+		return saliency;
 	}
 	else
 		return penaltyCost;
@@ -73,7 +67,7 @@ Point3D nodePoint = _mappingCubicData->GetMappedPoint(nodeId);
 	Point3D mappedPoint = point3D(nodePoint.x + shift.x, nodePoint.y + shift.y, nodePoint.z + shift.z);
 
 	int penaltyCost = 10000;
-	if(!_imageSaliency->IsOutsideSource(mappedPoint))
+	if(!_imageSaliency->IsOutsidePacked(mappedPoint))
 	{	 
 	// ensure boundary
 	if(nodePoint.x == 0 && (mappedPoint.x != 0 || nodePoint.y != mappedPoint.y))
@@ -86,7 +80,7 @@ Point3D nodePoint = _mappingCubicData->GetMappedPoint(nodeId);
 		for(int i = 0; i < _imageSource->GetLevelCount(); i++)
 		// for(int i = 0; i < _imageSource->GetLevelCount(); i++)
 		{
-			if(mappedPoint.x == _imageSource->GetImageSize(i).width - 1 && mappedPoint.y == nodePoint.y && 
+			if(mappedPoint.x == _imageSource->GetLevelWidth(i) - 1 && mappedPoint.y == nodePoint.y && 
 				mappedPoint.z == i)
 				lastColMapped = 1;
 		}
@@ -97,15 +91,13 @@ Point3D nodePoint = _mappingCubicData->GetMappedPoint(nodeId);
  
 	
 
-		CvScalar saliency = _imageSaliency->GetImageValue(mappedPoint);
-
 		// higher level receive less saliency
 		//if(mappedPoint.z != 0)
 		//	for(int i = 0; i < 4; i++)
 		//	{
 		//		saliency.val[i] /= (mappedPoint.z + 2);
 		//	}
-		return saliency.val[0] + saliency.val[1] + saliency.val[2];
+		return _imageSaliency->ImageSum(mappedPoint);
 	}
 	else
 		return penaltyCost;
@@ -125,7 +117,7 @@ int GCScaleStackHorizontalEnergy::GetSmoothCost2(int labelId1, int labelId2, int
 	Point3D mappedPoint1 = point3D(pixelPoint1.x + labelPoint1.x, pixelPoint1.y + labelPoint1.y, pixelPoint1.z + labelPoint1.z);
 	Point3D mappedPoint2 = point3D(pixelPoint2.x + labelPoint2.x, pixelPoint2.y + labelPoint2.y, pixelPoint2.z + labelPoint2.z);
 
-	if(_imageSource->IsOutsideSource(mappedPoint1) || _imageSource->IsOutsideSource(mappedPoint2))
+	if(_imageSource->IsOutsidePacked(mappedPoint1) || _imageSource->IsOutsidePacked(mappedPoint2))
 		return 10000;
 	//return 50;
 	
@@ -138,20 +130,16 @@ int GCScaleStackHorizontalEnergy::GetSmoothCost2(int labelId1, int labelId2, int
 
 	int energy = 0;
 
-	if(_imageSource->IsOutsideSource(neighbor2) ||
-		_imageSource->IsOutsideSource(neighbor1))
+	if(_imageSource->IsOutsidePacked(neighbor2) ||
+		_imageSource->IsOutsidePacked(neighbor1))
 		return 10000;
 
-	energy += _imageSource->GetSquareColorDifference(mappedPoint1, neighbor2);
-	energy += _imageSource->GetSquareColorDifference(mappedPoint2, neighbor1);  
-
-	// gradient different term 
-	energy += 2 * _imageSource->GetSquareGradientDifference(mappedPoint2, neighbor1);
-	energy += 2 * _imageSource->GetSquareGradientDifference(mappedPoint1, neighbor2);
+	// color and (twice weighted) gradient different terms
+	energy += _imageSource->GetSmoothDifference(mappedPoint1, neighbor2, mappedPoint2, neighbor1, 2);
 	
 	//***** plus a term for real distance
-	CvSize firstLevel = _imageSource->GetImageSize(0);
-	CvSize secondLevel = _imageSource->GetImageSize(1);
+	CvSize firstLevel = cvSize(_imageSource->GetLevelWidth(0), _imageSource->GetLevelHeight(0));
+	CvSize secondLevel = cvSize(_imageSource->GetLevelWidth(1), _imageSource->GetLevelHeight(1));
 	// first put 2 mappedPoint to same scale
 	if(mappedPoint1.z == 1)
 	{
@@ -4,10 +4,10 @@
  int dataFunctionFHHierarchy(int pixel, int label, void *extraData)
  {
 	ForDataFHHierarchy* forData = (ForDataFHHierarchy*) extraData;
-	CvPoint* point = (*(forData->pointMapping))[pixel];
+	CvPoint* point = &(*(forData->pointMapping))[pixel];
 	
 	CvPoint origin;
-	CvPoint shift = GetShift(label, forData->shiftSize);
+	CvPoint shift = (*(forData->labelShifts))[label];
 	CvPoint guess = GetLabel(*point, forData->guess);
 	origin.x = point->x + shift.x + guess.x;
 	origin.y = point->y + shift.y + guess.y;
@@ -23,7 +23,7 @@
 	
 	// smooth cost with predefined region
 	int energy = 0;
-	value = cvGet2D(forData->maskNeighbor, point->y, point->x);
+	value = (*(forData->maskNeighbor))[pixel];
 	if(value.val[0] == 1)
 	{
 		// compare with up position
@@ -55,10 +55,10 @@
  int smoothFunctionFHHierarchy(int pixel1, int pixel2, int label1, int label2, void* extraData)
  {
 	ForSmoothFHHierarchy* data = (ForSmoothFHHierarchy*)extraData;
-	CvPoint* point1 = (*(data->pointMapping))[pixel1];
-	CvPoint* point2 = (*(data->pointMapping))[pixel2];
-	CvPoint shift1 = GetShift(label1, data->shiftSize);
-	CvPoint shift2 = GetShift(label2, data->shiftSize);
+	CvPoint* point1 = &(*(data->pointMapping))[pixel1];
+	CvPoint* point2 = &(*(data->pointMapping))[pixel2];
+	CvPoint shift1 = (*(data->labelShifts))[label1];
+	CvPoint shift2 = (*(data->labelShifts))[label2];
 	CvPoint guess1 = GetLabel(*point1, data->guess);
 	CvPoint guess2 = GetLabel(*point2, data->guess);
 	CvPoint origin1 = cvPoint(shift1.x + point1->x + guess1.x, shift1.y + point1->y + guess1.y);
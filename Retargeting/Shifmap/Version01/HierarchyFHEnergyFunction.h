@@ -16,9 +16,10 @@ struct ForDataFHHierarchy
 	IplImage* maskDataGradient;
 	IplImage* input;
 	IplImage* inputGradient;
-	IplImage* maskNeighbor;
+	vector<CvScalar>* maskNeighbor;
 	CvMat* guess;
-	vector<CvPoint*>* pointMapping;
+	vector<CvPoint>* pointMapping;
+	vector<CvPoint>* labelShifts;
 	CvSize inputSize;
 	CvSize shiftSize;
 };
@@ -28,7 +29,8 @@ struct ForSmoothFHHierarchy
 	IplImage* input;
 	IplImage* inputGradient;
 	CvMat* guess;
-	vector<CvPoint*>* pointMapping;
+	vector<CvPoint>* pointMapping;
+	vector<CvPoint>* labelShifts;
 	CvSize inputSize;
 	CvSize shiftSize;
 };
@@ -29,18 +29,19 @@ HierarchyFHShiftMap::~HierarchyFHShiftMap(void)
 //	return newMapping;
 //}
 
-vector<CvPoint*>* HierarchyFHShiftMap::InterpolatePointMapping(vector<CvPoint*>* pointMapping)
+vector<CvPoint>* HierarchyFHShiftMap::InterpolatePointMapping(vector<CvPoint>* pointMapping)
 {
-	vector<CvPoint*>* newPointMapping = new vector<CvPoint*>();
+	vector<CvPoint>* newPointMapping = new vector<CvPoint>();
 	
 	int pointCount = pointMapping->size();
+	newPointMapping->reserve(pointCount * 4);
 	for(int i = 0; i < pointCount; i++)
 	{
-		CvPoint* currentPoint = (*pointMapping)[i];
-		newPointMapping->push_back(CreateCvPoint(currentPoint->x, currentPoint->y));
-		newPointMapping->push_back(CreateCvPoint(currentPoint->x + 1, currentPoint->y));
-		newPointMapping->push_back(CreateCvPoint(currentPoint->x, currentPoint->y + 1));
-		newPointMapping->push_back(CreateCvPoint(currentPoint->x + 1, currentPoint->y + 1));
+		CvPoint currentPoint = (*pointMapping)[i];
+		newPointMapping->push_back(cvPoint(currentPoint.x, currentPoint.y));
+		newPointMapping->push_back(cvPoint(currentPoint.x + 1, currentPoint.y));
+		newPointMapping->push_back(cvPoint(currentPoint.x, currentPoint.y + 1));
+		newPointMapping->push_back(cvPoint(currentPoint.x + 1, currentPoint.y + 1));
 	}
 
 	return newPointMapping;
@@ -216,7 +217,8 @@ void HierarchyFHShiftMap::ComputeShiftMapGuess(IplImage* input, IplImage* salien
 
 		// first processing the mask (including neighborhood)	
 		// ProcessMask();
-		ProcessMask(_mask);
+		// labels are shifts from the guess, keep them all
+		ProcessMask(_mask, false);
 
 		// setup data cost & smooth cost for masked data
 		ForDataFHHierarchy dataCost;
@@ -225,6 +227,7 @@ void HierarchyFHShiftMap::ComputeShiftMapGuess(IplImage* input, IplImage* salien
 		cvSobel(_maskData, maskDataGradient, 1, 1);
 		dataCost.maskDataGradient = maskDataGradient;
 		dataCost.pointMapping = _pointMapping;
+		dataCost.labelShifts = _labelShifts;
 		dataCost.shiftSize = shiftSize;
 		dataCost.saliency = saliency;
 		dataCost.inputSize = cvSize(input->width, input->height);
@@ -240,6 +243,7 @@ void HierarchyFHShiftMap::ComputeShiftMapGuess(IplImage* input, IplImage* salien
 		smoothCost.inputGradient = inputGradient;
 		smoothCost.inputSize = cvSize(input->width, input->height);
 		smoothCost.pointMapping = _pointMapping;
+		smoothCost.labelShifts = _labelShifts;
 		smoothCost.shiftSize = shiftSize;
 		smoothCost.guess = guess;
 		_gcGeneral->setSmoothCost(&smoothFunctionFHHierarchy, &smoothCost);
@@ -254,7 +258,7 @@ void HierarchyFHShiftMap::ComputeShiftMapGuess(IplImage* input, IplImage* salien
 	}
 
 }
-CvMat* HierarchyFHShiftMap::CalculateLabelMapGuess(CvMat* intialGuess, vector<CvPoint*>* pointMapping, GCoptimizationGeneralGraph* gc)
+CvMat* HierarchyFHShiftMap::CalculateLabelMapGuess(CvMat* intialGuess, vector<CvPoint>* pointMapping, GCoptimizationGeneralGraph* gc)
 {
 	CvMat* output = cvCreateMat(intialGuess->height, intialGuess->width, CV_32SC2);
 	int num_pixels = pointMapping->size();
@@ -263,8 +267,8 @@ CvMat* HierarchyFHShiftMap::CalculateLabelMapGuess(CvMat* intialGuess, vector<Cv
 	for(int i = 0; i < num_pixels; i++)
 	{
 		int label = gc->whatLabel(i);		
-		CvPoint* point = (*(_pointMapping))[i];
-		CvPoint shift = GetShift(label, _shiftSize);
+		CvPoint* point = &(*(_pointMapping))[i];
+		CvPoint shift = (*_labelShifts)[label];
 		CvPoint guess = GetLabel(*point, intialGuess);		
 		CvPoint pointLabel = cvPoint(shift.x + guess.x, shift.y + guess.y);	
 
@@ -286,7 +290,7 @@ IplImage* HierarchyFHShiftMap::GetRetargetedImage(int level)
 	//	cvShowImage("Test", output);
 	//	cvWaitKey(100);
 	//}
-	vector<CvPoint*>* pointMapping = (*_pointMappingList)[level];
+	vector<CvPoint>* pointMapping = (*_pointMappingList)[level];
 	IplImage* image = (*_inputList)[level];
 	CvMat* labelMap = (*_labelMapList)[level];
 
@@ -296,7 +300,7 @@ IplImage* HierarchyFHShiftMap::GetRetargetedImage(int level)
 	
 	for(int i = 0; i < num_pixels; i++)
 	{
-		CvPoint point = *(*pointMapping)[i];
+		CvPoint point = (*pointMapping)[i];
 		CvPoint label = GetLabel(point, labelMap);
 		CvPoint mappedPoint = cvPoint(point.x + label.x, point.y + label.y);
 		
@@ -371,7 +375,7 @@ void HierarchyFHShiftMap::ComputeFastShiftMap2(IplImage* input, IplImage* salien
 
 	int levelCount = _maskList->size();
 	_labelMapList = new vector<CvMat*>();
-	_pointMappingList = new vector<vector<CvPoint*>*>();
+	_pointMappingList = new vector<vector<CvPoint>*>();
 	CvMat* guess;
 	CvMat* labelMap;
 
@@ -439,7 +443,7 @@ void HierarchyFHShiftMap::ComputeFastShiftMap(IplImage *input, IplImage *salienc
 
 	int levelCount = _maskList->size();
 	_labelMapList = new vector<CvMat*>();
-	_pointMappingList = new vector<vector<CvPoint*>*>();
+	_pointMappingList = new vector<vector<CvPoint>*>();
 	CvMat* guess;
 	CvMat* labelMap;
 
@@ -22,11 +22,11 @@ protected:
 	vector<IplImage*>* _inputList;
 	vector<IplImage*>* _saliencyList;
 	vector<CvMat*>* _labelMapList;
-	vector<vector<CvPoint*>*>* _pointMappingList;
+	vector<vector<CvPoint>*>* _pointMappingList;
 public:
 	virtual void ComputeShiftMapGuess(IplImage* input, IplImage* saliency, CvMat* guess, CvSize output, CvSize shiftSize);	
 
-	vector<CvPoint*>* InterpolatePointMapping(vector<CvPoint*>* pointMapping);
+	vector<CvPoint>* InterpolatePointMapping(vector<CvPoint>* pointMapping);
 
 	// interpolate the shift map from down 1 level
 	void InterpolateShiftMapping(CvMat* lowerMap, CvMat* higherMap);
@@ -46,6 +46,6 @@ public:
 	// mask is the same size as input & maskData will be auto-generated
 	void DownSamplingInput(IplImage* input, IplImage* saliency, IplImage* mask, CvSize outputSize, CvPoint shift);
 	
-	CvMat* CalculateLabelMapGuess(CvMat* intialGuess, vector<CvPoint*>* pointMapping, GCoptimizationGeneralGraph* gc);
+	CvMat* CalculateLabelMapGuess(CvMat* intialGuess, vector<CvPoint>* pointMapping, GCoptimizationGeneralGraph* gc);
 	void ClearGC();
 };
@@ -81,23 +81,23 @@ IplImage* HorizontalScaleSM::RenderRetargetImage()
 	GCoptimization* gc = _gc->GetGCoptimization();
 	int nodeCount = _outputSize.width * _outputSize.height;
 
+	RenderSample* samples = new RenderSample[nodeCount];
 	for(int i = 0; i < nodeCount; i++)
 	{
 		int label = gc->whatLabel(i);
 		CvPoint point = _mapping2D->GetMappedPoint(i);			
 		double mappedX = _labelMapping->GetMappedPoint(label, point.x);
-		 		
-		if(mappedX >= _input->width || mappedX < 0)
-		{
-			printf("Map outside");
-			cvSet2D(image, point.y, point.x, cvScalar(255));
-		}
-		else
-		{			 
-			CvScalar value = GetInterpolatedValue(mappedX, point.y, _input);
-			cvSet2D(image, point.y, point.x, value);			
-		}
+
+		RenderSample* sample = samples + point.y * _outputSize.width + point.x;
+		sample->x = mappedX;
+		sample->y = point.y;
+		sample->sourceId = (mappedX >= _input->width || mappedX < 0) ? -1 : 0;
 	}
+
+	int outsideCount = RenderImage(image, samples, &_input, RENDER_BILINEAR, cvScalar(255));
+	if(outsideCount > 0)
+		printf("Map outside: %d pixels\n", outsideCount);
+	delete[] samples;
 	//DisplayImage(image, "TEST");
 	return image;
 }
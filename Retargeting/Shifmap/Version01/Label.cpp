@@ -43,6 +43,11 @@ CvPoint GetShift(int label, CvSize shiftSize)
 	return shift;
 }
 
+int GetShiftLabel(CvPoint shift, CvSize shiftSize)
+{
+	return GetLabel(cvPoint(shift.x + shiftSize.width / 2, shift.y + shiftSize.height / 2), shiftSize);
+}
+
 CvPoint GetMappedPoint(int pixel, int label, CvSize output, CvSize shiftSize)
 {
 	CvPoint result;
@@ -17,6 +17,9 @@ CvPoint GetMappedPoint(int pixel, int label, CvSize output, CvSize shiftSize);
 
 CvPoint GetShift(int label, CvSize shiftSize);
 
+// label of a shift, inverse of GetShift. -1 if the shift is out of range
+int GetShiftLabel(CvPoint shift, CvSize shiftSize);
+
 void SetMapDataTerm(IplImage* map, int u, int v, double value);
 
 // width & height are default to be 3 (so 9 labels in total)
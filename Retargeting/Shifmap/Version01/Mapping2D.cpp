@@ -3,10 +3,15 @@
 
 Mapping2D::Mapping2D(void)
 {
+	_isShift = false;
+	_idCount = 0;
+	_points = NULL;
 }
 
 Mapping2D::~Mapping2D(void)
 {
+	if(_points != NULL)
+		delete[] _points;
 }
 
 void Mapping2D::InitializeMapping(int width, int height)
@@ -14,32 +19,34 @@ void Mapping2D::InitializeMapping(int width, int height)
 	_width = width;
 	_height = height;
 	_idCount = width * height;
+	BuildPointTable();
 }
 void Mapping2D::IsShift(bool isShift)
 {
 	_isShift = isShift;
+	BuildPointTable();
+}
+void Mapping2D::BuildPointTable()
+{
+	if(_points != NULL)
+		delete[] _points;
+	_points = new CvPoint[_idCount];
+
+	int offsetX = _isShift ? _width / 2 : 0;
+	int offsetY = _isShift ? _height / 2 : 0;
+	for(int y = 0; y < _height; y++)
+		for(int x = 0; x < _width; x++)
+		{
+			_points[y * _width + x].x = x - offsetX;
+			_points[y * _width + x].y = y - offsetY;
+		}
 }
 CvPoint Mapping2D::GetMappedPoint(int id)
 {
 	if(id >= _idCount)
 		return cvPoint(-1, -1);
 	
-	CvPoint point;
-	int y = id / _width;
-	int x = id % _width;
-	
-	if(_isShift)
-	{
-		point.x = x - _width / 2;
-		point.y = y - _height / 2;	
-	}
-	else
-	{
-		point.x = x;
-		point.y = y;
-	}
-	
-	return point;
+	return _points[id];
 }
 
 int Mapping2D::GetPointId(CvPoint point)
@@ -15,4 +15,7 @@ protected:
 	int _width;
 	int _height;
 	int _idCount;
+	// id -> point, rebuilt whenever the size or the shift changes
+	CvPoint* _points;
+	void BuildPointTable();
 };
@@ -28,8 +28,14 @@ void MappingCubic::IsShift(bool isShift)
 
 Point3D MappingCubic::GetMappedPoint(int id)
 { 
-		int level = id / _pixelLevelCount;
-		int level_id = id % _pixelLevelCount;
+		// the stack is only a few levels high, cheaper than / and %
+		int level = 0;
+		int level_id = id;
+		while(level_id >= _pixelLevelCount)
+		{
+			level_id -= _pixelLevelCount;
+			level++;
+		}
 		CvPoint point = _mapping2D->GetMappedPoint(level_id);
 		return point3D(point.x, point.y, level); 
 }
@@ -0,0 +1,122 @@
+#include "StdAfx.h"
+#include "MatCache.h"
+
+#define MAT_CACHE_MAGIC 0x434D4D53		// "SMMC"
+#define MAT_CACHE_VERSION 1
+
+struct MatCacheHeader
+{
+	int magic;
+	int version;
+	MatCacheKey key;
+	int rows;
+	int cols;
+};
+
+static bool IsSameKey(MatCacheKey key1, MatCacheKey key2)
+{
+	return key1.imageHash == key2.imageHash && key1.width == key2.width && key1.height == key2.height
+		&& key1.scaleX == key2.scaleX && key1.scaleY == key2.scaleY && key1.patchSize == key2.patchSize;
+}
+
+unsigned int ImageHash(IplImage* image)
+{
+	unsigned int hash = 2166136261u;
+	int rowBytes = image->width * image->nChannels * ((image->depth & 255) / 8);
+	for(int y = 0; y < image->height; y++)
+	{
+		unsigned char* row = (unsigned char*)(image->imageData + y * image->widthStep);
+		for(int i = 0; i < rowBytes; i++)
+		{
+			hash ^= row[i];
+			hash *= 16777619u;
+		}
+	}
+	return hash;
+}
+
+MatCacheKey matCacheKey(IplImage* image, unsigned int imageHash, double scaleX, double scaleY, int patchSize)
+{
+	MatCacheKey key;
+	memset(&key, 0, sizeof(MatCacheKey));
+	key.imageHash = imageHash;
+	key.width = image->width;
+	key.height = image->height;
+	key.scaleX = scaleX;
+	key.scaleY = scaleY;
+	key.patchSize = patchSize;
+	return key;
+}
+
+char* MatCacheFileName(char* folder, char* kind, MatCacheKey key)
+{
+	char* fileName = new char[strlen(folder) + strlen(kind) + 100];
+	sprintf(fileName, "%s/%s_%08x_%dx%d_%d_%d_%d.mat", folder, kind, key.imageHash, key.width, key.height,
+		(int)(key.scaleX * 10000 + 0.5), (int)(key.scaleY * 10000 + 0.5), key.patchSize);
+	return fileName;
+}
+
+CvMat* LoadCachedMat(char* fileName, MatCacheKey key)
+{
+	FILE* file = fopen(fileName, "rb");
+	if(file == NULL)
+		return NULL;
+
+	MatCacheHeader header;
+	if(fread(&header, sizeof(MatCacheHeader), 1, file) != 1
+		|| header.magic != MAT_CACHE_MAGIC || header.version != MAT_CACHE_VERSION
+		|| !IsSameKey(header.key, key))
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	CvMat* mat = cvCreateMat(header.rows, header.cols, CV_32FC1);
+	bool complete = true;
+	for(int i = 0; i < header.rows && complete; i++)
+		complete = fread(mat->data.ptr + i * mat->step, sizeof(float), header.cols, file) == (size_t)header.cols;
+	fclose(file);
+
+	if(!complete)
+	{
+		cvReleaseMat(&mat);
+		return NULL;
+	}
+	return mat;
+}
+
+bool SaveCachedMat(char* fileName, MatCacheKey key, CvMat* mat)
+{
+	// write to a temporary name first, a run stopped halfway leaves no broken file
+	char* tempName = new char[strlen(fileName) + 5];
+	sprintf(tempName, "%s.tmp", fileName);
+	FILE* file = fopen(tempName, "wb");
+	if(file == NULL)
+	{
+		delete[] tempName;
+		return false;
+	}
+
+	MatCacheHeader header;
+	memset(&header, 0, sizeof(MatCacheHeader));
+	header.magic = MAT_CACHE_MAGIC;
+	header.version = MAT_CACHE_VERSION;
+	header.key = key;
+	header.rows = mat->rows;
+	header.cols = mat->cols;
+
+	bool complete = fwrite(&header, sizeof(MatCacheHeader), 1, file) == 1;
+	for(int i = 0; i < mat->rows && complete; i++)
+		complete = fwrite(mat->data.ptr + i * mat->step, sizeof(float), mat->cols, file) == (size_t)mat->cols;
+	fclose(file);
+
+	remove(fileName);
+	if(!complete || rename(tempName, fileName) != 0)
+	{
+		remove(tempName);
+		delete[] tempName;
+		return false;
+	}
+	delete[] tempName;
+	return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cv.h>
+
+// what a cached matrix was computed from. Stored in the file header and
+// checked on load, so a hash collision or a stale file is just a miss
+struct MatCacheKey
+{
+	unsigned int imageHash;
+	int width;
+	int height;
+	double scaleX;
+	double scaleY;
+	int patchSize;
+};
+
+// FNV-1a over the pixel rows, padding of widthStep left out
+unsigned int ImageHash(IplImage* image);
+
+MatCacheKey matCacheKey(IplImage* image, unsigned int imageHash, double scaleX, double scaleY, int patchSize);
+
+// <folder>/<kind>_<hash>_<size>_<scale>_<patch>.mat, caller deletes
+char* MatCacheFileName(char* folder, char* kind, MatCacheKey key);
+
+// file is a header then the rows of a CV_32FC1 matrix as they lie in memory,
+// so it can be read (or mapped) straight into the matrix data.
+// NULL if there is no file for the key
+CvMat* LoadCachedMat(char* fileName, MatCacheKey key);
+bool SaveCachedMat(char* fileName, MatCacheKey key, CvMat* mat);
@@ -0,0 +1,252 @@
+#include "StdAfx.h"
+#include "PatchCost.h"
+
+const float PATCH_ZERO_PIXEL[3] = {0, 0, 0};
+
+PatchPlane* CreatePatchPlane(IplImage* image, double scaleX, double scaleY, int pad)
+{
+	PatchPlane* plane = new PatchPlane();
+
+	// GetInterpolatedValue is zero from x > width - 1 but only from y >= height
+	int width = 0;
+	while(width / scaleX <= image->width - 1)
+		width++;
+	int height = 0;
+	while(height / scaleY < image->height)
+		height++;
+
+	plane->width = width;
+	plane->height = height;
+	plane->pad = pad;
+	plane->stride = (width + 2 * pad) * 3;
+	plane->data = new float[plane->stride * (height + 2 * pad)];
+
+	for(int v = -pad; v < height + pad; v++)
+	{
+		float* row = plane->data + (v + pad) * plane->stride;
+		for(int u = -pad; u < width + pad; u++)
+		{
+			CvScalar value = GetInterpolatedValue(doublePoint(u / scaleX, v / scaleY), image);
+			float* pixel = row + (u + pad) * 3;
+			pixel[0] = value.val[0];
+			pixel[1] = value.val[1];
+			pixel[2] = value.val[2];
+		}
+	}
+	return plane;
+}
+
+void ReleasePatchPlane(PatchPlane* plane)
+{
+	delete[] plane->data;
+	delete plane;
+}
+
+int PlanePatchDifference(const PatchPlane* plane1, CvPoint point1, const PatchPlane* plane2, CvPoint point2, int size)
+{
+	int diff = 0;
+	for(int j = 0; j < size; j++)
+		for(int i = 0; i < size; i++)
+			diff += PlaneSquareDifference(PlanePixel(plane1, point1.x + i, point1.y + j),
+				PlanePixel(plane2, point2.x + i, point2.y + j));
+	return diff;
+}
+
+PatchCost::PatchCost(void)
+{
+	_labelMapping = NULL;
+	_patchSize = 0;
+	_planes = new vector<PatchPlane*>();
+	_source = NULL;
+	_maps = new vector<int*>();
+	_mapKeys = new vector<PatchMapKey>();
+	_mapIndex = new map<PatchMapKey, int>();
+	_missCount = new map<PatchMapKey, int>();
+	_nextMap = 0;
+	_cacheSize = 32;
+}
+
+PatchCost::~PatchCost(void)
+{
+	Clear();
+	delete _planes;
+	delete _maps;
+	delete _mapKeys;
+	delete _mapIndex;
+	delete _missCount;
+}
+
+void PatchCost::Clear()
+{
+	for(int i = 0; i < (int)_planes->size(); i++)
+		ReleasePatchPlane((*_planes)[i]);
+	_planes->clear();
+	if(_source != NULL)
+		ReleasePatchPlane(_source);
+	_source = NULL;
+
+	for(int i = 0; i < (int)_maps->size(); i++)
+		delete[] (*_maps)[i];
+	_maps->clear();
+	_mapKeys->clear();
+	_mapIndex->clear();
+	_missCount->clear();
+	_nextMap = 0;
+}
+
+void PatchCost::Initialize(IplImage* image, ScaleLabelMapping* labelMapping, int patchSize)
+{
+	Clear();
+	_labelMapping = labelMapping;
+	_patchSize = patchSize;
+
+	// wide enough border for both the centered smooth patches and the
+	// distortion patches, which start at the point
+	int pad = patchSize + 2;
+	for(int i = 0; i < labelMapping->GetScaleCount(); i++)
+		_planes->push_back(CreatePatchPlane(image, labelMapping->GetScaleX(i), labelMapping->GetScaleY(i), pad));
+	_source = CreatePatchPlane(image, 1, 1, pad);
+}
+
+void PatchCost::SetCacheSize(int count)
+{
+	for(int i = 0; i < (int)_maps->size(); i++)
+		delete[] (*_maps)[i];
+	_maps->clear();
+	_mapKeys->clear();
+	_mapIndex->clear();
+	_missCount->clear();
+	_nextMap = 0;
+	_cacheSize = count;
+}
+
+int PatchCost::GetPatchSize()
+{
+	return _patchSize;
+}
+
+PatchPlane* PatchCost::GetPlane(int scaleId)
+{
+	return (*_planes)[scaleId];
+}
+
+PatchPlane* PatchCost::GetSourcePlane()
+{
+	return _source;
+}
+
+PatchMapKey PatchCost::MapKey(int scaleId1, int scaleId2, int shiftX, int shiftY)
+{
+	// every field kept whole, so any number of scales or shift range is distinct
+	return PatchMapKey(pair<int, int>(scaleId1, scaleId2), pair<int, int>(shiftX, shiftY));
+}
+
+int* PatchCost::GetDifferenceMap(int scaleId1, int scaleId2, int shiftX, int shiftY)
+{
+	PatchMapKey key = MapKey(scaleId1, scaleId2, shiftX, shiftY);
+	map<PatchMapKey, int>::iterator found = _mapIndex->find(key);
+	if(found != _mapIndex->end())
+		return (*_maps)[found->second];
+
+	PatchPlane* plane1 = (*_planes)[scaleId1];
+	PatchPlane* plane2 = (*_planes)[scaleId2];
+	int size = _patchSize * 2 + 1;
+	int width = plane1->width;
+	int height = plane1->height;
+
+	// a map costs about one patch compare per size * size pixels; build it once
+	// the direct compares for this key have cost as much
+	int& misses = (*_missCount)[key];
+	if(++misses * size * size < width * height)
+		return NULL;
+	_missCount->erase(key);
+	int paddedWidth = width + size - 1;
+	int paddedHeight = height + size - 1;
+
+	// pixel differences over the plane and the patch border around it
+	int* diff = new int[paddedWidth * paddedHeight];
+	for(int y = 0; y < paddedHeight; y++)
+		for(int x = 0; x < paddedWidth; x++)
+		{
+			int u = x - _patchSize;
+			int v = y - _patchSize;
+			diff[y * paddedWidth + x] = PlaneSquareDifference(PlanePixel(plane1, u, v),
+				PlanePixel(plane2, u + shiftX, v + shiftY));
+		}
+
+	// box sum along rows then columns
+	int* rows = new int[width * paddedHeight];
+	for(int y = 0; y < paddedHeight; y++)
+	{
+		int* diffRow = diff + y * paddedWidth;
+		int sum = 0;
+		for(int x = 0; x < size; x++)
+			sum += diffRow[x];
+		rows[y * width] = sum;
+		for(int x = 1; x < width; x++)
+		{
+			sum += diffRow[x + size - 1] - diffRow[x - 1];
+			rows[y * width + x] = sum;
+		}
+	}
+	delete[] diff;
+
+	int* result = new int[width * height];
+	for(int x = 0; x < width; x++)
+	{
+		int sum = 0;
+		for(int y = 0; y < size; y++)
+			sum += rows[y * width + x];
+		result[x] = sum;
+		for(int y = 1; y < height; y++)
+		{
+			sum += rows[(y + size - 1) * width + x] - rows[(y - 1) * width + x];
+			result[y * width + x] = sum;
+		}
+	}
+	delete[] rows;
+
+	// keep it, dropping the oldest map when the cache is full
+	int slot;
+	if((int)_maps->size() < _cacheSize)
+	{
+		slot = _maps->size();
+		_maps->push_back(result);
+		_mapKeys->push_back(key);
+	}
+	else
+	{
+		slot = _nextMap;
+		_nextMap = (_nextMap + 1) % _cacheSize;
+		_mapIndex->erase((*_mapKeys)[slot]);
+		delete[] (*_maps)[slot];
+		(*_maps)[slot] = result;
+		(*_mapKeys)[slot] = key;
+	}
+	(*_mapIndex)[key] = slot;
+	return result;
+}
+
+int PatchCost::GetPatchDifference(CvPoint point, int labelId1, int labelId2)
+{
+	int scaleId1 = _labelMapping->GetScaleId(labelId1);
+	int scaleId2 = _labelMapping->GetScaleId(labelId2);
+	CvPoint shifted1 = _labelMapping->GetMappedPointInt(labelId1, point);
+	CvPoint shifted2 = _labelMapping->GetMappedPointInt(labelId2, point);
+
+	int size = _patchSize * 2 + 1;
+	PatchPlane* plane1 = (*_planes)[scaleId1];
+	if(shifted1.x < 0 || shifted1.x >= plane1->width || shifted1.y < 0 || shifted1.y >= plane1->height || _cacheSize <= 0)
+	{
+		// label maps outside the image, no map covers it
+		int diff = PlanePatchDifference(plane1, cvPoint(shifted1.x - _patchSize, shifted1.y - _patchSize),
+			(*_planes)[scaleId2], cvPoint(shifted2.x - _patchSize, shifted2.y - _patchSize), size);
+		return diff / (size * size);
+	}
+
+	int* diffMap = GetDifferenceMap(scaleId1, scaleId2, shifted2.x - shifted1.x, shifted2.y - shifted1.y);
+	if(diffMap == NULL)
+		return PlanePatchDifference(plane1, cvPoint(shifted1.x - _patchSize, shifted1.y - _patchSize),
+			(*_planes)[scaleId2], cvPoint(shifted2.x - _patchSize, shifted2.y - _patchSize), size) / (size * size);
+	return diffMap[shifted1.y * plane1->width + shifted1.x] / (size * size);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+#include <map>
+using namespace std;
+#include <cv.h>
+#include "ScaleLabelMapping.h"
+
+// an image resampled at one scale of a ScaleLabelMapping, 3 floats per pixel.
+// Pixel (u,v) holds the image at (u / scaleX, v / scaleY), so a label reads
+// point p at p + shift with no interpolation. The border of pad pixels and
+// anything outside the image are zero, as GetInterpolatedValue gives
+struct PatchPlane
+{
+	float* data;
+	int width;		// pixels that can map inside the image
+	int height;
+	int pad;
+	int stride;		// floats per row, border included
+};
+
+PatchPlane* CreatePatchPlane(IplImage* image, double scaleX, double scaleY, int pad);
+void ReleasePatchPlane(PatchPlane* plane);
+
+extern const float PATCH_ZERO_PIXEL[3];
+
+inline const float* PlanePixel(const PatchPlane* plane, int u, int v)
+{
+	if(u < -plane->pad || u >= plane->width + plane->pad || v < -plane->pad || v >= plane->height + plane->pad)
+		return PATCH_ZERO_PIXEL;
+	return plane->data + (v + plane->pad) * plane->stride + (u + plane->pad) * 3;
+}
+
+// same as SquareDifference
+inline int PlaneSquareDifference(const float* value1, const float* value2)
+{
+	double diff0 = value1[0] - value2[0];
+	double diff1 = value1[1] - value2[1];
+	double diff2 = value1[2] - value2[2];
+	return diff0 * diff0 + diff1 * diff1 + diff2 * diff2;
+}
+
+// sum of square differences of two size x size patches, given by their top left points
+int PlanePatchDifference(const PatchPlane* plane1, CvPoint point1, const PatchPlane* plane2, CvPoint point2, int size);
+
+// key of a difference map: ((scale id 1, scale id 2), (shift x, shift y))
+typedef pair<pair<int, int>, pair<int, int> > PatchMapKey;
+
+// patch costs between labels of a ScaleLabelMapping. The difference of the
+// patches two labels put at a point only depends on their scales and the
+// difference of their shifts, so it can be box filtered once over the whole 
+// plane for that key and every later query is a lookup. A map only pays off 
+// for keys asked for about as often as a map costs in patch compares, so the 
+// other queries compare the patches directly. Maps are kept in a small first 
+// in first out cache
+class PatchCost
+{
+public:
+	PatchCost(void);
+	~PatchCost(void);
+protected:
+	ScaleLabelMapping* _labelMapping;
+	// radius, as in GetPatchDifference
+	int _patchSize;
+	// one plane per scale, and the image itself
+	vector<PatchPlane*>* _planes;
+	PatchPlane* _source;
+	// box filtered ssd maps, over the plane of the first scale of their key
+	vector<int*>* _maps;
+	// (scale ids, shift difference), as made by MapKey
+	vector<PatchMapKey>* _mapKeys;
+	map<PatchMapKey, int>* _mapIndex;
+	// times each key without a map has been asked for
+	map<PatchMapKey, int>* _missCount;
+	int _nextMap;
+	int _cacheSize;
+protected:
+	PatchMapKey MapKey(int scaleId1, int scaleId2, int shiftX, int shiftY);
+	// the map of the key, NULL while the key has not been asked for often enough
+	int* GetDifferenceMap(int scaleId1, int scaleId2, int shiftX, int shiftY);
+	void Clear();
+public:
+	void Initialize(IplImage* image, ScaleLabelMapping* labelMapping, int patchSize);
+	// number of difference maps kept
+	void SetCacheSize(int count);
+	int GetPatchSize();
+	PatchPlane* GetPlane(int scaleId);
+	PatchPlane* GetSourcePlane();
+	// same as GetPatchDifference(point, point, labelId1, labelId2, image, labelMapping, patchSize)
+	int GetPatchDifference(CvPoint point, int labelId1, int labelId2);
+};
@@ -0,0 +1,86 @@
+#include "StdAfx.h"
+#include "RenderKernel.h"
+
+static inline unsigned char SaturateValue(double value)
+{
+	int rounded = cvRound(value);
+	if(rounded < 0)
+		return 0;
+	if(rounded > 255)
+		return 255;
+	return (unsigned char)rounded;
+}
+
+// weight * GetInterpolatedValue(x, y, source) added to value
+static inline void AddRowValue(IplImage* source, double x, int y, double weight, double* value, int channels)
+{
+	if(x < 0 || x > source->width - 1 || y < 0 || y > source->height - 1)
+		return;
+
+	int xInt = (int)floor(x);
+	double weightX = x - xInt;
+	unsigned char* pixel = (unsigned char*)(source->imageData + y * source->widthStep) + xInt * source->nChannels;
+	if(weightX == 0)
+	{
+		for(int c = 0; c < channels; c++)
+			value[c] += weight * pixel[c];
+	}
+	else
+	{
+		unsigned char* next = pixel + source->nChannels;
+		for(int c = 0; c < channels; c++)
+			value[c] += weight * (pixel[c] * (1 - weightX) + next[c] * weightX);
+	}
+}
+
+int RenderImage(IplImage* output, const RenderSample* samples, IplImage** sources, int sampling, CvScalar outsideValue)
+{
+	int width = output->width;
+	int height = output->height;
+	int channels = MIN(output->nChannels, 4);
+	unsigned char outside[4];
+	for(int c = 0; c < 4; c++)
+		outside[c] = SaturateValue(outsideValue.val[c]);
+
+	int outsideCount = 0;
+	int tileCount = (height + RENDER_TILE_ROWS - 1) / RENDER_TILE_ROWS;
+	#pragma omp parallel for schedule(dynamic) reduction(+:outsideCount)
+	for(int tile = 0; tile < tileCount; tile++)
+	{
+		int bottom = MIN((tile + 1) * RENDER_TILE_ROWS, height);
+		for(int y = tile * RENDER_TILE_ROWS; y < bottom; y++)
+		{
+			unsigned char* row = (unsigned char*)(output->imageData + y * output->widthStep);
+			const RenderSample* sample = samples + y * width;
+			for(int x = 0; x < width; x++, sample++)
+			{
+				unsigned char* pixel = row + x * output->nChannels;
+				if(sample->sourceId < 0)
+				{
+					for(int c = 0; c < channels; c++)
+						pixel[c] = outside[c];
+					outsideCount++;
+					continue;
+				}
+
+				IplImage* source = sources[sample->sourceId];
+				double value[4] = {0, 0, 0, 0};
+				if(sampling == RENDER_NEAREST)
+				{
+					AddRowValue(source, floor(sample->x + 0.5), (int)floor(sample->y + 0.5), 1, value, channels);
+				}
+				else
+				{
+					int yInt = (int)floor(sample->y);
+					double weightY = sample->y - yInt;
+					AddRowValue(source, sample->x, yInt, 1 - weightY, value, channels);
+					if(weightY != 0)
+						AddRowValue(source, sample->x, yInt + 1, weightY, value, channels);
+				}
+				for(int c = 0; c < channels; c++)
+					pixel[c] = SaturateValue(value[c]);
+			}
+		}
+	}
+	return outsideCount;
+}
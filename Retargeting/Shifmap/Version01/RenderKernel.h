@@ -0,0 +1,27 @@
+#pragma once
+#include <cv.h>
+
+// sampling of RenderImage
+#define RENDER_NEAREST 0
+#define RENDER_BILINEAR 1
+
+// rows of output rendered by one thread at a time
+#define RENDER_TILE_ROWS 16
+
+// where an output pixel takes its value from: point (x, y) of source sourceId.
+// sourceId < 0 marks a pixel which is mapped outside
+struct RenderSample
+{
+	float x;
+	float y;
+	int sourceId;
+};
+
+// fill output from the sources, reading and writing the image rows directly.
+// Tiles of rows are rendered on several threads
+// samples: one per output pixel, row by row
+// sources: 8 bit images with the channels of output
+// bilinear sampling gives the same values as GetInterpolatedValue, zero outside
+// the source. Nearest takes the pixel at the rounded point
+// return the number of pixels mapped outside, which get outsideValue
+int RenderImage(IplImage* output, const RenderSample* samples, IplImage** sources, int sampling, CvScalar outsideValue);
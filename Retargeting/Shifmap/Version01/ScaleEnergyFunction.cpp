@@ -6,10 +6,42 @@ ScaleEnergyFunction::ScaleEnergyFunction(void)
 {
 	_dataCostType = DATA_ORIGIN;
 	_smoothCostType = SMOOTH_ORIGIN;
+	_smoothPatchSize = 1;
+	_imagePatchCost = NULL;
+	_gradientPatchCost = NULL;
 }
 
 ScaleEnergyFunction::~ScaleEnergyFunction(void)
 {
+	ResetPatchCost();
+}
+
+void ScaleEnergyFunction::ResetPatchCost()
+{
+	if(_imagePatchCost != NULL)
+		delete _imagePatchCost;
+	if(_gradientPatchCost != NULL)
+		delete _gradientPatchCost;
+	_imagePatchCost = NULL;
+	_gradientPatchCost = NULL;
+}
+
+PatchCost* ScaleEnergyFunction::GetPatchCost(IplImage* image)
+{
+	PatchCost** patchCost;
+	if(image == _image)
+		patchCost = &_imagePatchCost;
+	else if(image == _gradient)
+		patchCost = &_gradientPatchCost;
+	else
+		return NULL;
+
+	if(*patchCost == NULL)
+	{
+		*patchCost = new PatchCost();
+		(*patchCost)->Initialize(image, _labelMapping, _smoothPatchSize);
+	}
+	return *patchCost;
 }
 
 
@@ -27,11 +59,13 @@ void ScaleEnergyFunction::SetInput(IplImage* image, IplImage* gradient, IplImage
 	_image = image;
 	_gradient = gradient;
 	_saliency = saliency;
+	ResetPatchCost();
 }
 
 void ScaleEnergyFunction::SetLabelMapping(ScaleLabelMapping* labelMapping)
 {
 	_labelMapping = labelMapping;
+	ResetPatchCost();
 }
 
 void ScaleEnergyFunction::SetMaxSalLargerImage(int max)
@@ -42,6 +76,7 @@ void ScaleEnergyFunction::SetMaxSalLargerImage(int max)
 void ScaleEnergyFunction::SetSmoothCostPatchSize(int patchSize)
 {
 	_smoothPatchSize = patchSize;
+	ResetPatchCost();
 }
 
 void ScaleEnergyFunction::SetMapping2D(Mapping2D* mapping2D)
@@ -81,9 +116,17 @@ int ScaleEnergyFunction::GetSmoothCostPatch(int labelId1, int labelId2, int node
 	if(!IsInside(mappedNeighbor1, _inputSize) || !IsInside(mappedNeighbor2, _inputSize))
 		return penaltyCost;
 
-	energy += GetPatchDifference(point2, point2, labelId1, labelId2, _image, _labelMapping, patchsize);
-	energy += GetPatchDifference(point1, point1, labelId1, labelId2, _image, _labelMapping, patchsize);
-	
+	if(patchsize == _smoothPatchSize)
+	{
+		PatchCost* imageCost = GetPatchCost(_image);
+		energy += imageCost->GetPatchDifference(point2, labelId1, labelId2);
+		energy += imageCost->GetPatchDifference(point1, labelId1, labelId2);
+	}
+	else
+	{
+		energy += GetPatchDifference(point2, point2, labelId1, labelId2, _image, _labelMapping, patchsize);
+		energy += GetPatchDifference(point1, point1, labelId1, labelId2, _image, _labelMapping, patchsize);
+	}
 	 
 	return energy;
 }
@@ -122,10 +165,22 @@ int ScaleEnergyFunction::GetSmoothCostPreventCrossingPatch(int labelId1, int lab
 	if(!IsInside(mappedNeighbor1, _inputSize) || !IsInside(mappedNeighbor2, _inputSize))
 		return penaltyCost;
 
-	energy += GetPatchDifference(point2, point2, labelId1, labelId2, _image, _labelMapping, patchsize);
-	energy += GetPatchDifference(point1, point1, labelId1, labelId2, _image, _labelMapping, patchsize);
-	energy += GetPatchDifference(point2, point2, labelId1, labelId2, _gradient, _labelMapping, patchsize);
-	energy += GetPatchDifference(point1, point1, labelId1, labelId2, _gradient, _labelMapping, patchsize);
+	if(patchsize == _smoothPatchSize)
+	{
+		PatchCost* imageCost = GetPatchCost(_image);
+		PatchCost* gradientCost = GetPatchCost(_gradient);
+		energy += imageCost->GetPatchDifference(point2, labelId1, labelId2);
+		energy += imageCost->GetPatchDifference(point1, labelId1, labelId2);
+		energy += gradientCost->GetPatchDifference(point2, labelId1, labelId2);
+		energy += gradientCost->GetPatchDifference(point1, labelId1, labelId2);
+	}
+	else
+	{
+		energy += GetPatchDifference(point2, point2, labelId1, labelId2, _image, _labelMapping, patchsize);
+		energy += GetPatchDifference(point1, point1, labelId1, labelId2, _image, _labelMapping, patchsize);
+		energy += GetPatchDifference(point2, point2, labelId1, labelId2, _gradient, _labelMapping, patchsize);
+		energy += GetPatchDifference(point1, point1, labelId1, labelId2, _gradient, _labelMapping, patchsize);
+	}
 
 	return energy;
 }
@@ -268,6 +323,30 @@ int ScaleEnergyFunction::GetDistortionCostPatch(vector<CvScalar>* points, CvPoin
 
 int ScaleEnergyFunction::GetDistortionCost(CvPoint point, IplImage* image, int label, int patch_size, double scaleX, double scaleY)
 {
+	PatchCost* patchCost = GetPatchCost(image);
+	if(patchCost != NULL)
+	{
+		// label patch read straight from its scale plane, compared against the image itself
+		PatchPlane* scaledPlane = patchCost->GetPlane(_labelMapping->GetScaleId(label));
+		PatchPlane* sourcePlane = patchCost->GetSourcePlane();
+		CvPoint shifted = _labelMapping->GetMappedPointInt(label, point);
+
+		int scaled_patch_size = patch_size / scaleX * scaleY;
+		DoublePoint mappedPoint = _labelMapping->GetMappedPoint(label, point);
+		int x = (int)mappedPoint.x;
+		int y = (int)mappedPoint.y;
+
+		int minDistortion = 10000000;
+		for(int i = x; i < x + scaled_patch_size - patch_size + 1; i++)
+			for(int j = y; j < y + scaled_patch_size - patch_size + 1; j++)
+			{
+				int distortion = PlanePatchDifference(scaledPlane, shifted, sourcePlane, cvPoint(i, j), patch_size);
+				if(distortion < minDistortion)
+					minDistortion = distortion;
+			}
+		return minDistortion;
+	}
+
 	vector<CvScalar>* scaled_points = new vector<CvScalar>(patch_size * patch_size);
 	for(int i = 0; i < patch_size; i++)
 		for(int j = 0; j < patch_size; j++)
@@ -418,7 +497,7 @@ int ScaleEnergyFunction::GetDataCostReverseThreshold(int labelId, int nodeId, in
 
 int ScaleEnergyFunction::GetDataCost(int labelId, int nodeId)
 {
-	int penaltyCost = 5000000;
+	int penaltyCost = SCALE_DATA_PENALTY;
 
 	switch(_dataCostType)
 	{
@@ -485,7 +564,7 @@ int ScaleEnergyFunction::GetSmoothCostWarpOnly(int labelId1, int labelId2, int n
 
 int ScaleEnergyFunction::GetSmoothCost(int labelId1, int labelId2, int nodeId1, int nodeId2)
 {
-	int penaltyCost = 50000;
+	int penaltyCost = SCALE_SMOOTH_PENALTY;
 	//return GetSmoothCostThreshold(labelId1, labelId2, nodeId1, nodeId2, penaltyCost, _smoothThreshold);
 	return GetSmoothCostOrigin(labelId1, labelId2, nodeId1, nodeId2, penaltyCost);
 	// return GetSmoothCostWarpOnly(labelId1, labelId2, nodeId1, nodeId2, penaltyCost, 2);
@@ -3,6 +3,7 @@
 #include "ScaleLabelMapping.h"
 #include "Mapping2D.h"
 #include "PatchUtils.h"
+#include "PatchCost.h"
 #include "DebugTool.h"
 
 #define SMOOTH_ORIGIN 1
@@ -12,8 +13,15 @@
 #define DATA_AREA 1
 #define DATA_ORIGIN 2
 
+#define SCALE_DATA_PENALTY 5000000
+#define SCALE_SMOOTH_PENALTY 50000
+
+template <int DataCostType> class GCScaleEnergyBinding;
+
 class ScaleEnergyFunction: public GCEnergyFunction
 {
+	// calls the cost type it was made for directly
+	template <int DataCostType> friend class GCScaleEnergyBinding;
 public:
 	ScaleEnergyFunction(void);
 	~ScaleEnergyFunction(void);
@@ -38,6 +46,11 @@ protected:
 	int _smoothPatchSize;
 	int _smoothThreshold;
 
+	// resampled planes and patch difference maps of _image and _gradient,
+	// made on first use
+	PatchCost* _imagePatchCost;
+	PatchCost* _gradientPatchCost;
+
 	 
 
 #pragma region area weight
@@ -55,6 +68,7 @@ public:
 	void SetMaxSalLargerImage(int max);
 	void SetSmoothCostPatchSize(int patchSize);
 	void SetDataCostType(int type);
+	int GetDataCostType() { return _dataCostType; }
 	void SetSmoothCostType(int type);
 	void InitAreaCost();
 	void SetupAreaCost(double area, double distrotion, double smooth);	
@@ -103,5 +117,8 @@ protected:
 // extra inside helpers
 protected:
 	bool IsSatisfiedBoundary(int x, double mappedX, int inputSize, int outputSize);
+	// patch cost of _image or _gradient, NULL for other images
+	PatchCost* GetPatchCost(IplImage* image);
+	void ResetPatchCost();
  
 };
\ No newline at end of file
@@ -3,10 +3,38 @@
 
 ScaleLabelMapping::ScaleLabelMapping(void)
 {
+	_labels = NULL;
+	_labelCount = 0;
 }
 
 ScaleLabelMapping::~ScaleLabelMapping(void)
 {
+	if(_labels != NULL)
+		delete[] _labels;
+}
+
+void ScaleLabelMapping::BuildLabelTable(bool isWarp)
+{
+	if(_labels != NULL)
+		delete[] _labels;
+	_labelCount = CountLevelLabel(_labelCountLevel);
+	_labels = new ScaleLabel[_labelCount];
+
+	int label = 0;
+	int levelCount = _labelCountLevel->size();
+	for(int i = 0; i < levelCount; i++)
+	{
+		int labelCountX = (*_labelCountLevelX)[i];
+		int minShiftX = isWarp ? (*_labelMinLevelX)[i] : 0;
+		int minShiftY = isWarp ? (*_labelMinLevelY)[i] : 0;
+		for(int shiftId = 0; shiftId < (*_labelCountLevel)[i]; shiftId++, label++)
+		{
+			_labels[label].scaleId = i;
+			_labels[label].shiftX = shiftId % labelCountX + minShiftX;
+			_labels[label].shiftY = shiftId / labelCountX + minShiftY;
+			_labels[label].reserved = 0;
+		}
+	}
 }
 
 int ScaleLabelMapping::CountLevelLabel(vector<int>* labelCountLevel)
@@ -93,6 +121,7 @@ void ScaleLabelMapping::InitScaleRange(CvSize inputSize, CvSize outputSize, int
 		int labelCount = (*_labelCountLevelX)[i] * (*_labelCountLevelY)[i];		
 		_labelCountLevel->push_back(labelCount);
 	} 
+	BuildLabelTable(false);
 }
 double ScaleLabelMapping::GetScaleX(int scaleId)
 {
@@ -125,16 +154,17 @@ void ScaleLabelMapping::InitWarpScaleRange(CvSize inputSize, CvSize outputSize,
 		int labelCount = (*_labelCountLevelX)[i] * (*_labelCountLevelY)[i];		
 		_labelCountLevel->push_back(labelCount);
 	} 
+	BuildLabelTable(true);
 }
 
 int ScaleLabelMapping::GetScaleId(int label)
 {	 
-	return GetScaleId(label, _scaleCount, _labelCountLevel);
+	return _labels[label].scaleId;
 }
 
 int ScaleLabelMapping::GetLabelCount()
 {
-	return CountLevelLabel(_labelCountLevel);
+	return _labelCount;
 }
 
 int ScaleLabelMapping::GetScaleCount()
@@ -172,30 +202,9 @@ int ScaleLabelMapping::GetScaleId(int label, int scaleCount, vector<int>* labelC
 }
 DoublePoint ScaleLabelMapping::GetMappedScalePoint(int labelId, CvPoint point)
 {
-	int scaleId;
-	int shiftId;
-
-	int labelIdTemp = labelId;
-	for(int i = 0; i < _scaleCount; i++)
-	{
-		int labelCount = (*_labelCountLevel)[i];
-		if(labelId > labelCount - 1)
-		{
-			labelId = labelId - labelCount;
-		}
-		else
-		{
-			scaleId = i;
-			shiftId = labelId;
-			break;
-		}
-	}
-
-
-	int labelCountX = (*_labelCountLevelX)[scaleId];
-
-	int shiftIdX = shiftId % labelCountX;
-	int shiftIdY = shiftId / labelCountX;
+	int scaleId = _labels[labelId].scaleId;
+	int shiftIdX = _labels[labelId].shiftX;
+	int shiftIdY = _labels[labelId].shiftY;
 
 	double scaleX = 1 - scaleId * _scaleStepX;
 	double scaleY = 1 - scaleId * _scaleStepY;
@@ -220,34 +229,10 @@ DoublePoint ScaleLabelMapping::GetMappedScalePoint(int labelId, CvPoint point)
 }
 DoublePoint ScaleLabelMapping::GetMappedWarpPoint(int labelId, CvPoint point, vector<double>* scaleListX, vector<double>* scaleListY)
 {
-	int scaleId;
-	int shiftId;
-
-	int labelIdTemp = labelId;
-	int scaleCount = scaleListX->size();
-	
-	for(int i = 0; i < scaleCount; i++)
-	{
-		int labelCount = (*_labelCountLevel)[i];
-		if(labelId > labelCount - 1)
-		{
-			labelId = labelId - labelCount;
-		}
-		else
-		{
-			scaleId = i;
-			shiftId = labelId;
-			break;
-		}
-	}
-	
-	int labelCountX = (*_labelCountLevelX)[scaleId];
-
-	int shiftIdX = shiftId % labelCountX;
-	int shiftIdY = shiftId / labelCountX;
- 
-	shiftIdX += (*_labelMinLevelX)[scaleId];
-	shiftIdY += (*_labelMinLevelY)[scaleId];
+	ScaleLabel& label = _labels[labelId];
+	int scaleId = label.scaleId;
+	int shiftIdX = label.shiftX;
+	int shiftIdY = label.shiftY;
 
 	double scaleX = (*scaleListX)[scaleId];
 	double scaleY = (*scaleListY)[scaleId];
@@ -266,38 +251,11 @@ DoublePoint ScaleLabelMapping::GetMappedPoint(int labelId, CvPoint point)
 
 CvPoint ScaleLabelMapping::GetMappedPointInt(int labelId, CvPoint point)
 {
-	int scaleId;
-	int shiftId;
-
-	int labelIdTemp = labelId;
-	int scaleCount = _scaleListX->size();
-	
-	for(int i = 0; i < _scaleCount; i++)
-	{
-		int labelCount = (*_labelCountLevel)[i];
-		if(labelId > labelCount - 1)
-		{
-			labelId = labelId - labelCount;
-		}
-		else
-		{
-			scaleId = i;
-			shiftId = labelId;
-			break;
-		}
-	}
-	
-	int labelCountX = (*_labelCountLevelX)[scaleId];
-
-	int shiftIdX = shiftId % labelCountX;
-	int shiftIdY = shiftId / labelCountX;
- 
-	shiftIdX += (*_labelMinLevelX)[scaleId];
-	shiftIdY += (*_labelMinLevelY)[scaleId];
+	ScaleLabel& label = _labels[labelId];
 	
 	CvPoint result;
-	result.x = point.x + shiftIdX;
-	result.y = point.y + shiftIdY;
+	result.x = point.x + label.shiftX;
+	result.y = point.y + label.shiftY;
 	return result;
 }
 
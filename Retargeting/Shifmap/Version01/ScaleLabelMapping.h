@@ -4,7 +4,16 @@ using namespace std;
 #include <cv.h>
 #include "PatchUtils.h"
 
-
+// what a label stands for, tabulated once by InitScaleRange/InitWarpScaleRange. 
+// Shifts are bounded by the image size, so 16 bits hold them and the table 
+// stays at 8 bytes per label however large the label set gets
+struct ScaleLabel
+{
+	short scaleId;
+	short shiftX;
+	short shiftY;
+	short reserved;
+};
 
 class ScaleLabelMapping
 {
@@ -27,7 +36,13 @@ protected:
 	vector<double>* _scaleListY;
 	CvSize _inputSize;
 	CvSize _outputSize;
+	// label -> scale and shift
+	ScaleLabel* _labels;
+	int _labelCount;
 protected:
+	// fill _labels from the per level label counts, adding the minimum 
+	// shift of each level for warp labels
+	void BuildLabelTable(bool isWarp);
 	// counting number of labels each level
 	int CountLevelLabel(vector<int>* labelCountLevel);
 	// init scale range for one direction (vertical or horizontal)
@@ -5,10 +5,13 @@ ScaleSM::ScaleSM(void)
 {
 	_mapping2D = new Mapping2D();
 	_energyFunction = new ScaleEnergyFunction();
+	_gc = NULL;
 }
 
 ScaleSM::~ScaleSM(void)
 {
+	if(_gc != NULL)
+		delete _gc;
 }
 
 void ScaleSM::SetSmoothThreshold(int threshold)
@@ -41,10 +44,7 @@ void ScaleSM::InitGraphCut(IplImage* image, IplImage* saliency, CvSize outputSiz
 	_input = image;
 	_outputSize = outputSize;
 
-	
-
-	IplImage* gradient = cvCloneImage(image);			
-	cvSobel(image, gradient, 1, 1);	
+	// gradient is made by the caller, with the energy function
 	
 	//ScaleLabelMapping* labelMapping = new ScaleLabelMapping();
 	//labelMapping->InitScaleRange(cvSize(_input->width, _input->height), 
@@ -76,6 +76,14 @@ void ScaleSM::ComputeGraphCut()
 {
 	_gc->ComputeGC();
 }
+int ScaleSM::GetDataEnergy()
+{
+	return _gc->GetDataEnergy();
+}
+int ScaleSM::GetSmoothEnergy()
+{
+	return _gc->GetSmoothEnergy();
+}
 
 void ScaleSM::ComputeOptimalRetargetMapping(IplImage* image, IplImage* saliency, CvSize outputSize)
 {
@@ -120,25 +128,23 @@ IplImage* ScaleSM::RenderRetargetImage()
 	GCoptimization* gc = _gc->GetGCoptimization();
 	int nodeCount = _outputSize.width * _outputSize.height;
 
+	RenderSample* samples = new RenderSample[nodeCount];
 	for(int i = 0; i < nodeCount; i++)
 	{
 		int label = gc->whatLabel(i);
 		CvPoint point = _mapping2D->GetMappedPoint(i);			
 		DoublePoint mappedPoint = _labelMapping->GetMappedPoint(label, point);
-		 		
-		if(!IsInside(mappedPoint, cvSize(_input->width, _input->height)))
-		{
-			printf("Map outside");
-			printf("test % i %i ", point.x, point.y);
-			cvSet2D(image, point.y, point.x, cvScalar(255));
-		}
-		else
-		{
-			// printf("test % f %f ", mappedPoint.x, mappedPoint.y);
-			CvScalar value = GetInterpolatedValue(mappedPoint, _input);
-			cvSet2D(image, point.y, point.x, value);			
-		}		
+
+		RenderSample* sample = samples + point.y * _outputSize.width + point.x;
+		sample->x = mappedPoint.x;
+		sample->y = mappedPoint.y;
+		sample->sourceId = IsInside(mappedPoint, cvSize(_input->width, _input->height)) ? 0 : -1;
 	}
+
+	int outsideCount = RenderImage(image, samples, &_input, RENDER_BILINEAR, cvScalar(255));
+	if(outsideCount > 0)
+		printf("Map outside: %d pixels\n", outsideCount);
+	delete[] samples;
 	//DisplayImage(image, "TEST");
 	return image;
 }
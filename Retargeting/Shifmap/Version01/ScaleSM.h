@@ -3,6 +3,7 @@
 #include "ScaleLabelMapping.h"
 #include "ScaleEnergyFunction.h"
 #include "GCScaleImage.h"
+#include "RenderKernel.h"
 
 class ScaleSM
 {
@@ -42,4 +43,7 @@ public:
 	IplImage* RenderRetargetImage();
 	// render a stack map for visualization of which pixel is mapped to which layer in stack
 	IplImage* RenderStackMapVisualisation();
+	// energy of the labeling, after compute graph cut
+	int GetDataEnergy();
+	int GetSmoothEnergy();
 };
@@ -5,10 +5,70 @@ ScaleStackImageSource::ScaleStackImageSource(void)
 {
 	_imageStack = new vector<IplImage*>();
 	_gradientStack = new vector<IplImage*>();
+	_packedImage.data = NULL;
+	_packedGradient.data = NULL;
 }
 
 ScaleStackImageSource::~ScaleStackImageSource(void)
 {
+	FreeStack(_packedImage);
+	FreeStack(_packedGradient);
+}
+void ScaleStackImageSource::Pack()
+{
+	PackStack(_imageStack, _packedImage);
+	PackStack(_gradientStack, _packedGradient);
+}
+void ScaleStackImageSource::FreeStack(PackedStack& packed)
+{
+	if(packed.data == NULL)
+		return;
+	delete[] packed.data;
+	delete[] packed.offset;
+	delete[] packed.stride;
+	delete[] packed.width;
+	delete[] packed.height;
+	packed.data = NULL;
+}
+void ScaleStackImageSource::PackStack(vector<IplImage*>* imageStack, PackedStack& packed)
+{
+	FreeStack(packed);
+	packed.levels = imageStack->size();
+	packed.offset = new int[packed.levels];
+	packed.stride = new int[packed.levels];
+	packed.width = new int[packed.levels];
+	packed.height = new int[packed.levels];
+
+	int total = 0;
+	for(int level = 0; level < packed.levels; level++)
+	{
+		packed.width[level] = (*imageStack)[level]->width;
+		packed.height[level] = (*imageStack)[level]->height;
+		packed.stride[level] = (packed.width[level] + 2) * 4;
+		packed.offset[level] = total + packed.stride[level] + 4;
+		total += packed.stride[level] * (packed.height[level] + 2);
+	}
+
+	packed.data = new float[total];
+	for(int i = 0; i < total; i += 4)
+	{
+		packed.data[i] = packed.data[i + 1] = packed.data[i + 2] = -1;
+		packed.data[i + 3] = 0;
+	}
+
+	for(int level = 0; level < packed.levels; level++)
+		for(int y = 0; y < packed.height[level]; y++)
+		{
+			float* row = packed.data + packed.offset[level] + y * packed.stride[level];
+			for(int x = 0; x < packed.width[level]; x++)
+			{
+				CvScalar value = cvGet2D((*imageStack)[level], y, x);
+				row[x * 4] = value.val[0];
+				row[x * 4 + 1] = value.val[1];
+				row[x * 4 + 2] = value.val[2];
+				row[x * 4 + 3] = 0;
+			}
+		}
 }
 bool ScaleStackImageSource::IsOutsideSource(Point3D point)
 {
@@ -69,10 +129,12 @@ CvSize ScaleStackImageSource::GetImageSize(int level)
 void  ScaleStackImageSource::PushImage(IplImage* image)
 {
 	_imageStack->push_back(image);
+	FreeStack(_packedImage);
 }
 void  ScaleStackImageSource::PushGradient(IplImage* image)
 {
 	_gradientStack->push_back(image);
+	FreeStack(_packedGradient);
 }
 void DownSampling(IplImage* image, IplImage* dst, int size)
 {	
@@ -99,6 +161,7 @@ ScaleStackImageSource* CreateScaleStackFromList(IplImage* input1, IplImage* inpu
 	cvSobel(input2, gradient2, 1, 1);
 	imageSource->PushGradient(gradient1);
 	imageSource->PushGradient(gradient2);
+	imageSource->Pack();
 
 	return imageSource;
 }
@@ -114,6 +177,7 @@ ScaleStackImageSource* CreateScaleStackFromList(vector<IplImage*>* inputList)
 		cvSobel(input, gradient, 1, 1);
 		imageSource->PushGradient(gradient);
 	}
+	imageSource->Pack();
 	return imageSource;
 }
 
@@ -141,5 +205,6 @@ ScaleStackImageSource* CreateScaleStackImageDSampling(IplImage* input, int stack
 		cvSobel(level, gradient, 1, 1);
 		imageSource->PushGradient(gradient);
 	}  
+	imageSource->Pack();
 	return imageSource;
 }
\ No newline at end of file
@@ -6,7 +6,18 @@
 #include <vector>
 using namespace std;
 
-
+// all levels of a stack in one buffer, 4 floats per pixel (the last one 
+// unused). Each level has a one pixel border holding (-1,-1,-1), the value 
+// GetPointValue gives outside the image
+struct PackedStack
+{
+	float* data;
+	int* offset;		// index of pixel (0,0) of each level
+	int* stride;		// floats per row of each level
+	int* width;
+	int* height;
+	int levels;
+};
 
 class ScaleStackImageSource : public ImageSource
 {
@@ -16,10 +27,13 @@ public:
 protected:	
 	vector<IplImage*>* _imageStack;
 	vector<IplImage*>* _gradientStack;
+	PackedStack _packedImage;
+	PackedStack _packedGradient;
 public:
 	// number of level of stack
 	int GetLevelCount();
 	CvSize GetImageSize(int level);
+	IplImage* GetImage(int level) { return (*_imageStack)[level]; }
 	void PushImage(IplImage* image);
 	void PushGradient(IplImage* image);
 	bool IsOutsideSource(Point3D point);
@@ -27,7 +41,58 @@ public:
 	virtual CvScalar GetGradientValue(Point3D point);
 	virtual int GetSquareColorDifference(Point3D point1, Point3D point2);
 	virtual int GetSquareGradientDifference(Point3D point1, Point3D point2);
+
+	// build the packed stacks; must be called again after pushing images or
+	// gradients, each of which drops its packed stack
+	void Pack();
+	bool IsPacked() { return _packedImage.data != NULL && _packedGradient.data != NULL; }
+
+	// packed accessors, valid after Pack()
+	inline bool IsOutsidePacked(Point3D point)
+	{
+		return point.z < 0 || point.z >= _packedImage.levels ||
+			point.x < 0 || point.y < 0 || 
+			point.x >= _packedImage.width[point.z] || point.y >= _packedImage.height[point.z];
+	}
+	inline int GetLevelWidth(int level) { return _packedImage.width[level]; }
+	inline int GetLevelHeight(int level) { return _packedImage.height[level]; }
+	// the point may lie on the border, one pixel outside the level
+	inline const float* ImagePixel(Point3D point) { return PackedPixel(point, _packedImage); }
+	inline const float* GradientPixel(Point3D point) { return PackedPixel(point, _packedGradient); }
+	inline int ImageSum(Point3D point)
+	{
+		const float* value = ImagePixel(point);
+		return value[0] + value[1] + value[2];
+	}
+	// color plus weighted gradient difference of the pairs (point1, neighbor2) 
+	// and (point2, neighbor1), as used by the smoothness terms
+	inline int GetSmoothDifference(Point3D point1, Point3D neighbor2, Point3D point2, Point3D neighbor1, 
+		int gradientWeight)
+	{
+		int energy = PackedSquareDifference(ImagePixel(point1), ImagePixel(neighbor2));
+		energy += PackedSquareDifference(ImagePixel(point2), ImagePixel(neighbor1));
+		energy += gradientWeight * PackedSquareDifference(GradientPixel(point2), GradientPixel(neighbor1));
+		energy += gradientWeight * PackedSquareDifference(GradientPixel(point1), GradientPixel(neighbor2));
+		return energy;
+	}
+	static inline int PackedSquareDifference(const float* value1, const float* value2)
+	{
+		float sum = 0;
+		for(int i = 0; i < 4; i++)
+		{
+			float diff = value1[i] - value2[i];
+			sum += diff * diff;
+		}
+		return sum;
+	}
 protected:
+	static inline const float* PackedPixel(Point3D point, PackedStack& packed)
+	{
+		return packed.data + packed.offset[point.z] + point.y * packed.stride[point.z] + point.x * 4;
+	}
+	void PackStack(vector<IplImage*>* imageStack, PackedStack& packed);
+	void FreeStack(PackedStack& packed);
+
 	bool IsOutsideSource(Point3D point, vector<IplImage*>* imageStack);
 	CvScalar GetPointValue(Point3D point, vector<IplImage*>* imageStack);
 	int SquareColorDifference(Point3D point1, Point3D point2, vector<IplImage*>* imageStack);
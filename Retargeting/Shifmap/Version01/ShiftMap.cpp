@@ -143,18 +143,19 @@ CvMat* ShiftMap::CalculateLabelMap()
 IplImage* ShiftMap::GetImageFromLabelMap(CvMat* map, IplImage* image)
 {
 	IplImage* output = cvCreateImage(cvSize(map->width, map->height), IPL_DEPTH_8U, 3);
-	for(int i = 0; i < map->width; i++)
-		for(int j = 0; j < map->height; j++)
+	RenderSample* samples = new RenderSample[map->width * map->height];
+	for(int j = 0; j < map->height; j++)
+		for(int i = 0; i < map->width; i++)
 		{
 			CvPoint label = GetLabel(cvPoint(i,j), map);
 			CvPoint mappedPoint = cvPoint(i + label.x, j + label.y);
-			
-			CvScalar value;
-			if(IsOutside(mappedPoint, cvSize(image->width, image->height)))
-				value = cvScalar(0, 0, 255);
-			else
-				value = cvGet2D(image, j + label.y, i + label.x);
-			cvSet2D(output, j, i, value);
+
+			RenderSample* sample = samples + j * map->width + i;
+			sample->x = mappedPoint.x;
+			sample->y = mappedPoint.y;
+			sample->sourceId = IsOutside(mappedPoint, cvSize(image->width, image->height)) ? -1 : 0;
 		}
+	RenderImage(output, samples, &image, RENDER_NEAREST, cvScalar(0, 0, 255));
+	delete[] samples;
 	return output;
 }
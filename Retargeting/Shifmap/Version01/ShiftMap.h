@@ -5,6 +5,7 @@
 #include "EnergyFunction.h"
 #include <cv.h> 
 #include "ImageRetargeter.h" 
+#include "RenderKernel.h"
  
 #include <vector>
 using namespace std;
@@ -26,7 +26,11 @@
 #include "Similarity.h"
 using namespace std;
 #include <vector>
+#include <map>
 #include <time.h>
+#include <omp.h>
+#include <windows.h>
+#include <psapi.h>
 // get commands from file
 
 struct AlgoSetting
@@ -45,9 +49,12 @@ struct AlgoSetting
 	char* dataCost;
 	int smoothThreshold;
 	char* type;
+	char* distortionCache; // 0 if distortion maps are not cached
 };
 
 
+void ReadAlgoOptions(ConfigFile& config, AlgoSetting& algoSetting);
+
 AlgoSetting GetAlgoSetting(char* commandFileName)
 {
 	AlgoSetting algoSetting;
@@ -128,6 +135,13 @@ AlgoSetting GetAlgoSetting(char* commandFileName)
 	}
 	algoSetting.saliency = saliency;
 	
+	ReadAlgoOptions(config, algoSetting);
+	return algoSetting;
+}
+
+// settings of the algorithm itself, apart from the images and output size
+void ReadAlgoOptions(ConfigFile& config, AlgoSetting& algoSetting)
+{
 	// *****************************************************************
 	// SETTING shiftmap type
 	string type;
@@ -149,8 +163,17 @@ AlgoSetting GetAlgoSetting(char* commandFileName)
 	config.readInto(algoSetting.scaleCount, "scaleCount");
 	config.readInto(algoSetting.scaleX, "scaleX");
 	config.readInto(algoSetting.scaleY, "scaleY");
-	
-	return algoSetting;
+
+	// *****************************************************************
+	// SETTING distortion cache
+	algoSetting.distortionCache = 0;
+	if(config.keyExists("distortionCache"))
+	{
+		string cacheFolder;
+		config.readInto(cacheFolder, "distortionCache");
+		algoSetting.distortionCache = new char[200];
+		strcpy(algoSetting.distortionCache, (char*)cacheFolder.c_str());
+	}
 }
 
 string GenerateName(AlgoSetting setting)
@@ -1294,6 +1317,7 @@ IplImage* GetRetargetImage(char* commandFileName)
 	energyFunction->SetRetargetSize(cvSize(setting.input->width, setting.input->height), setting.outputSize);
 	energyFunction->SetLabelMapping(labelMapping);
 	energyFunction->SetMapping2D(mapping2D);
+	energyFunction->SetDistortionCache(setting.distortionCache);
 	energyFunction->IntializeDistortionMeasure();
 	// energyFunction->SetupAreaCost(10, 20, 200);
   
@@ -1438,88 +1462,86 @@ void TestScaleFeedbackCost(char* commandFileName)
   	DisplayImage(viimage, "Test2");
 	cvSaveImage(output, rtimage);
 }
-void TestScaleDistortionRetargeting(char* commandFileName)
+// the ScaleSM of TestScaleDistortionRetargeting and everything it uses: 
+// warp labels over setting.scaleCount scales and the distortion energy
+struct ScaleDistortionRun
 {
+	ScaleSM* shiftMap;
+	IplImage* gradient;
+	vector<double>* scaleListX;
+	vector<double>* scaleListY;
+	ScaleLabelMapping* labelMapping;
+	Mapping2D* mapping2D;
+	WarpEnergyFunction* energyFunction;
+};
 
-	AlgoSetting setting = GetAlgoSetting(commandFileName);
-	
-	 
-	char* settingoutput = GenerateFileName(setting);
-	WriteSetting(setting);
-	ScaleSM* shiftMap = new ScaleSM();	 
-	
-	if(strcmp(setting.smoothCost, "threshold") == 0)
-		shiftMap->SetSmoothThreshold(setting.smoothThreshold);
-	 
-	shiftMap = new ScaleSM();
-	shiftMap->SetScaleSetting(setting.scaleCount, setting.scaleX, setting.scaleY);
-	IplImage* gradient = cvCloneImage(setting.input);			
-	cvSobel(setting.input, gradient, 1, 1);	
+// everything set up but the graph, call shiftMap->InitGraphCut next
+ScaleDistortionRun CreateScaleDistortionRun(AlgoSetting setting)
+{
+	ScaleDistortionRun run;
+	run.shiftMap = new ScaleSM();
+	run.shiftMap->SetScaleSetting(setting.scaleCount, setting.scaleX, setting.scaleY);
+	run.gradient = cvCloneImage(setting.input);			
+	cvSobel(setting.input, run.gradient, 1, 1);	
 
 	// new code 19 Nov for warp 
-	vector<double>* scaleListX = new vector<double>();
-	vector<double>* scaleListY = new vector<double>();
+	run.scaleListX = new vector<double>();
+	run.scaleListY = new vector<double>();
 	for(int i = 0; i < setting.scaleCount; i++)
 	{
 		double scaleX = 1 - i * setting.scaleX;
 		double scaleY = 1 - i * setting.scaleY;
-		scaleListX->push_back(scaleX);
-		scaleListY->push_back(scaleY);
+		run.scaleListX->push_back(scaleX);
+		run.scaleListY->push_back(scaleY);
 	}
 	
-	ScaleLabelMapping* labelMapping = new ScaleLabelMapping();	
-	
-	//labelMapping->InitScaleRange(cvSize(setting.input->width, setting.input->height),
-	//	setting.outputSize, setting.scaleCount, setting.scaleX, setting.scaleY);	 
-	labelMapping->InitWarpScaleRange(cvSize(setting.input->width, setting.input->height),
-		setting.outputSize, scaleListX, scaleListY);
+	run.labelMapping = new ScaleLabelMapping();	
+	run.labelMapping->InitWarpScaleRange(cvSize(setting.input->width, setting.input->height),
+		setting.outputSize, run.scaleListX, run.scaleListY);
 
-	Mapping2D* mapping2D = new Mapping2D();
-	mapping2D->InitializeMapping(setting.outputSize.width, setting.outputSize.height);
-	mapping2D->IsShift(false);
+	run.mapping2D = new Mapping2D();
+	run.mapping2D->InitializeMapping(setting.outputSize.width, setting.outputSize.height);
+	run.mapping2D->IsShift(false);
 
-	//IplImage* saliency;
-	//if(setting.saliency ==0)
-	//{
-	//	saliency = cvCloneImage(setting.input);	
-	//	for(int i = 0; i < saliency->width; i++)
-	//		for(int j = 0; j < saliency->height; j++)
-	//		{
-	//			cvSet2D(saliency, j, i, cvScalar(0,0,0));
-	//		}
-	//}
-	//else
-	//{
-	//	saliency = setting.saliency;
-	//	for(int i = 0; i < saliency->width; i++)
-	//		for(int j = 0; j < saliency->height; j++)
-	//		{
-	//			CvScalar value = cvGet2D(saliency, j, i);
-	//			for(int k = 0; k < 4; k++)
-	//			{
-	//				value.val[k] = 255 - value.val[k];
-	//			}
-	//			cvSet2D(saliency, j, i, value);
-	//		}
-	//}
-
-	// ScaleEnergyFunction* energyFunction = new ScaleEnergyFunction();
-	WarpEnergyFunction* energyFunction = new WarpEnergyFunction();
-	energyFunction->SetInput(setting.input, gradient, setting.saliency);
-	energyFunction->SetRetargetSize(cvSize(setting.input->width, setting.input->height), setting.outputSize);
-	energyFunction->SetLabelMapping(labelMapping);
-	energyFunction->SetMapping2D(mapping2D);
-	
+	run.energyFunction = new WarpEnergyFunction();
+	run.energyFunction->SetInput(setting.input, run.gradient, setting.saliency);
+	run.energyFunction->SetRetargetSize(cvSize(setting.input->width, setting.input->height), setting.outputSize);
+	run.energyFunction->SetLabelMapping(run.labelMapping);
+	run.energyFunction->SetMapping2D(run.mapping2D);
+	run.energyFunction->SetDistortionCache(setting.distortionCache);
 	//energyFunction->InitializeDistortionMeasure(setting.saliency);
-	energyFunction->IntializeDistortionMeasure();
+	run.energyFunction->IntializeDistortionMeasure();
 	// energyFunction->InitializeImportanceMap();
 	// energyFunction->SetupAreaCost(10, 20, 200);
-  
+
+	run.shiftMap->SetEnergyFunction(run.energyFunction);
+	run.shiftMap->SetLabelMapping(run.labelMapping);
+	run.shiftMap->SetMapping2D(run.mapping2D);
+	return run;
+}
+
+void ReleaseScaleDistortionRun(ScaleDistortionRun run)
+{
+	delete run.shiftMap;
+	delete run.energyFunction;
+	delete run.mapping2D;
+	delete run.labelMapping;
+	delete run.scaleListX;
+	delete run.scaleListY;
+	cvReleaseImage(&run.gradient);
+}
+
+void TestScaleDistortionRetargeting(char* commandFileName)
+{
+
+	AlgoSetting setting = GetAlgoSetting(commandFileName);
 	
+	 
+	char* settingoutput = GenerateFileName(setting);
+	WriteSetting(setting);
 
-	shiftMap->SetEnergyFunction(energyFunction);
-	shiftMap->SetLabelMapping(labelMapping);
-	shiftMap->SetMapping2D(mapping2D);
+	ScaleDistortionRun run = CreateScaleDistortionRun(setting);
+	ScaleSM* shiftMap = run.shiftMap;
 	shiftMap->InitGraphCut(setting.input, setting.saliency, 
 		setting.outputSize);	
 	shiftMap->ComputeGraphCut();
@@ -1559,6 +1581,7 @@ void TestScaleDistortionWarp(char* commandFileName)
 	WriteSetting(setting);
 
 	WarpEnergyFunction* func = new WarpEnergyFunction();
+	func->SetDistortionCache(setting.distortionCache);
 
 	
 	CvMat* result_mat = cvCreateMat(setting.input->height, setting.input->width,CV_32FC1);
@@ -1628,8 +1651,282 @@ void TestScaleDistortionWarp(char* commandFileName)
 	cvSaveImage("test.jpg", avg_img);
 
 }
+// *****************************************************************
+// BATCH run of TestScaleDistortionRetargeting jobs
+// manifest: one job per line, '#' starts a comment
+//   input, saliency, command file, width, height[, memory limit in MB]
+// saliency is "none" for no saliency. The command file gives the other 
+// settings (scales, costs, distortionCache). Jobs share decoded images 
+// and run on a pool of workers, the report has one CSV line per job
+
+struct BatchJob
+{
+	string input;
+	string saliency;
+	string command;
+	CvSize outputSize;
+	int memoryLimit;	// MB, 0 for no limit
+};
+
+struct BatchReport
+{
+	const char* status;
+	double loadTime;	// seconds
+	double setupTime;
+	double solveTime;
+	double renderTime;
+	int dataEnergy;
+	int smoothEnergy;
+	double estimatedMemory;	// MB
+	double peakMemory;		// MB, peak working set of the whole process when the job ended
+};
+
+static string TrimString(string value)
+{
+	int start = value.find_first_not_of(" \t\r\n");
+	if(start == string::npos)
+		return "";
+	int end = value.find_last_not_of(" \t\r\n");
+	return value.substr(start, end - start + 1);
+}
+
+vector<BatchJob>* ReadBatchManifest(char* manifestFileName)
+{
+	vector<BatchJob>* jobs = new vector<BatchJob>();
+	ifstream manifest(manifestFileName);
+	string line;
+	while(getline(manifest, line))
+	{
+		int comment = line.find('#');
+		if(comment != string::npos)
+			line = line.substr(0, comment);
+		if(TrimString(line).empty())
+			continue;
+
+		vector<string> fields;
+		int current = 0;
+		while(true)
+		{
+			int end = line.find(',', current);
+			fields.push_back(TrimString(line.substr(current, end == string::npos ? string::npos : end - current)));
+			if(end == string::npos)
+				break;
+			current = end + 1;
+		}
+		if(fields.size() < 5)
+		{
+			printf("Skipping manifest line: %s\n", line.c_str());
+			continue;
+		}
+
+		BatchJob job;
+		job.input = fields[0];
+		job.saliency = fields[1];
+		job.command = fields[2];
+		job.outputSize = cvSize(atoi(fields[3].c_str()), atoi(fields[4].c_str()));
+		job.memoryLimit = fields.size() > 5 ? atoi(fields[5].c_str()) : 0;
+		jobs->push_back(job);
+	}
+	return jobs;
+}
+
+// decoded once for all the jobs using the file, never modified
+IplImage* LoadBatchImage(map<string, IplImage*>* images, string fileName)
+{
+	IplImage* image;
+	#pragma omp critical(batch_images)
+	{
+		map<string, IplImage*>::iterator found = images->find(fileName);
+		if(found != images->end())
+			image = found->second;
+		else
+		{
+			image = cvLoadImage(fileName.c_str());
+			(*images)[fileName] = image;
+		}
+	}
+	return image;
+}
+
+double PeakMemoryMB()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+}
+
+// rough footprint of a job: input, gradient and saliency, one distortion 
+// map per scale, and the grid graph with its expansion graph per site
+double EstimateJobMemoryMB(AlgoSetting setting)
+{
+	double inputPixels = setting.input->width * setting.input->height;
+	double sites = setting.outputSize.width * setting.outputSize.height;
+	double bytes = inputPixels * 3 * 3 + inputPixels * 4 * setting.scaleCount + sites * 300;
+	return bytes / (1024.0 * 1024.0);
+}
+
+void RunBatchJob(BatchJob job, map<string, IplImage*>* images, BatchReport* report)
+{
+	report->status = "ok";
+	report->dataEnergy = 0;
+	report->smoothEnergy = 0;
+	report->setupTime = 0;
+	report->solveTime = 0;
+	report->renderTime = 0;
+	report->estimatedMemory = 0;
+
+	// LOAD
+	double start = omp_get_wtime();
+	AlgoSetting setting;
+	ConfigFile config(job.command);
+	ReadAlgoOptions(config, setting);
+	setting.outputSize = job.outputSize;
+	setting.input = LoadBatchImage(images, job.input);
+
+	// folder and file name only name the outputs
+	int slash = job.input.find_last_of("/\\");
+	string folder = slash == string::npos ? "" : job.input.substr(0, slash);
+	string file = slash == string::npos ? job.input : job.input.substr(slash + 1);
+	setting.folder = new char[folder.size() + 1];
+	strcpy(setting.folder, folder.c_str());
+	setting.inputName = new char[file.size() + 1];
+	strcpy(setting.inputName, file.c_str());
+
+	bool noSaliency = job.saliency == "none";
+	if(noSaliency)
+	{
+		setting.saliencyName = "none";
+		setting.saliency = NULL;
+		if(setting.input != NULL)
+		{
+			setting.saliency = cvCloneImage(setting.input);
+			cvZero(setting.saliency);
+		}
+	}
+	else
+	{
+		setting.saliencyName = (char*)job.saliency.c_str();
+		setting.saliency = LoadBatchImage(images, job.saliency);
+	}
+	report->loadTime = omp_get_wtime() - start;
+
+	if(setting.input == NULL || setting.saliency == NULL)
+	{
+		report->status = "load failed";
+		report->peakMemory = PeakMemoryMB();
+		return;
+	}
+
+	report->estimatedMemory = EstimateJobMemoryMB(setting);
+	if(job.memoryLimit > 0 && report->estimatedMemory > job.memoryLimit)
+		report->status = "over memory limit";
+	else
+	{
+		// SETUP
+		start = omp_get_wtime();
+		ScaleDistortionRun run = CreateScaleDistortionRun(setting);
+		run.shiftMap->InitGraphCut(setting.input, setting.saliency, setting.outputSize);
+		report->setupTime = omp_get_wtime() - start;
+
+		// SOLVE
+		start = omp_get_wtime();
+		run.shiftMap->ComputeGraphCut();
+		report->dataEnergy = run.shiftMap->GetDataEnergy();
+		report->smoothEnergy = run.shiftMap->GetSmoothEnergy();
+		report->solveTime = omp_get_wtime() - start;
+
+		// RENDER
+		start = omp_get_wtime();
+		IplImage* rtimage = run.shiftMap->RenderRetargetImage();
+		IplImage* viimage = run.shiftMap->RenderStackMapVisualisation();
+		char* output = GenerateImageName(setting);
+		char* visualizedOutput = GenerateVisualizedImageName(setting);
+		#pragma omp critical(batch_save)
+		{
+			cvSaveImage(output, rtimage);
+			cvSaveImage(visualizedOutput, viimage);
+		}
+		delete[] output;
+		delete[] visualizedOutput;
+		cvReleaseImage(&rtimage);
+		cvReleaseImage(&viimage);
+		report->renderTime = omp_get_wtime() - start;
+
+		ReleaseScaleDistortionRun(run);
+	}
+
+	if(noSaliency)
+		cvReleaseImage(&setting.saliency);
+	delete[] setting.folder;
+	delete[] setting.inputName;
+	delete[] setting.smoothCost;
+	delete[] setting.dataCost;
+	delete[] setting.type;
+	if(setting.distortionCache != 0)
+		delete[] setting.distortionCache;
+	report->peakMemory = PeakMemoryMB();
+}
+
+void RunBatch(char* manifestFileName, char* reportFileName, int workerCount)
+{
+	vector<BatchJob>* jobs = ReadBatchManifest(manifestFileName);
+	int jobCount = jobs->size();
+	BatchReport* reports = new BatchReport[jobCount];
+	map<string, IplImage*>* images = new map<string, IplImage*>();
+
+	double start = omp_get_wtime();
+	#pragma omp parallel for schedule(dynamic, 1) num_threads(workerCount)
+	for(int i = 0; i < jobCount; i++)
+	{
+		try
+		{
+			RunBatchJob((*jobs)[i], images, &reports[i]);
+		}
+		catch(...)
+		{
+			reports[i].status = "failed";
+			reports[i].peakMemory = PeakMemoryMB();
+		}
+		#pragma omp critical(batch_print)
+		printf("Job %i/%i %s: %s\n", i + 1, jobCount, (*jobs)[i].input.c_str(), reports[i].status);
+	}
+	double total = omp_get_wtime() - start;
+
+	ofstream report(reportFileName);
+	report << "job,input,saliency,command,width,height,status,load,setup,solve,render,"
+		<< "data_energy,smooth_energy,estimated_mb,peak_mb\n";
+	for(int i = 0; i < jobCount; i++)
+	{
+		BatchJob job = (*jobs)[i];
+		BatchReport result = reports[i];
+		char line[200];
+		sprintf(line, "%i,%i,%s,%.3f,%.3f,%.3f,%.3f,%i,%i,%.1f,%.1f", job.outputSize.width, job.outputSize.height,
+			result.status, result.loadTime, result.setupTime, result.solveTime, result.renderTime,
+			result.dataEnergy, result.smoothEnergy, result.estimatedMemory, result.peakMemory);
+		report << i << ",\"" << job.input << "\",\"" << job.saliency << "\",\"" << job.command << "\"," << line << "\n";
+	}
+	report.close();
+	printf("%i jobs in %.1f seconds on %i workers\n", jobCount, total, workerCount);
+
+	for(map<string, IplImage*>::iterator i = images->begin(); i != images->end(); i++)
+		if(i->second != NULL)
+			cvReleaseImage(&i->second);
+	delete images;
+	delete[] reports;
+	delete jobs;
+}
+
 int main(int argc, char* argv[])
 {	
+	// batch: ShiftMap <manifest> <report.csv> [workers]
+	if(argc >= 3)
+	{
+		int workerCount = argc > 3 ? atoi(argv[3]) : omp_get_num_procs();
+		RunBatch(argv[1], argv[2], workerCount);
+		return 0;
+	}
+
 	// ConfigFile config( "example.txt" );
 	//TestScaleDistortionWarp("command.txt");
 	//GetRetargetImage("command.txt");
@@ -3,10 +3,26 @@
 
 WarpEnergyFunction::WarpEnergyFunction(void)
 {
+	_distortionList = NULL;
+	_importanceList = NULL;
+	_cacheFolder = NULL;
+	_hashedImage = NULL;
 }
 
 WarpEnergyFunction::~WarpEnergyFunction(void)
 {
+	ReleaseMatList(_distortionList);
+	ReleaseMatList(_importanceList);
+}
+
+void WarpEnergyFunction::ReleaseMatList(vector<CvMat*>* matList)
+{
+	if(matList == NULL)
+		return;
+	for(int i = 0; i < (int)matList->size(); i++)
+		if((*matList)[i] != NULL)
+			cvReleaseMat(&(*matList)[i]);
+	delete matList;
 }
 
 int WarpEnergyFunction::GetDataCost(int labelId, int nodeId)
@@ -36,8 +52,8 @@ int WarpEnergyFunction::GetSmoothCostPreserveObject(int labelId1, int labelId2,
 	
 	//distortMat1 = (*_importanceList)[scaleId1];
 	//distortMat2 = (*_importanceList)[scaleId2];
-	distortMat1 = (*_distortionList)[scaleId1];
-	distortMat2 = (*_distortionList)[scaleId2];
+	distortMat1 = GetDistortion(scaleId1);
+	distortMat2 = GetDistortion(scaleId2);
 
 	CvPoint point1 = _mapping2D->GetMappedPoint(nodeId1);
 	CvPoint point2 = _mapping2D->GetMappedPoint(nodeId2);
@@ -98,6 +114,34 @@ double WarpEnergyFunction::GetScaleDistortion(IplImage* image, IplImage* image2,
 	}
 	return maxDiff / (patchSize * patchSize);
 }
+double WarpEnergyFunction::GetScaleDistortion(PatchPlane* plane, PatchPlane* plane2, CvPoint point, 
+											  double scaleX, double scaleY, int patchSize)
+{
+	int scaledX = point.x / scaleX;
+	int scaledY = point.y / scaleY;
+	int scaledPatchX = patchSize / scaleX;
+	int scaledPatchY = patchSize / scaleY;
+ 
+	double maxDiff = 0;
+	for(int x = scaledX; x < scaledX + scaledPatchX - patchSize + 1; x++)
+		for(int y = scaledY; y < scaledY + scaledPatchY - patchSize + 1; y++)
+		{
+			double diff = PlanePatchDifference(plane2, point, plane, cvPoint(x, y), patchSize);
+			if(maxDiff < diff)
+				maxDiff = diff;
+		}
+	return maxDiff / (patchSize * patchSize);
+}
+CvMat* WarpEnergyFunction::GetDistortion(int scaleId)
+{
+	CvMat* res = (*_distortionList)[scaleId];
+	if(res == NULL)
+	{
+		res = GetDistortionMat(_image, _labelMapping->GetScaleX(scaleId), _labelMapping->GetScaleY(scaleId));
+		(*_distortionList)[scaleId] = res;
+	}
+	return res;
+}
 int WarpEnergyFunction::OverlapNumber(CvPoint point, int patchSize, int width, int height)
 {
 	int minX = point.x - patchSize + 1;
@@ -114,7 +158,37 @@ int WarpEnergyFunction::OverlapNumber(CvPoint point, int patchSize, int width, i
 	return (point.x - minX + 1) * (point.y - minY + 1);
 }
 
+void WarpEnergyFunction::SetDistortionCache(char* folder)
+{
+	_cacheFolder = folder;
+}
+
 CvMat* WarpEnergyFunction::GetDistortionMat(IplImage* image, double scaleX, double scaleY)
+{
+	int patchSize = 3;
+	if(_cacheFolder == NULL)
+		return ComputeDistortionMat(image, scaleX, scaleY, patchSize);
+
+	if(image != _hashedImage)
+	{
+		_imageHash = ImageHash(image);
+		_hashedImage = image;
+	}
+	MatCacheKey key = matCacheKey(image, _imageHash, scaleX, scaleY, patchSize);
+	char* fileName = MatCacheFileName(_cacheFolder, "distortion", key);
+
+	CvMat* res = LoadCachedMat(fileName, key);
+	if(res == NULL)
+	{
+		res = ComputeDistortionMat(image, scaleX, scaleY, patchSize);
+		if(!SaveCachedMat(fileName, key, res))
+			printf("Cannot write distortion cache %s\n", fileName);
+	}
+	delete[] fileName;
+	return res;
+}
+
+CvMat* WarpEnergyFunction::ComputeDistortionMat(IplImage* image, double scaleX, double scaleY, int patchSize)
 {	
 	int width = image->width * scaleX;
 	int height = image->height * scaleY;
@@ -127,11 +201,12 @@ CvMat* WarpEnergyFunction::GetDistortionMat(IplImage* image, double scaleX, doub
 	for(int j = 0; j < res->rows; j++)
 		cvSet2D(res, j, i, cvScalar(0,0,0));
 	 	
-	int patchSize = 3;		
+	PatchPlane* plane = CreatePatchPlane(image, 1, 1, patchSize);
+	PatchPlane* scaledPlane = CreatePatchPlane(scaledImage, 1, 1, patchSize);
 	for(int x = 0; x < scaledImage->width - patchSize; x++)	 
 	for(int y = 0; y < scaledImage->height - patchSize; y++)
 		{
-			double diff = GetScaleDistortion(image, scaledImage, cvPoint(x, y), scaleX, scaleY, patchSize);
+			double diff = GetScaleDistortion(plane, scaledPlane, cvPoint(x, y), scaleX, scaleY, patchSize);
 
 			for(int i = 0; i < patchSize; i++)
 				for(int j = 0; j < patchSize; j++)
@@ -145,6 +220,8 @@ CvMat* WarpEnergyFunction::GetDistortionMat(IplImage* image, double scaleX, doub
 				}				
 		}			
  
+	ReleasePatchPlane(plane);
+	ReleasePatchPlane(scaledPlane);
 	return res;
 }
 void WarpEnergyFunction::InitializeImportanceMap()
@@ -222,15 +299,9 @@ void WarpEnergyFunction::IntializeDistortionMeasure()
 	int scaleCount = _labelMapping->GetScaleCount();
 	_distortionList = new vector<CvMat*>();
 	
+	// each scale is made by GetDistortion when the energy first needs it
 	for(int i = 0; i < scaleCount; i++)
-	{
-		double ratioX = _labelMapping->GetScaleX(i);
-		double ratioY = _labelMapping->GetScaleY(i);
-		int width = _image->width * ratioX;
-		int height = _image->width * ratioY; 
-		CvMat* res = GetDistortionMat(_image, ratioX, ratioY);
-		_distortionList->push_back(res);
-	}
+		_distortionList->push_back(NULL);
 
 	//int max = 0;
 	//CvMat* result = (*distortionList)[0];
@@ -416,7 +487,7 @@ int WarpEnergyFunction::GetDataWarpDistort(int labelId, int nodeId, int penaltyC
 	int mappedX = mappedPoint.x * scaleX;
 	int mappedY = mappedPoint.y * scaleY;
 
-	CvMat* distortMat = (*_distortionList)[scaleId];
+	CvMat* distortMat = GetDistortion(scaleId);
 	CvScalar value = cvGet2D(distortMat, mappedY, mappedX);
 
 	//if(scaleId > 2 )
@@ -1,6 +1,7 @@
 #pragma once
 #include "DebugTool.h"
 #include "ScaleEnergyFunction.h"
+#include "MatCache.h"
 
 class WarpEnergyFunction : public ScaleEnergyFunction
 {
@@ -11,6 +12,11 @@ protected:
 	vector<CvMat*>* _distortionList;
 	vector<CvMat*>* _importanceList;
 	// CvMat* _importanceMap;
+	// folder of cached distortion maps, NULL to always compute them
+	char* _cacheFolder;
+	IplImage* _hashedImage;
+	unsigned int _imageHash;
+	void ReleaseMatList(vector<CvMat*>* matList);
 public:
 	virtual int GetDataCost(int labelId, int nodeId);
 	virtual int GetSmoothCost(int labelId1, int labelId2, int nodeId1, int nodeId2);
@@ -18,10 +24,17 @@ public:
 	void IntializeDistortionMeasure();	
 	void InitializeImportanceMap();
 	void InitializeDistortionMeasure(IplImage* saliency);
+	// keep distortion maps in folder and reuse them on later runs of the same image
+	void SetDistortionCache(char* folder);
+	// distortion of one scale, computed (or loaded) on first use
+	CvMat* GetDistortion(int scaleId);
 public:
 	double GetScaleDistortion(IplImage* image, IplImage* image2, CvPoint point, double scaleX, double scaleY, int patchSize);
+	// same on planes made once by GetDistortionMat, out of image values are 0
+	double GetScaleDistortion(PatchPlane* plane, PatchPlane* plane2, CvPoint point, double scaleX, double scaleY, int patchSize);
 	int OverlapNumber(CvPoint point, int patchSize, int width, int height);
 	CvMat* GetDistortionMat(IplImage* image, double scaleX, double scaleY);
+	CvMat* ComputeDistortionMat(IplImage* image, double scaleX, double scaleY, int patchSize);
 	virtual int GetSmoothCostWarp(int labelId1, int labelId2, int nodeId1, int nodeId2, int penaltyCost, int pixelDistance);
 
 protected:
@@ -9,29 +9,40 @@ ColorConverter::~ColorConverter(void)
 {
 }
 
-void ColorConverter::ConvertRGB2LUV(Matrix3D* input, Matrix3D* output)
+void ColorConverter::ConvertRGB2LUV(Matrix3D8UC3* input, Matrix3D8UC3* output)
 {
 	int length = input->_length;
 	IplImage* image = cvCreateImage(cvSize(input->_width, input->_height), input->_type, input->_channel);
+	IplImage* dst = cvCreateImage(cvSize(input->_width, input->_height), input->_type, input->_channel);
+	IplImage imageHeader;
+	IplImage dstHeader;
 	
 	for(int z = 0; z < length; z++)
 	{
-		input->GetIplImageZ(z, image);
-		cvCvtColor(image, image, CV_RGB2Luv);
-		output->SetIplImageZ(z, image);
+		// frames are converted in place when the layout allows it
+		Matrix3DSlice<unsigned char, 3> outputSlice = output->SliceZ(z);
+		IplImage* outputImage = outputSlice.GetImage(&dstHeader, dst, false);
+		cvCvtColor(input->SliceZ(z).GetImage(&imageHeader, image), outputImage, CV_RGB2Luv);
+		outputSlice.StoreImage(outputImage);
 	}
+	cvReleaseImage(&image);
+	cvReleaseImage(&dst);
 }
 
-void ColorConverter::ConvertRGB2GRAY(Matrix3D *input, Matrix3D *output)
+void ColorConverter::ConvertRGB2GRAY(Matrix3D8UC3 *input, Matrix3D8UC1 *output)
 {
 	int length = input->_length;
 	IplImage* image = cvCreateImage(cvSize(input->_width, input->_height), input->_type, input->_channel);
 	IplImage* gray_img = cvCreateImage(cvSize(input->_width, input->_height), input->_type, 1);
+	IplImage imageHeader;
+	IplImage grayHeader;
 	for(int z = 0; z < length; z++)
 	{
-		input->GetIplImageZ(z, image);
-		cvCvtColor(image, gray_img, CV_BGR2GRAY);
-		output->SetIplImageZ(z, gray_img);
+		Matrix3DSlice<unsigned char, 1> outputSlice = output->SliceZ(z);
+		IplImage* outputImage = outputSlice.GetImage(&grayHeader, gray_img, false);
+		cvCvtColor(input->SliceZ(z).GetImage(&imageHeader, image), outputImage, CV_BGR2GRAY);
+		outputSlice.StoreImage(outputImage);
 	}
+	cvReleaseImage(&image);
+	cvReleaseImage(&gray_img);
 }
- 
\ No newline at end of file
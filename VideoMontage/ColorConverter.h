@@ -9,8 +9,8 @@ public:
 	~ColorConverter(void);
 
 	// take out frame by frame and convert from RGB to LUV space
-	void ConvertRGB2LUV(Matrix3D* input, Matrix3D* output);
+	void ConvertRGB2LUV(Matrix3D8UC3* input, Matrix3D8UC3* output);
 
-	void ConvertRGB2GRAY(Matrix3D* input, Matrix3D* output);
+	void ConvertRGB2GRAY(Matrix3D8UC3* input, Matrix3D8UC1* output);
  
 };
@@ -0,0 +1,165 @@
+#include "StdAfx.h"
+#include "FrameScorer.h"
+#include <typeinfo>
+
+#define SCORE_FILE_MAGIC 0x53434653		// "SFCS"
+#define SCORE_FILE_VERSION 1
+
+struct ScoreFileHeader
+{
+	int magic;
+	int version;
+	unsigned int key;
+	int count;
+};
+
+static void HashString(unsigned int& hash, const char* text)
+{
+	// terminator included, so consecutive strings can not run together
+	const unsigned char* c = (const unsigned char*)text;
+	do
+	{
+		hash ^= *c;
+		hash *= 16777619u;
+	} while(*c++ != 0);
+}
+
+FrameScorer::FrameScorer(ImageQuality* imageQuality, ImageImportance* imageImportance)
+{
+	_imageQuality = imageQuality;
+	_imageImportance = imageImportance;
+	_scores = new vector<FrameScore>();
+	_sharedSobel = dynamic_cast<SobelImageQuality*>(imageQuality) != NULL && 
+		dynamic_cast<SobelImageImportance*>(imageImportance) != NULL;
+}
+
+FrameScorer::~FrameScorer(void)
+{
+	delete _scores;
+}
+
+FrameScore FrameScorer::ScoreFrame(IplImage* frame)
+{
+	if(_sharedSobel && frame->depth == IPL_DEPTH_8U && frame->nChannels == 3)
+		return ScoreFrameSobel(frame);
+
+	FrameScore score;
+	score.quality = _imageQuality->GetImageQuality(frame);
+	score.importance = _imageImportance->GetImageImportance(frame);
+	return score;
+}
+
+FrameScore FrameScorer::ScoreFrameSobel(IplImage* frame)
+{
+	IplImage* sobel = cvCreateImage(cvSize(frame->width, frame->height), IPL_DEPTH_16S, 3);
+	cvSobel(frame, sobel, 2, 2);
+
+	// importance: sum of the channel responses
+	// quality: max of the response of the gray image, CV_RGB2GRAY weights
+	double sum = 0;
+	double max = 0;
+	for(int y = 0; y < sobel->height; y++)
+	{
+		short* row = (short*)(sobel->imageData + y * sobel->widthStep);
+		for(int x = 0; x < sobel->width; x++)
+		{
+			short* value = row + x * 3;
+			sum += abs(value[0]) + abs(value[1]) + abs(value[2]);
+			double gray = fabs(0.299 * value[0] + 0.587 * value[1] + 0.114 * value[2]);
+			if(gray > max)
+				max = gray;
+		}
+	}
+	cvReleaseImage(&sobel);
+
+	FrameScore score;
+	score.quality = max;
+	score.importance = sum;
+	return score;
+}
+
+void FrameScorer::ScoreSequence(VideoSequence* sequence)
+{
+	int count = sequence->frameList->size();
+	_scores->resize(count);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int i = 0; i < count; i++)
+	{
+		IplImage* frame = LoadFrame(sequence, i);
+		if(frame == NULL)
+		{
+			printf("\nFrameScorer::ScoreSequence: can not load frame %i", i);
+			(*_scores)[i].quality = -1;
+			(*_scores)[i].importance = -1;
+			continue;
+		}
+		(*_scores)[i] = ScoreFrame(frame);
+		cvReleaseImage(&frame);
+	}
+}
+
+unsigned int FrameScorer::GetScoreKey(VideoSequence* sequence)
+{
+	unsigned int hash = 2166136261u;
+	HashString(hash, typeid(*_imageQuality).name());
+	HashString(hash, typeid(*_imageImportance).name());
+	for(int i = 0; i < (int)sequence->frameList->size(); i++)
+		HashString(hash, (*sequence->frameList)[i]);
+	return hash;
+}
+
+bool FrameScorer::LoadScores(char* fileName, VideoSequence* sequence)
+{
+	ifstream in(fileName, ios::binary);
+	if(!in.is_open())
+		return false;
+
+	ScoreFileHeader header;
+	in.read((char*)&header, sizeof(ScoreFileHeader));
+	if(!in.good() || header.magic != SCORE_FILE_MAGIC || header.version != SCORE_FILE_VERSION
+		|| header.count != (int)sequence->frameList->size() || header.key != GetScoreKey(sequence))
+		return false;
+
+	int count = header.count;
+	vector<FrameScore> scores(count);
+	for(int i = 0; i < count; i++)
+	{
+		in.read((char*)&(scores[i].quality), sizeof(double));
+		in.read((char*)&(scores[i].importance), sizeof(double));
+	}
+	if(!in.good())
+		return false;
+
+	*_scores = scores;
+	return true;
+}
+
+void FrameScorer::SaveScores(char* fileName, VideoSequence* sequence)
+{
+	ofstream out(fileName, ios::binary);
+	int count = _scores->size();
+	ScoreFileHeader header;
+	memset(&header, 0, sizeof(ScoreFileHeader));
+	header.magic = SCORE_FILE_MAGIC;
+	header.version = SCORE_FILE_VERSION;
+	header.key = GetScoreKey(sequence);
+	header.count = count;
+	out.write((char*)&header, sizeof(ScoreFileHeader));
+	for(int i = 0; i < count; i++)
+	{
+		out.write((char*)&((*_scores)[i].quality), sizeof(double));
+		out.write((char*)&((*_scores)[i].importance), sizeof(double));
+	}
+	out.close();
+}
+
+int FrameScorer::GetFrameCount()
+{
+	return _scores->size();
+}
+
+FrameScore FrameScorer::GetScore(int frame)
+{
+	return (*_scores)[frame];
+}
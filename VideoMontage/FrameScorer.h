@@ -0,0 +1,53 @@
+#pragma once
+#include <cv.h>
+#include <vector>
+#include "VideoSequence.h"
+#include "ImageQuality.h"
+#include "ImageImportance.h"
+#include "SobelImageQuality.h"
+#include "SobelImageImportance.h"
+
+using namespace std;
+
+// A(Ik) and Q(Ik) of a frame
+struct FrameScore
+{
+	double quality;
+	double importance;
+};
+
+// score every frame of a sequence in one pass: each frame is decoded once
+// and both metrics are taken from it. Frames are scored in parallel.
+// With the Sobel metrics both scores come from a single Sobel response.
+// Scores can be kept in a small file next to the sequence so that later
+// runs do not decode the video again. The file header holds a key made from
+// the frame file names and the metric types, so scores of other frames or 
+// other metrics are never reused
+class FrameScorer
+{
+public:
+	FrameScorer(ImageQuality* imageQuality, ImageImportance* imageImportance);
+	~FrameScorer(void);
+protected:
+	ImageQuality* _imageQuality;
+	ImageImportance* _imageImportance;
+	vector<FrameScore>* _scores;
+	// both metrics are the Sobel ones
+	bool _sharedSobel;
+protected:
+	FrameScore ScoreFrame(IplImage* frame);
+	// as SobelImageQuality and SobelImageImportance, from one Sobel of the
+	// color frame. The gray Sobel of the quality is the weighted sum of the 
+	// channel responses
+	FrameScore ScoreFrameSobel(IplImage* frame);
+	// FNV-1a over the frame file names and the class names of the metrics
+	unsigned int GetScoreKey(VideoSequence* sequence);
+public:
+	void ScoreSequence(VideoSequence* sequence);
+	// load the scores of a previous run on the same sequence and metrics
+	// return false if the file is missing, broken or its key does not match
+	bool LoadScores(char* fileName, VideoSequence* sequence);
+	void SaveScores(char* fileName, VideoSequence* sequence);
+	int GetFrameCount();
+	FrameScore GetScore(int frame);
+};
@@ -10,22 +10,147 @@ ImageMergeCarving::~ImageMergeCarving(void)
 
 IplImage* ImageMergeCarving::GetMergedImage(IplImage* image1, IplImage* image2, int overlap_size)
 {
-	IplImage* overlap1;
-	IplImage* overlap2;
+	IplImage* imageList[2] = {image1, image2};
+	return GetMergedImage(imageList, 2, overlap_size);
+}
 
-	GetOverlapImages(image1, image2, &overlap1, &overlap2, overlap_size);
+IplImage* ImageMergeCarving::GetMergedImage(IplImage** imageList, int count, int overlap_size)
+{
+	int height = imageList[0]->height;
+	int channels = imageList[0]->nChannels;
 
-	IplImage* overlap_cost = CreateOverlapImageCost(overlap1, overlap2);
-	
-	MinEnergyPath* minEnergyPath = new SeamCarving(overlap_cost);
-	Path* path = minEnergyPath->GetEnergyPath();
-	DrawPath(overlap_cost, path);
+	// seams of an image in the middle must not cross each other, and the 
+	// overlap of the right image is shifted 1 pixel
+	for(int i = 0; i < count; i++)
+	{
+		int width = imageList[i]->width;
+		overlap_size = MIN(overlap_size, width - 1);
+		if(i > 0 && i < count - 1)
+			overlap_size = MIN(overlap_size, width / 2);
+	}
+
+	// image i starts at offset[i] in the result
+	int* offset = new int[count];
+	offset[0] = 0;
+	for(int i = 1; i < count; i++)
+		offset[i] = offset[i - 1] + imageList[i - 1]->width - overlap_size;
+	IplImage* result = cvCreateImage(cvSize(offset[count - 1] + imageList[count - 1]->width, height), 
+		IPL_DEPTH_8U, channels);
 
-	IplImage* result;
-	//SeamCarving* carving = new SeamCarving();
+	// seam i goes through the overlap of image i and i + 1
+	int** seamList = new int*[count];
+	#pragma omp parallel for schedule(dynamic)
+	for(int i = 0; i < count - 1; i++)
+	{
+		short* cost = CreateOverlapCost(imageList[i], imageList[i + 1], overlap_size);
+		seamList[i] = new int[height];
+		GetMinSeam(cost, overlap_size, height, seamList[i]);
+		delete[] cost;
+	}
+
+	// left of a seam from the left image, right of it from the right one
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++)
+	{
+		char* resultRow = result->imageData + y * result->widthStep;
+		for(int i = 0; i < count; i++)
+		{
+			IplImage* image = imageList[i];
+			int start = i > 0 ? seamList[i - 1][y] + 1 : 0;
+			int end = i < count - 1 ? image->width - overlap_size + seamList[i][y] + 1 : image->width;
+			memcpy(resultRow + (offset[i] + start) * channels, 
+				image->imageData + y * image->widthStep + start * channels, (end - start) * channels);
+		}
+	}
+
+	for(int i = 0; i < count - 1; i++)
+		delete[] seamList[i];
+	delete[] seamList;
+	delete[] offset;
 	return result;
 }
 
+short* ImageMergeCarving::CreateOverlapCost(IplImage* image1, IplImage* image2, int overlap_size)
+{
+	int height = image1->height;
+	int channels = image1->nChannels;
+	short* cost = new short[overlap_size * height];
+
+	for(int y = 0; y < height; y++)
+	{
+		// the overlap of image2 is shifted 1 pixel, as in GetOverlapImages
+		unsigned char* row1 = (unsigned char*)(image1->imageData + y * image1->widthStep) + 
+			(image1->width - overlap_size) * channels;
+		unsigned char* row2 = (unsigned char*)(image2->imageData + y * image2->widthStep) + channels;
+		short* costRow = cost + y * overlap_size;
+		for(int x = 0; x < overlap_size; x++)
+		{
+			int sum = 0;
+			for(int i = 0; i < channels; i++)
+				sum += abs(row1[x * channels + i] - row2[x * channels + i]);
+			costRow[x] = sum;
+		}
+	}
+	return cost;
+}
+
+void ImageMergeCarving::GetMinSeam(short* cost, int width, int height, int* seam)
+{
+	// cumulative cost of the row above and of the current row
+	int* previous = new int[width];
+	int* current = new int[width];
+	// -1, 0, 1: the path comes from the left, directly above or the right
+	char* step = new char[width * height];
+
+	for(int x = 0; x < width; x++)
+	{
+		previous[x] = cost[x];
+		step[x] = 0;
+	}
+
+	for(int y = 1; y < height; y++)
+	{
+		short* costRow = cost + y * width;
+		char* stepRow = step + y * width;
+		for(int x = 0; x < width; x++)
+		{
+			// favor the directly above pixel
+			int best = previous[x];
+			char direction = 0;
+			if(x > 0 && previous[x - 1] < best)
+			{
+				best = previous[x - 1];
+				direction = -1;
+			}
+			if(x < width - 1 && previous[x + 1] < best)
+			{
+				best = previous[x + 1];
+				direction = 1;
+			}
+			current[x] = best + costRow[x];
+			stepRow[x] = direction;
+		}
+		int* swap = previous;
+		previous = current;
+		current = swap;
+	}
+
+	// from bottom up
+	int position = 0;
+	for(int x = 1; x < width; x++)
+		if(previous[x] < previous[position])
+			position = x;
+	for(int y = height - 1; y >= 0; y--)
+	{
+		seam[y] = position;
+		position += step[y * width + position];
+	}
+
+	delete[] previous;
+	delete[] current;
+	delete[] step;
+}
+
 IplImage* ImageMergeCarving::CreateOverlapImageCost(IplImage* overlap1, IplImage* overlap2)
 {
 	int height = overlap1->height;
@@ -1,5 +1,6 @@
 #pragma once
 #include <cv.h>
+#include <string.h>
 #include "EnergyPath.h"
 #include "RegionExtractor.h"
 #include "DrawingFunctions.h"
@@ -23,6 +24,21 @@ public:
 	// slide 2 images over to see with which seam the 2 can be combined
 	virtual IplImage* GetMergedImage(IplImage* image1, IplImage* image2, int overlap_size);
 
+	// merge images having the same height from left to right, each one 
+	// overlapping the next by overlap_size columns. The seams of all overlaps
+	// are found in parallel, then every row is put together in one pass
+	virtual IplImage* GetMergedImage(IplImage** imageList, int count, int overlap_size);
+
+	// cost of the overlap of image1 and image2, as CreateOverlapImageCost on 
+	// the images of GetOverlapImages: the sum of absolute channel differences
+	// between the 2 pixels which become neighbors when the seam passes there.
+	// overlap_size x height values, 16 bit
+	virtual short* CreateOverlapCost(IplImage* image1, IplImage* image2, int overlap_size);
+
+	// minimum vertical path through the cost, by dynamic programming over 
+	// cumulative cost rows. seam[y] is the column of the path in row y
+	virtual void GetMinSeam(short* cost, int width, int height, int* seam);
+
 public:
 	// PRIVATE: get overlap area between 2 images
 	// the overlap area of right image is shifted 1 pixel
@@ -1,112 +1,254 @@
 #pragma once
 #include <cv.h>
+#include <string.h>
+#include <vector>
+using namespace std;
+
+// memory layout of a Matrix3D, axes from outermost to innermost
+// frame by frame, as a video: each Z slice is an image
+#define MAT3D_LAYOUT_ZYX 0
+// plane by plane along x: each X slice (y across, z down) is an image
+#define MAT3D_LAYOUT_XZY 1
+
+// IplImage depth of an element type
+template<typename T> struct Matrix3DDepth {};
+template<> struct Matrix3DDepth<unsigned char> { enum { depth = IPL_DEPTH_8U }; };
+template<> struct Matrix3DDepth<int> { enum { depth = IPL_DEPTH_32S }; };
+template<> struct Matrix3DDepth<float> { enum { depth = IPL_DEPTH_32F }; };
+
+// a block of voxels [x0, x1) x [y0, y1) x [z0, z1)
+struct Matrix3DTile
+{
+	int x0, y0, z0;
+	int x1, y1, z1;
+};
 
+// a 2D view into a Matrix3D, no data is copied.
+// Pixel (u, v) is at data + v * rowStep + u * pixelStep (in elements)
+template<typename T, int Channels>
+struct Matrix3DSlice
+{
+	T* data;
+	int width;
+	int height;
+	int pixelStep;
+	int rowStep;
 
-#define MAT3D_8S 0
-#define MAT3D_16S 1
+	inline T* Pixel(int u, int v) { return data + v * rowStep + u * pixelStep; }
 
+	// pixels of a row are next to each other, so an IplImage can share the data
+	inline bool IsContiguous() { return pixelStep == Channels; }
 
+	// point header at the slice data. Only for contiguous slices
+	void InitImageHeader(IplImage* header)
+	{
+		cvInitImageHeader(header, cvSize(width, height), Matrix3DDepth<T>::depth, Channels);
+		cvSetData(header, data, rowStep * sizeof(T));
+	}
+
+	// image must have the size, depth and channels of the slice
+	void CopyTo(IplImage* image)
+	{
+		for(int v = 0; v < height; v++)
+		{
+			T* row = (T*)(image->imageData + v * image->widthStep);
+			if(IsContiguous())
+			{
+				memcpy(row, Pixel(0, v), width * Channels * sizeof(T));
+				continue;
+			}
+			for(int u = 0; u < width; u++)
+				memcpy(row + u * Channels, Pixel(u, v), Channels * sizeof(T));
+		}
+	}
+
+	void CopyFrom(IplImage* image)
+	{
+		for(int v = 0; v < height; v++)
+		{
+			T* row = (T*)(image->imageData + v * image->widthStep);
+			if(IsContiguous())
+			{
+				memcpy(Pixel(0, v), row, width * Channels * sizeof(T));
+				continue;
+			}
+			for(int u = 0; u < width; u++)
+				memcpy(Pixel(u, v), row + u * Channels, Channels * sizeof(T));
+		}
+	}
+
+	// the slice as an image: the slice data itself through header when it is 
+	// contiguous, otherwise buffer, holding a copy if copyData is set
+	IplImage* GetImage(IplImage* header, IplImage* buffer, bool copyData = true)
+	{
+		if(IsContiguous())
+		{
+			InitImageHeader(header);
+			return header;
+		}
+		if(copyData)
+			CopyTo(buffer);
+		return buffer;
+	}
+
+	// store an image from GetImage back to the slice
+	void StoreImage(IplImage* image)
+	{
+		if(!IsContiguous())
+			CopyFrom(image);
+	}
+};
+
+// a video volume of width x height x length voxels, Channels elements of 
+// type T each, in one contiguous buffer
+template<typename T, int Channels>
 class Matrix3D
 {
 public:
-	// default 1 channel
-	Matrix3D(int width, int height, int length);
-	Matrix3D(int width, int height, int length, int channel);
-	~Matrix3D(void);
+	Matrix3D(int width, int height, int length, int layout = MAT3D_LAYOUT_ZYX)
+	{
+		_width = width;
+		_height = height;
+		_length = length;
+		_layout = layout;
+		_channel = Channels;
+		_type = Matrix3DDepth<T>::depth;
+
+		if(layout == MAT3D_LAYOUT_XZY)
+		{
+			_stepY = Channels;
+			_stepZ = height * Channels;
+			_stepX = length * height * Channels;
+		}
+		else
+		{
+			_stepX = Channels;
+			_stepY = width * Channels;
+			_stepZ = height * width * Channels;
+		}
+		_data = (T*)malloc(width * height * length * Channels * sizeof(T));
+	}
+
+	~Matrix3D(void)
+	{
+		free(_data);
+	}
 
 	int _width;
 	int _height;
 	int _length;
 	int _channel;
+	// IplImage depth of the elements
 	int _type;
+	int _layout;
+	// elements between neighbor voxels along each axis
+	int _stepX;
+	int _stepY;
+	int _stepZ;
+	T* _data;
 
 	// check whether the coordinate is inside the volume
-	bool IsCoordinateInside(int x, int y, int z);
-	virtual double Get3D(int x, int y, int z) = 0;
-	virtual CvScalar Get3DScalar(int x, int y, int z) = 0;
-	virtual void Set3D(int x, int y, int z, double value) = 0;
-	virtual void Set3DScalar(int x, int y, int z, CvScalar value) = 0;
-
-	virtual void GetIplImageZ(int z, IplImage* image);
-	virtual void GetIplImageX(int x, IplImage* image);
-
-	// fill a image to the matrix
-	virtual void SetIplImageZ(int z, IplImage* image);
-	virtual void SetIplImageX(int x, IplImage* image);
- 
-	char* _data;	
-};
-
-class Matrix3DChar : public Matrix3D
-{
-public:
-	// default 1 channel
-	Matrix3DChar(int width, int height, int length) : Matrix3D(width, height, length)
-	{	
-		_data = (char*)malloc(length * width * height * sizeof(unsigned char));
-		_type = IPL_DEPTH_8U;
+	inline bool IsCoordinateInside(int x, int y, int z)
+	{
+		return x >= 0 && x < _width && y >= 0 && y < _height && z >= 0 && z < _length;
 	}
 
-	Matrix3DChar(int width, int height, int length, int channel) : Matrix3D(width, height, length, channel)
+	// first channel of the voxel, no bound check
+	inline T* Voxel(int x, int y, int z)
 	{
-		_data = (char*)malloc(length * width * height * channel * sizeof(unsigned char));
-		_type = IPL_DEPTH_8U;
+		return _data + x * _stepX + y * _stepY + z * _stepZ;
 	}
 
-	~Matrix3DChar(void);		
-
-	virtual double Get3D(int x, int y, int z);
-	virtual CvScalar Get3DScalar(int x, int y, int z);
-	virtual void Set3D(int x, int y, int z, double value);
-	virtual void Set3DScalar(int x, int y, int z, CvScalar value);
-};
-
-class Matrix3DInt : public Matrix3D
-{
-public:
-
-	// default 1 channel
-	Matrix3DInt(int width, int height, int length) : Matrix3D(width, height, length)
-	{	
-		_data = (char*)malloc(length * width * height * sizeof(unsigned int));
-		_type = IPL_DEPTH_16U;
+	// zero outside the volume
+	inline T Get3D(int x, int y, int z, int channel = 0)
+	{
+		if(!IsCoordinateInside(x, y, z))
+			return 0;
+		return Voxel(x, y, z)[channel];
 	}
 
-	Matrix3DInt(int width, int height, int length, int channel) : Matrix3D(width, height, length, channel)
+	inline void Set3D(int x, int y, int z, T value, int channel = 0)
 	{
-		_data = (char*)malloc(length * width * height * channel * sizeof(unsigned int));
-		_type = IPL_DEPTH_8U;
+		if(IsCoordinateInside(x, y, z))
+			Voxel(x, y, z)[channel] = value;
 	}
 
-	~Matrix3DInt(void);
-
-	virtual double Get3D(int x, int y, int z);
-	virtual CvScalar Get3DScalar(int x, int y, int z);
-	virtual void Set3D(int x, int y, int z, double value);
-	virtual void Set3DScalar(int x, int y, int z, CvScalar value);
-};
+	// zero outside the volume
+	inline CvScalar Get3DScalar(int x, int y, int z)
+	{
+		CvScalar value = cvScalar(0);
+		if(IsCoordinateInside(x, y, z))
+		{
+			T* voxel = Voxel(x, y, z);
+			for(int i = 0; i < Channels; i++)
+				value.val[i] = voxel[i];
+		}
+		return value;
+	}
 
+	inline void Set3DScalar(int x, int y, int z, CvScalar value)
+	{
+		if(IsCoordinateInside(x, y, z))
+		{
+			T* voxel = Voxel(x, y, z);
+			for(int i = 0; i < Channels; i++)
+				voxel[i] = (T)value.val[i];
+		}
+	}
 
-class Matrix3DFloat : public Matrix3D
-{
-public:
-	// default 1 channel
-	Matrix3DFloat(int width, int height, int length) : Matrix3D(width, height, length)
-	{	
-		_data = (char*)malloc(length * width * height * sizeof(float));
-		_type = IPL_DEPTH_32F;
+	// frame z, width x height
+	Matrix3DSlice<T, Channels> SliceZ(int z)
+	{
+		Matrix3DSlice<T, Channels> slice;
+		slice.data = Voxel(0, 0, z);
+		slice.width = _width;
+		slice.height = _height;
+		slice.pixelStep = _stepX;
+		slice.rowStep = _stepY;
+		return slice;
 	}
 
-	Matrix3DFloat(int width, int height, int length, int channel) : Matrix3D(width, height, length, channel)
+	// y across and z down, height x length
+	Matrix3DSlice<T, Channels> SliceX(int x)
 	{
-		_data = (char*)malloc(length * width * height * channel * sizeof(float));
-		_type = IPL_DEPTH_32F;
+		Matrix3DSlice<T, Channels> slice;
+		slice.data = Voxel(x, 0, 0);
+		slice.width = _height;
+		slice.height = _length;
+		slice.pixelStep = _stepY;
+		slice.rowStep = _stepZ;
+		return slice;
 	}
 
-	~Matrix3DFloat(void);
+	// copy a slice to or from an image of the slice size
+	void GetIplImageZ(int z, IplImage* image) { SliceZ(z).CopyTo(image); }
+	void GetIplImageX(int x, IplImage* image) { SliceX(x).CopyTo(image); }
+	void SetIplImageZ(int z, IplImage* image) { SliceZ(z).CopyFrom(image); }
+	void SetIplImageX(int x, IplImage* image) { SliceX(x).CopyFrom(image); }
+
+	// split the volume into tiles of at most tileX x tileY x tileZ voxels, 
+	// so that each tile can be processed on its own
+	void GetTiles(int tileX, int tileY, int tileZ, vector<Matrix3DTile>& tiles)
+	{
+		tiles.clear();
+		for(int z = 0; z < _length; z += tileZ)
+			for(int y = 0; y < _height; y += tileY)
+				for(int x = 0; x < _width; x += tileX)
+				{
+					Matrix3DTile tile;
+					tile.x0 = x;
+					tile.y0 = y;
+					tile.z0 = z;
+					tile.x1 = MIN(x + tileX, _width);
+					tile.y1 = MIN(y + tileY, _height);
+					tile.z1 = MIN(z + tileZ, _length);
+					tiles.push_back(tile);
+				}
+	}
+};
 
-	virtual double Get3D(int x, int y, int z);
-	virtual CvScalar Get3DScalar(int x, int y, int z);
-	virtual void Set3D(int x, int y, int z, double value);
-	virtual void Set3DScalar(int x, int y, int z, CvScalar value);
-};
\ No newline at end of file
+typedef Matrix3D<unsigned char, 1> Matrix3D8UC1;
+typedef Matrix3D<unsigned char, 3> Matrix3D8UC3;
+typedef Matrix3D<int, 1> Matrix3D32SC1;
+typedef Matrix3D<float, 1> Matrix3D32FC1;
+typedef Matrix3D<float, 3> Matrix3D32FC3;
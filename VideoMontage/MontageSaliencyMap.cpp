@@ -1,9 +1,103 @@
 #include "StdAfx.h"
 #include "MontageSaliencyMap.h"
 
+// offsets (dx, dy, dz) of the 6 or 26 neighbors, return their number
+static int GetNeighborOffsets(int neighbor, int offsets[26][3])
+{
+	int count = 0;
+	for(int dz = -1; dz <= 1; dz++)
+		for(int dy = -1; dy <= 1; dy++)
+			for(int dx = -1; dx <= 1; dx++)
+			{
+				int distance = abs(dx) + abs(dy) + abs(dz);
+				if(distance == 0 || (neighbor == NEIGHBOR_6 && distance > 1))
+					continue;
+				offsets[count][0] = dx;
+				offsets[count][1] = dy;
+				offsets[count][2] = dz;
+				count++;
+			}
+	return count;
+}
+
+// sum of L2 distances between each pixel of the current frame and its 
+// neighbors in the frames around it. frames holds the previous, current and 
+// next frame, 3 floats per pixel, NULL outside the volume. Neighbors outside 
+// are left out
+static void ContrastFrame(float* frames[3], int width, int height, int neighbor, 
+	float* output, int pixelStep, int rowStep)
+{
+	int offsets[26][3];
+	int offsetCount = GetNeighborOffsets(neighbor, offsets);
+
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++)
+	{
+		float* sum = new float[width];
+		for(int x = 0; x < width; x++)
+			sum[x] = 0;
+
+		const float* center = frames[1] + y * width * 3;
+		for(int n = 0; n < offsetCount; n++)
+		{
+			int dx = offsets[n][0];
+			int ny = y + offsets[n][1];
+			const float* frame = frames[offsets[n][2] + 1];
+			if(frame == NULL || ny < 0 || ny >= height)
+				continue;
+
+			// one shifted row at a time, the loop is straight over memory
+			const float* row = frame + ny * width * 3;
+			int begin = MAX(0, -dx);
+			int end = MIN(width, width - dx);
+			for(int x = begin; x < end; x++)
+			{
+				const float* value = row + (x + dx) * 3;
+				float d0 = center[x * 3] - value[0];
+				float d1 = center[x * 3 + 1] - value[1];
+				float d2 = center[x * 3 + 2] - value[2];
+				sum[x] += sqrt(d0 * d0 + d1 * d1 + d2 * d2);
+			}
+		}
+
+		float* outputRow = output + y * rowStep;
+		for(int x = 0; x < width; x++)
+			outputRow[x * pixelStep] = sum[x];
+		delete[] sum;
+	}
+}
+
+// frame z of a matrix as 3 floats per pixel
+static void LoadFrame(Matrix3D8UC3* matrix, int z, float* frame)
+{
+	Matrix3DSlice<unsigned char, 3> slice = matrix->SliceZ(z);
+	for(int y = 0; y < slice.height; y++)
+		for(int x = 0; x < slice.width; x++)
+		{
+			unsigned char* pixel = slice.Pixel(x, y);
+			float* value = frame + (y * slice.width + x) * 3;
+			value[0] = pixel[0];
+			value[1] = pixel[1];
+			value[2] = pixel[2];
+		}
+}
+
+// BGR image converted to LUV, 3 floats per pixel
+static void LoadFrame(IplImage* image, IplImage* luv, float* frame)
+{
+	cvCvtColor(image, luv, CV_BGR2Luv);
+	for(int y = 0; y < luv->height; y++)
+	{
+		unsigned char* row = (unsigned char*)(luv->imageData + y * luv->widthStep);
+		float* value = frame + y * luv->width * 3;
+		for(int x = 0; x < luv->width * 3; x++)
+			value[x] = row[x];
+	}
+}
+
 MontageSaliencyMap::MontageSaliencyMap(MontageSaliencySetting* setting)
 {
-	//_neighbor = 6;
+	_neighbor = NEIGHBOR_6;
 	_setting = setting;
 }
 
@@ -13,64 +107,142 @@ MontageSaliencyMap::~MontageSaliencyMap(void)
 
 void MontageSaliencyMap::CalculateSaliencyMap(Volume3D *volume, Volume3D *output)
 {
-	// first convert the volume to LUV?
-
 	switch(_neighbor)
 	{
-	// calculate based on 6 neighbor
+	// calculate based on 6 or 26 neighbor
 	case NEIGHBOR_6:
-		Distance6Neighbor(volume, output);
+	case NEIGHBOR_26:
+		DistanceNeighbor(volume, output);
 		break;
 	default:
 		break;
 	}
 }
 
-void MontageSaliencyMap::Distance6Neighbor(Volume3D* volume, Volume3D* output)
+void MontageSaliencyMap::DistanceNeighbor(Volume3D* volume, Volume3D* output)
 {
 	int length = volume->_length;
 	int width = volume->_width;
 	int height = volume->_height;
 
+	IplImage* luv = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 3);
+	float* buffer[3];
+	for(int i = 0; i < 3; i++)
+		buffer[i] = new float[width * height * 3];
+
+	// buffer[(t + 1) % 3] holds frame t, loaded one frame ahead
+	if(length > 0)
+		LoadFrame(volume->GetFrame(0), luv, buffer[1]);
 	for(int t = 0; t < length; t++)
 	{
-		// for each frame
-		for(int x = 0; x < width; x++)
-			for(int y = 0; y < height; y++)
-			{
-				// for each pixel of the frame
-				// get its neighbor
-				
-			}
+		if(t + 1 < length)
+			LoadFrame(volume->GetFrame(t + 1), luv, buffer[(t + 2) % 3]);
+
+		float* frames[3];
+		frames[0] = t > 0 ? buffer[t % 3] : NULL;
+		frames[1] = buffer[(t + 1) % 3];
+		frames[2] = t + 1 < length ? buffer[(t + 2) % 3] : NULL;
+
+		IplImage* frame = output->GetFrame(t);
+		ContrastFrame(frames, width, height, _neighbor, (float*)frame->imageData, 1, frame->widthStep / sizeof(float));
+	}
+
+	for(int i = 0; i < 3; i++)
+		delete[] buffer[i];
+	cvReleaseImage(&luv);
+}
+
+void MontageSaliencyMap::CalculateSaliencyMap(Matrix3D8UC3* matrix, Matrix3D32FC1* output)
+{
+	switch(_neighbor)
+	{
+	case NEIGHBOR_6:
+	case NEIGHBOR_26:
+		DistanceNeighbor(matrix, output);
+		break;
+	case NEIGHBOR_BLOCK:
+		DistanceBlock(matrix, output);
+		break;
+	default:
+		break;
 	}
 }
 
-void MontageSaliencyMap::CalculateSaliencyMap(Matrix3D* matrix, Matrix3D* output)
+void MontageSaliencyMap::DistanceNeighbor(Matrix3D8UC3* matrix, Matrix3D32FC1* output)
+{
+	int width = matrix->_width;
+	int height = matrix->_height;
+	int length = matrix->_length;
+	int slabCount = (length + MONTAGE_SLAB_FRAMES - 1) / MONTAGE_SLAB_FRAMES;
+
+	// each slab streams its frames through its own 3 buffers
+	#pragma omp parallel for schedule(dynamic)
+	for(int slab = 0; slab < slabCount; slab++)
+	{
+		int begin = slab * MONTAGE_SLAB_FRAMES;
+		int end = MIN(begin + MONTAGE_SLAB_FRAMES, length);
+		float* buffer[3];
+		for(int i = 0; i < 3; i++)
+			buffer[i] = new float[width * height * 3];
+
+		// buffer[(z + 1) % 3] holds frame z, loaded one frame ahead
+		if(begin > 0)
+			LoadFrame(matrix, begin - 1, buffer[begin % 3]);
+		LoadFrame(matrix, begin, buffer[(begin + 1) % 3]);
+		for(int z = begin; z < end; z++)
+		{
+			if(z + 1 < length)
+				LoadFrame(matrix, z + 1, buffer[(z + 2) % 3]);
+
+			float* frames[3];
+			frames[0] = z > 0 ? buffer[z % 3] : NULL;
+			frames[1] = buffer[(z + 1) % 3];
+			frames[2] = z + 1 < length ? buffer[(z + 2) % 3] : NULL;
+
+			Matrix3DSlice<float, 1> slice = output->SliceZ(z);
+			ContrastFrame(frames, width, height, _neighbor, slice.data, slice.pixelStep, slice.rowStep);
+		}
+
+		for(int i = 0; i < 3; i++)
+			delete[] buffer[i];
+	}
+}
+
+void MontageSaliencyMap::DistanceBlock(Matrix3D8UC3* matrix, Matrix3D32FC1* output)
 {	
 	int width = matrix->_width;
 	int height = matrix->_height;
 	int length = matrix->_length;
+	int block_size = 2;
+	// voxels outside the volume count as zero
+	CvScalar zero = cvScalar(0);
 
+	#pragma omp parallel for schedule(dynamic)
 	for(int z = 0; z < length; z++)		
 	{	
-		printf("Processing frame %i \n", z);
-		for(int x = 0; x < width; x++)
-			for(int y = 0; y < height; y++)
+		for(int y = 0; y < height; y++)
+			for(int x = 0; x < width; x++)
 			{
-				CvScalar center = matrix->Get3DScalar(x, y, z);
+				unsigned char* voxel = matrix->Voxel(x, y, z);
+				CvScalar center = cvScalar(voxel[0], voxel[1], voxel[2]);
 				double sum_diff = 0;
 
-				int block_size = 2;
 				// calculate difference within the block
-				for(int i = x - block_size; i <= x + block_size; i++)
+				for(int k = z - block_size; k <= z + block_size; k++)
 					for(int j = y - block_size; j <= y + block_size; j++)
-						for(int k = z - block_size; k <= z + block_size; k++)
+						for(int i = x - block_size; i <= x + block_size; i++)
 						{
-							CvScalar value = matrix->Get3DScalar(i, j, k);
-							double diff = _setting->norm->CalculateNorm(value, center);
+							double diff;
+							if(matrix->IsCoordinateInside(i, j, k))
+							{
+								unsigned char* neighbor = matrix->Voxel(i, j, k);
+								diff = _setting->norm->CalculateNorm(cvScalar(neighbor[0], neighbor[1], neighbor[2]), center);
+							}
+							else
+								diff = _setting->norm->CalculateNorm(zero, center);
 							sum_diff += diff;
 						}						
-				output->Set3D(x, y, z, sum_diff);				
+				*output->Voxel(x, y, z) = sum_diff;
 			}	
 	}
 }
\ No newline at end of file
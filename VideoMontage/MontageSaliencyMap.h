@@ -4,6 +4,14 @@
 #include "Norm.h"
 #include "Scaling.h"
 
+// the 26 voxels of the 3x3x3 block around a voxel
+#define NEIGHBOR_26 26
+// the 5x5x5 block around a voxel, outside voxels counted as zero
+#define NEIGHBOR_BLOCK 125
+
+// frames of a Matrix3D given to one thread
+#define MONTAGE_SLAB_FRAMES 8
+
 struct MontageSaliencySetting
 {
 	Norm* norm;
@@ -22,8 +30,9 @@ public:
 	MontageSaliencySetting* _setting;
 	
 	// neighbor setting
-	// NEIGHBOR_6
-	// others: default to NEIGHBOR_6 (will be extended later)
+	// NEIGHBOR_6, NEIGHBOR_26: L2 contrast in LUV to the existing neighbors
+	// NEIGHBOR_BLOCK: _setting->norm over the 5x5x5 block (Matrix3D only)
+	// default to NEIGHBOR_6
 	int _neighbor;
 	
 #pragma endregion
@@ -33,10 +42,16 @@ public:
 	// Distance function is based on the _norm used	
 	virtual void CalculateSaliencyMap(Volume3D* volume, Volume3D* output);
 	
-	virtual void CalculateSaliencyMap(Matrix3D* matrix, Matrix3D* output);
+	virtual void CalculateSaliencyMap(Matrix3D8UC3* matrix, Matrix3D32FC1* output);
 	
 protected:
-	// calculate distance between a pixel and its 6 neighbors in 3D space
-	virtual void Distance6Neighbor(Volume3D* volume, Volume3D* output);
+	// calculate distance between a pixel and its 6 or 26 neighbors in 3D space.
+	// Frames are streamed through a buffer of 3, rows of a frame run in parallel.
+	// Volume frames are BGR and converted to LUV, output frames are 32F 1 channel
+	virtual void DistanceNeighbor(Volume3D* volume, Volume3D* output);
+	// same on a matrix already in LUV, each slab of frames on its own thread
+	virtual void DistanceNeighbor(Matrix3D8UC3* matrix, Matrix3D32FC1* output);
+	// the 5x5x5 block with the norm of the setting
+	virtual void DistanceBlock(Matrix3D8UC3* matrix, Matrix3D32FC1* output);
  
 };
@@ -190,24 +190,156 @@ CvScalar ROIBlend::GetBlendScalar2(CvScalar value, CvScalar seam, int p, int dev
 	return blendValue;
 }
 
+// copy count columns of src from srcX to dst at dstX, row by row
+static void CopyColumns(IplImage* dst, int dstX, IplImage* src, int srcX, int count)
+{
+	int pixelSize = (src->depth & 255) / 8 * src->nChannels;
+	for(int y = 0; y < src->height; y++)
+		memcpy(dst->imageData + y * dst->widthStep + dstX * pixelSize, 
+			src->imageData + y * src->widthStep + srcX * pixelSize, count * pixelSize);
+}
+
+static inline unsigned char SaturateBlend(double value)
+{
+	int rounded = cvRound(value);
+	return (unsigned char)(rounded < 0 ? 0 : (rounded > 255 ? 255 : rounded));
+}
+
+// dst(dstX + i) = src1(x1 + i) * weights[i] + src2(x2 + i * step2) * (1 - weights[i])
+// for count columns on every row. With step2 = 0 src2 gives a single column,
+// the seam. Images are 8 bit, as loaded
+static void BlendColumns(IplImage* dst, int dstX, IplImage* src1, int x1, IplImage* src2, int x2, int step2, 
+	const double* weights, int count)
+{
+	int channels = dst->nChannels;
+	#pragma omp parallel for
+	for(int y = 0; y < dst->height; y++)
+	{
+		unsigned char* dstRow = (unsigned char*)(dst->imageData + y * dst->widthStep) + dstX * channels;
+		unsigned char* row1 = (unsigned char*)(src1->imageData + y * src1->widthStep) + x1 * channels;
+		unsigned char* row2 = (unsigned char*)(src2->imageData + y * src2->widthStep) + x2 * channels;
+		for(int i = 0; i < count; i++)
+		{
+			double weight = weights[i];
+			unsigned char* pixel1 = row1 + i * channels;
+			unsigned char* pixel2 = row2 + i * step2 * channels;
+			for(int c = 0; c < channels; c++)
+				dstRow[i * channels + c] = SaturateBlend(pixel1[c] * weight + pixel2[c] * (1 - weight));
+		}
+	}
+}
+
+// weight of image1 over an overlap of size columns, as GetBlendScalar2 with
+// the Gaussian mean in the middle
+static double* GetOverlapWeights(int size, int std)
+{
+	double* weights = new double[size];
+	int mean = size / 2;
+	for(int x = 0; x < size; x++)
+		weights[x] = NormalDistribution((double)(mean - x) / std);
+	return weights;
+}
+
+// Laplacian pyramid blend of size columns of src1 from x1 and src2 from x2 
+// into dst at dstX. Images are padded to a multiple of the top level scale
+static void MultiBandColumns(IplImage* dst, int dstX, IplImage* src1, int x1, IplImage* src2, int x2, 
+	int size, int levels)
+{
+	int height = dst->height;
+	int channels = dst->nChannels;
+	while(levels > 1 && (1 << levels) > size)
+		levels--;
+	if(levels < 1)
+		levels = 1;
+	int unit = 1 << levels;
+	CvSize padded = cvSize((size + unit - 1) / unit * unit, (height + unit - 1) / unit * unit);
+
+	IplImage** pyramid1 = new IplImage*[levels + 1];
+	IplImage** pyramid2 = new IplImage*[levels + 1];
+	IplImage** mask = new IplImage*[levels + 1];
+
+	// the overlaps, padded by replicating their border
+	IplImage* overlap = cvCreateImage(cvSize(size, height), IPL_DEPTH_8U, channels);
+	IplImage* border = cvCreateImage(padded, IPL_DEPTH_8U, channels);
+	IplImage* sources[2] = {src1, src2};
+	int sourceX[2] = {x1, x2};
+	IplImage** pyramids[2] = {pyramid1, pyramid2};
+	for(int i = 0; i < 2; i++)
+	{
+		CopyColumns(overlap, 0, sources[i], sourceX[i], size);
+		cvCopyMakeBorder(overlap, border, cvPoint(0, 0), IPL_BORDER_REPLICATE);
+		pyramids[i][0] = cvCreateImage(padded, IPL_DEPTH_32F, channels);
+		cvConvert(border, pyramids[i][0]);
+	}
+
+	// image1 on the left half, pyramid levels of the mask smooth the step
+	mask[0] = cvCreateImage(padded, IPL_DEPTH_32F, channels);
+	cvZero(mask[0]);
+	cvSetImageROI(mask[0], cvRect(0, 0, size / 2, padded.height));
+	cvSet(mask[0], cvScalarAll(1));
+	cvResetImageROI(mask[0]);
+
+	// gaussian pyramids
+	for(int l = 1; l <= levels; l++)
+	{
+		CvSize levelSize = cvSize(padded.width >> l, padded.height >> l);
+		pyramid1[l] = cvCreateImage(levelSize, IPL_DEPTH_32F, channels);
+		pyramid2[l] = cvCreateImage(levelSize, IPL_DEPTH_32F, channels);
+		mask[l] = cvCreateImage(levelSize, IPL_DEPTH_32F, channels);
+		cvPyrDown(pyramid1[l - 1], pyramid1[l]);
+		cvPyrDown(pyramid2[l - 1], pyramid2[l]);
+		cvPyrDown(mask[l - 1], mask[l]);
+	}
+
+	// laplacian levels, then blend each band: image2 + mask * (image1 - image2)
+	for(int l = 0; l <= levels; l++)
+	{
+		if(l < levels)
+		{
+			IplImage* expanded = cvCreateImage(cvGetSize(pyramid1[l]), IPL_DEPTH_32F, channels);
+			cvPyrUp(pyramid1[l + 1], expanded);
+			cvSub(pyramid1[l], expanded, pyramid1[l]);
+			cvPyrUp(pyramid2[l + 1], expanded);
+			cvSub(pyramid2[l], expanded, pyramid2[l]);
+			cvReleaseImage(&expanded);
+		}
+		cvSub(pyramid1[l], pyramid2[l], pyramid1[l]);
+		cvMul(pyramid1[l], mask[l], pyramid1[l]);
+		cvAdd(pyramid2[l], pyramid1[l], pyramid1[l]);
+	}
+
+	// collapse
+	for(int l = levels - 1; l >= 0; l--)
+	{
+		IplImage* expanded = cvCreateImage(cvGetSize(pyramid1[l]), IPL_DEPTH_32F, channels);
+		cvPyrUp(pyramid1[l + 1], expanded);
+		cvAdd(pyramid1[l], expanded, pyramid1[l]);
+		cvReleaseImage(&expanded);
+	}
+	cvConvert(pyramid1[0], border);
+	CopyColumns(dst, dstX, border, 0, size);
+
+	for(int l = 0; l <= levels; l++)
+	{
+		cvReleaseImage(&pyramid1[l]);
+		cvReleaseImage(&pyramid2[l]);
+		cvReleaseImage(&mask[l]);
+	}
+	delete[] pyramid1;
+	delete[] pyramid2;
+	delete[] mask;
+	cvReleaseImage(&overlap);
+	cvReleaseImage(&border);
+}
+
 IplImage* ROIBlend::CombineImages(IplImage* image1, IplImage* image2)
 {
 	IplImage* image = cvCreateImage(
 		cvSize(image1->width + image2->width, image1->height), 
 		image1->depth, image1->nChannels);
 	
-	for(int x = 0; x < image1->width; x++)
-		for(int y = 0; y < image1->height; y++)
-		{
-			CvScalar value = cvGet2D(image1, y, x);
-			cvSet2D(image, y, x, value);
-		}
-	for(int x = 0; x < image2->width; x++)
-		for(int y = 0; y < image2->height; y++)
-		{
-			CvScalar value = cvGet2D(image2, y, x);
-			cvSet2D(image, y, x + image1->width, value);
-		}
+	CopyColumns(image, 0, image1, 0, image1->width);
+	CopyColumns(image, image1->width, image2, 0, image2->width);
 	return image;
 }
 
@@ -226,32 +358,24 @@ IplImage* ROIBlend::BlendImages1(IplImage* image1, IplImage* image2, int a, int
 	IplImage* image1_clone = cvCloneImage(image1);
 	IplImage* image2_clone = cvCloneImage(image2);
 
-	IplImage* image = cvCreateImage(cvSize(width1 + width2, height1), image1->depth, image1->nChannels);
-
+	// the blend weight only depends on the column, integrate once per column
 	// for S part
+	int countS = width1 - _a;
+	double* weights = new double[MAX(countS, _b - width1)];
 	for(int x = _a; x < width1; x++)
-	{
-		for(int y = 0; y < height1; y++)
-		{
-			CvScalar value = cvGet2D(image1, y, x);
-			CvScalar seamValue = cvGet2D(image2, y, 0);
-			CvScalar blendValue = GetBlendScalar(value, seamValue, x, true);
-			cvSet2D(image1_clone, y, x, blendValue);
-		}
-	}
+		weights[x - _a] = calcDefiniteIntergral(x, _a, x);
+	BlendColumns(image1_clone, _a, image1, _a, image2, 0, 0, weights, countS);
 	
 	// for T part
 	for(int x = 0; x < _b - width1; x++)
-	{
-		for(int y = 0; y < height2; y++)
-		{
-			CvScalar value = cvGet2D(image2, y, x);
-			CvScalar seamValue = cvGet2D(image1, y, width1 - 1);
-			CvScalar blendValue = GetBlendScalar(value, seamValue, x + width1, false);
-			cvSet2D(image2_clone, y, x, blendValue);
-		}
-	} 
-	return CombineImages(image1_clone, image2_clone);	 
+		weights[x] = calcDefiniteIntergral(x + width1, x + width1, _b);
+	BlendColumns(image2_clone, 0, image2, 0, image1, width1 - 1, 0, weights, _b - width1);
+	delete[] weights;
+
+	IplImage* image = CombineImages(image1_clone, image2_clone);
+	cvReleaseImage(&image1_clone);
+	cvReleaseImage(&image2_clone);
+	return image;
 }
 
 IplImage* ROIBlend::BlendImages2(IplImage* image1, IplImage* image2, int a, int b)
@@ -267,32 +391,24 @@ IplImage* ROIBlend::BlendImages2(IplImage* image1, IplImage* image2, int a, int
 	IplImage* image1_clone = cvCloneImage(image1);
 	IplImage* image2_clone = cvCloneImage(image2);
 
-	IplImage* image = cvCreateImage(cvSize(width1 + width2, height1), image1->depth, image1->nChannels);
-
 	// for S part
-	for(int x = width1 - _a - 30; x < width1; x++)
-	{
-		for(int y = 0; y < height1; y++)
-		{
-			CvScalar value = cvGet2D(image1, y, x);
-			CvScalar seamValue = cvGet2D(image2, y, 0);
-			CvScalar blendValue = GetBlendScalar2(value, seamValue, width1 - x, _a);
-			cvSet2D(image1_clone, y, x, blendValue);
-		}
-	}
+	int start = MAX(width1 - _a - 30, 0);
+	int countT = MIN(_b + 30, width2);
+	double* weights = new double[MAX(width1 - start, countT)];
+	for(int x = start; x < width1; x++)
+		weights[x - start] = NormalDistribution((double)(width1 - x) / _a);
+	BlendColumns(image1_clone, start, image1, start, image2, 0, 0, weights, width1 - start);
 	
 	// for T part
-	for(int x = 0; x < _b + 30; x++)
-	{
-		for(int y = 0; y < height2; y++)
-		{
-			CvScalar value = cvGet2D(image2, y, x);
-			CvScalar seamValue = cvGet2D(image1, y, width1 - 1);
-			CvScalar blendValue = GetBlendScalar2(value, seamValue, x, _b);
-			cvSet2D(image2_clone, y, x, blendValue);
-		}
-	}
-	return CombineImages(image1_clone, image2_clone);	 
+	for(int x = 0; x < countT; x++)
+		weights[x] = NormalDistribution((double)x / _b);
+	BlendColumns(image2_clone, 0, image2, 0, image1, width1 - 1, 0, weights, countT);
+	delete[] weights;
+
+	IplImage* image = CombineImages(image1_clone, image2_clone);
+	cvReleaseImage(&image1_clone);
+	cvReleaseImage(&image2_clone);
+	return image;
 }
 
 IplImage* ROIBlend::BlendImages3(IplImage* image1, IplImage* image2, int size, int std)
@@ -300,54 +416,69 @@ IplImage* ROIBlend::BlendImages3(IplImage* image1, IplImage* image2, int size, i
 	int width1 = image1->width;
 	int height1 = image1->height;
 	int width2 = image2->width;
-	int height2 = image2->height;
 
-	// get non-overlap part in image1	
-	IplImage* nonoverlap1 = cvCreateImage(cvSize(width1 - size, height1), image1->depth, image1->nChannels);	 
-	cvSetImageROI(image1, cvRect(0, 0, width1 - size, height1));
-	cvCopyImage(image1, nonoverlap1);	
-	
-	// get overlap area in image1
-	cvSetImageROI(image1, cvRect(width1 - size, 0, size, height1));
-	IplImage* overlap1 = cvCreateImage(cvSize(size, height1), image1->depth, image1->nChannels);
-	cvCopyImage(image1, overlap1);
+	// non-overlap parts go straight to the result
+	IplImage* result = cvCreateImage(cvSize(width1 + width2 - size, height1), image1->depth, image1->nChannels);
+	CopyColumns(result, 0, image1, 0, width1 - size);
+	CopyColumns(result, width1, image2, size, width2 - size);
 
-	// get the first part of 2nd image
-	cvSetImageROI(image2, cvRect(0,0, size, height2));
-	IplImage* overlap2 = cvCreateImage(cvSize(size, height2), image2->depth, image2->nChannels);
-	cvCopyImage(image2, overlap2);
+	// blend 2 overlap area using Gaussian
+	double* weights = GetOverlapWeights(size, std);
+	BlendColumns(result, width1 - size, image1, width1 - size, image2, 0, 1, weights, size);
+	delete[] weights;
+	return result;
+}
 
-	// get non-overlap area in image2
-	IplImage* nonoverlap2 = cvCreateImage(cvSize(width2 - size, height1), image2->depth, image2->nChannels);	 
-	cvSetImageROI(image2, cvRect(size, 0, width2 - size, height2));
-	cvCopyImage(image2, nonoverlap2);	
+IplImage* ROIBlend::BlendImagesMultiBand(IplImage* image1, IplImage* image2, int size, int levels)
+{	
+	int width1 = image1->width;
+	int height1 = image1->height;
+	int width2 = image2->width;
 
-	// blend 2 overlap area using Gaussian
-	IplImage* blendArea = cvCreateImage(cvSize(size, height2), image2->depth, image2->nChannels);
-	int mean = size / 2;
-	for(int x = 0; x < size; x++)
+	IplImage* result = cvCreateImage(cvSize(width1 + width2 - size, height1), image1->depth, image1->nChannels);
+	CopyColumns(result, 0, image1, 0, width1 - size);
+	CopyColumns(result, width1, image2, size, width2 - size);
+	MultiBandColumns(result, width1 - size, image1, width1 - size, image2, 0, size, levels);
+	return result;
+}
+
+IplImage* ROIBlend::BlendMultiple(IplImage** imageList, int count, int size, int para, int blendType)
+{
+	// an image in the middle overlaps on both sides
+	for(int i = 0; i < count; i++)
 	{
-		for(int y = 0; y < height1; y++)
-		{
-			CvScalar value1 = cvGet2D(overlap1, y, x);
-			CvScalar value2 = cvGet2D(overlap2, y, x);
-			CvScalar value = GetBlendScalar2(value1, value2, mean - x, std);
-			cvSet2D(blendArea, y, x, value);
-		}
+		int width = imageList[i]->width;
+		size = MIN(size, (i == 0 || i == count - 1) ? width : width / 2);
 	}
 
-	// combine 2 images
-	IplImage* firstPart = CombineImages(nonoverlap1, blendArea);
-	IplImage* result = CombineImages(firstPart, nonoverlap2);
-	
-	// release if using OpenCV 1.0
-	// here we use OpenCV 2.0 so no release is needed.
-	
-	cvReleaseImage(&overlap1);
-	cvReleaseImage(&overlap2);
-	cvReleaseImage(&nonoverlap1);
-	cvReleaseImage(&nonoverlap2);
-	cvReleaseImage(&firstPart);
+	int* offset = new int[count];
+	offset[0] = 0;
+	for(int i = 1; i < count; i++)
+		offset[i] = offset[i - 1] + imageList[i - 1]->width - size;
+	IplImage* result = cvCreateImage(cvSize(offset[count - 1] + imageList[count - 1]->width, imageList[0]->height), 
+		imageList[0]->depth, imageList[0]->nChannels);
+
+	double* weights = GetOverlapWeights(size, para);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int i = 0; i < count; i++)
+	{
+		IplImage* image = imageList[i];
+		int begin = i > 0 ? size : 0;
+		int end = i < count - 1 ? image->width - size : image->width;
+		CopyColumns(result, offset[i] + begin, image, begin, end - begin);
+
+		// the overlap with the next image
+		if(i == count - 1)
+			continue;
+		if(blendType == BLEND_MULTIBAND)
+			MultiBandColumns(result, offset[i + 1], image, image->width - size, imageList[i + 1], 0, size, para);
+		else
+			BlendColumns(result, offset[i + 1], image, image->width - size, imageList[i + 1], 0, 1, weights, size);
+	}
+
+	delete[] weights;
+	delete[] offset;
 	return result;
 }
 
@@ -370,30 +501,36 @@ void ROIBlend::TestBlendMultiple(char **fileList, int count, int para1, int para
 		}		
 		
 		// ********resize then blend
-		// first image
-		double ratio = (double)minHeight/ (double)imageList[0]->height;
-		result = cvCreateImage(cvSize(imageList[0]->width * ratio, minHeight), 
-			imageList[0]->depth, imageList[0]->nChannels);
-		cvResize(imageList[0], result);
-		// from second image
-		for(int i = 1; i < count; i++)
+		for(int i = 0; i < count; i++)
 		{
+			double ratio = (double)minHeight/ (double)imageList[i]->height;
 			IplImage* temp = cvCreateImage(cvSize(imageList[i]->width * ratio, minHeight), 
 			imageList[i]->depth, imageList[i]->nChannels);
 			cvResize(imageList[i], temp);
+			cvReleaseImage(&imageList[i]);
+			imageList[i] = temp;
+		}
 
-			switch(blendType)
+		if(blendType == 1 || blendType == 2)
+		{
+			// pairwise, each blend depends on the result so far
+			result = cvCloneImage(imageList[0]);
+			for(int i = 1; i < count; i++)
 			{
-			case 1: result = BlendImages1(result, temp, para1, para2);
-				break;
-			case 2: result = BlendImages2(result, temp, para1, para2);
-				break;
-			case 3: result = BlendImages3(result, temp, para1, para2);
-				break;
-			default:
-				result = BlendImages3(result, temp, para1, para2);
+				IplImage* blended;
+				if(blendType == 1)
+					blended = BlendImages1(result, imageList[i], para1, para2);
+				else
+					blended = BlendImages2(result, imageList[i], para1, para2);
+				cvReleaseImage(&result);
+				result = blended;
 			}
 		}
+		else
+		{
+			// all overlaps at once
+			result = BlendMultiple(imageList, count, para1, para2, blendType);
+		}
 
 		cvSaveImage("blend.jpg", result);
 		cvNamedWindow("Blended");
@@ -5,8 +5,13 @@
 #include "cv.h"
 #include "highgui.h"
 #include <math.h>
+#include <string.h>
 #include "CommonMath.h"
  
+// blend types of TestBlendMultiple
+// 1, 2, 3: BlendImages1, BlendImages2, BlendImages3
+#define BLEND_MULTIBAND 4
+
 /*
 Usage: 
 1) Load n images of type IplImage (n<=12)
@@ -71,11 +76,22 @@ public:
 	// put std < size allow smoother transition
 	// mean of Gaussian is always in the middle of the overlap area
 	IplImage* BlendImages3(IplImage* image1, IplImage* image2, int size, int std);
+	// blend 2 images - assumed to be of the SAME HEIGHT and SAME TYPE
+	// overlap as BlendImages3, blended band by band with a Laplacian pyramid of
+	// levels levels. Low frequencies mix over the whole overlap, details only 
+	// near the middle, which suits wide overlaps
+	IplImage* BlendImagesMultiBand(IplImage* image1, IplImage* image2, int size, int levels);
+
+	// blend count images of the SAME HEIGHT side by side in one pass, each 
+	// overlapping the next by size columns. para is the deviation of the 
+	// Gaussian (BlendImages3) or the number of levels for BLEND_MULTIBAND.
+	// Overlaps are blended in parallel
+	IplImage* BlendMultiple(IplImage** imageList, int count, int size, int para, int blendType);
 	
 	// first resize all images to same height
 	// blend multiple images using filenames
 	// then show the result
-	// blendType can be 1 or 2 or 3
+	// blendType can be 1 or 2 or 3 or BLEND_MULTIBAND
 	void TestBlendMultiple(char** fileList, int count, int para1, int para2, int blendType);
 	
 	// combine to image with same height side by side
@@ -16,7 +16,7 @@ public:
 	// saliency on image or other data type can be added here
 	// default implementation should provided so that child 
 	// does not have to implement anything
-	virtual void CalculateSaliencyMap(Matrix3D* matrix, Matrix3D* output){}
+	virtual void CalculateSaliencyMap(Matrix3D8UC3* matrix, Matrix3D32FC1* output){}
 #pragma endregion
 
 };
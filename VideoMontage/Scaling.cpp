@@ -9,7 +9,7 @@ Scaling::~Scaling(void)
 {
 }
 
-void Scaling::PyrDownZ(Matrix3D *input, Matrix3D *output)
+void Scaling::PyrDownZ(Matrix3D8UC3 *input, Matrix3D8UC3 *output)
 {
 	int width = input->_width;
 	int height = input->_height;
@@ -17,20 +17,22 @@ void Scaling::PyrDownZ(Matrix3D *input, Matrix3D *output)
 	
 	IplImage* image = cvCreateImage(cvSize(width, height), input->_type, 3);
 	IplImage* dst = cvCreateImage(cvSize(width/2, height/2), input->_type, 3);
-	
+	IplImage imageHeader;
+	IplImage dstHeader;
 	 
 	for(int z = 0; z < length; z++)
 	{
-		// fill image with a slice in 3D matrix
-		input->GetIplImageZ(z, image);
-		cvPyrDown(image, dst);
-		output->SetIplImageZ(z, dst);		
+		// work on the slices in place when the layout allows it
+		Matrix3DSlice<unsigned char, 3> outputSlice = output->SliceZ(z);
+		IplImage* outputImage = outputSlice.GetImage(&dstHeader, dst, false);
+		cvPyrDown(input->SliceZ(z).GetImage(&imageHeader, image), outputImage);
+		outputSlice.StoreImage(outputImage);
 	}
 	cvReleaseImage(&image);
 	cvReleaseImage(&dst);
 }
 
-void Scaling::PyrDownX(Matrix3D *input, Matrix3D *output)
+void Scaling::PyrDownX(Matrix3D8UC3 *input, Matrix3D8UC3 *output)
 {
 	int width = input->_width;
 	int height = input->_height;
@@ -38,15 +40,17 @@ void Scaling::PyrDownX(Matrix3D *input, Matrix3D *output)
 	
 	IplImage* image = cvCreateImage(cvSize(height, length), input->_type, 3);
 	IplImage* dst = cvCreateImage(cvSize(height/2, length/2), input->_type, 3);
-	
+	IplImage imageHeader;
+	IplImage dstHeader;
 	 
 	for(int x = 0; x < width; x++)
 	{
-		// fill image with a slice in 3D matrix
-		input->GetIplImageX(x, image);
-		cvPyrDown(image, dst);
-		output->SetIplImageX(x, dst);		
+		// work on the slices in place when the layout allows it
+		Matrix3DSlice<unsigned char, 3> outputSlice = output->SliceX(x);
+		IplImage* outputImage = outputSlice.GetImage(&dstHeader, dst, false);
+		cvPyrDown(input->SliceX(x).GetImage(&imageHeader, image), outputImage);
+		outputSlice.StoreImage(outputImage);
 	}
 	cvReleaseImage(&image);
 	cvReleaseImage(&dst);
-}
+}
\ No newline at end of file
@@ -12,9 +12,8 @@ public:
 	// scale down with same number of frames
 	// output should be 2 times smaller than input
 	// Z-dimension is reserved
-	virtual void PyrDownZ(Matrix3D* input, Matrix3D* output);
+	virtual void PyrDownZ(Matrix3D8UC3* input, Matrix3D8UC3* output);
 
 	// X-dimension is reserved
-	virtual void PyrDownX(Matrix3D* input, Matrix3D* output);
-
+	virtual void PyrDownX(Matrix3D8UC3* input, Matrix3D8UC3* output);
 };
@@ -6,15 +6,46 @@ TangVideoCollage::TangVideoCollage(ImageQuality* imageQuality, ImageImportance*
 	_imageQuality = imageQuality;
 	_imageImportance = imageImportance;
 	_shotInfo = shotInfo;
+	_scorer = new FrameScorer(imageQuality, imageImportance);
+	_scoreFile = NULL;
+}
+
+TangVideoCollage::~TangVideoCollage(void)
+{
+	delete _scorer;
+}
+
+void TangVideoCollage::SetScoreFile(char* fileName)
+{
+	_scoreFile = fileName;
+}
+
+void TangVideoCollage::ScoreFrames()
+{
+	int count = _sequence->frameList->size();
+	if(_scorer->GetFrameCount() == count)
+		return;
+	if(_scoreFile != NULL && _scorer->LoadScores(_scoreFile, _sequence))
+		return;
+
+	printf("\nScoring %i frames ...", count);
+	_scorer->ScoreSequence(_sequence);
+	if(_scoreFile != NULL)
+		_scorer->SaveScores(_scoreFile, _sequence);
 }
 
 IplImage* TangVideoCollage::GetCollage(void)
 {
 	IplImage* result;
 	VCSolution* solution = GetSolution(_shotInfo);
+	if(solution->length == 0)
+		return NULL;
 	
-	Collage* collage = new Collage();
-	result = collage->CreateCollage(solution->frameList, solution->length);
+	// key frames of one sequence have the same height, join them along seams
+	ImageMergeCarving* carving = new ImageMergeCarving();
+	int overlap = (int)(solution->frameList[0]->width * VC_MERGE_OVERLAP_RATIO);
+	result = carving->GetMergedImage(solution->frameList, solution->length, overlap);
+	delete carving;
 	cvSaveImage("blend.jpg", result);
 		printf("\n Image Saved");
 	return result;
@@ -22,23 +53,17 @@ IplImage* TangVideoCollage::GetCollage(void)
 
 int TangVideoCollage::GetMostRelevanceFrame(int start, int end)
 {
-	double max_assessment;
+	double max_assessment = 0;
 	int key = start;
 	for(int i = start; i <= end; i++)
 	{
-		char* filename = (*_sequence->frameList)[i];
-		IplImage* frame = cvLoadImage(filename);
-		
-		double quality = _imageQuality->GetImageQuality(frame);
-		double importance = _imageImportance->GetImageImportance(frame);
-		double assessment = quality + importance;
-		if(assessment > max_assessment)
+		FrameScore score = _scorer->GetScore(i);
+		double assessment = score.quality + score.importance;
+		if(i == start || assessment > max_assessment)
 		{
 			max_assessment = assessment;
 			key = i;
 		}
-
-		cvReleaseImage(&frame);
 	}
 	return key;
 }
@@ -107,6 +132,7 @@ int TangVideoCollage::GetSolutionFrameCount(ShotInfo* shotInfo)
 VCSolution* TangVideoCollage::GetSolution(ShotInfo* shotInfo)
 {
 	VCSolution* solution = new VCSolution();	
+	ScoreFrames();
 	int count = GetSolutionFrameCount(shotInfo);
 	solution->frameList = (IplImage**) malloc(count * sizeof(long));	
 	int index = 0;
@@ -150,7 +176,6 @@ VCSolution* TangVideoCollage::GetSolution(ShotInfo* shotInfo)
 	solution->length = index;
  	return solution;
 }
-<<<<<<< .mine
 void TestTangVideoCollage(char* sequencename, char* shotname)
 {
 	VideoSequence* sequence = LoadSequenceFromFile(sequencename);
@@ -158,18 +183,11 @@ void TestTangVideoCollage(char* sequencename, char* shotname)
 	ImageImportance* imageImportance = new SobelImageImportance();
 	ImageQuality* imageQuality = new SobelImageQuality();
 
-	VideoCollage* collage = new TangVideoCollage(imageQuality, imageImportance, sequence, shotInfo);
-	collage->GetCollage();	
-}=======
-
-
-void TestTangVideoCollage(char* sequencename, char* shotname)
-{
-	VideoSequence* sequence = LoadSequenceFromFile(sequencename);
-	ShotInfo* shotInfo = LoadShotFromFile(shotname);
-	ImageImportance* imageImportance = new SobelImageImportance();
-	ImageQuality* imageQuality = new SobelImageQuality();
+	// scores are kept next to the sequence file
+	char* scorename = (char*)malloc(strlen(sequencename) + 7);
+	sprintf(scorename, "%s.score", sequencename);
 
-	VideoCollage* collage = new TangVideoCollage(imageQuality, imageImportance, sequence, shotInfo);
+	TangVideoCollage* collage = new TangVideoCollage(imageQuality, imageImportance, sequence, shotInfo);
+	collage->SetScoreFile(scorename);
 	collage->GetCollage();	
-}>>>>>>> .r136
+}
\ No newline at end of file
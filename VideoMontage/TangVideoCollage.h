@@ -3,16 +3,15 @@
 #include "VideoCollage.h"
 #include "ImageImportance.h"
 #include "ImageQuality.h"
-<<<<<<< .mine
-#include "SobelImageImportance.h"
-#include "SobelImageQuality.h"
-=======
 #include "SobelImageQuality.h"
 #include "SobelImageImportance.h"
-#include "Collage.h"
->>>>>>> .r136
+#include "ImageMergeCarving.h"
+#include "FrameScorer.h"
 /************************ Tang Wang Video Collage Paper ***************************/
 
+// part of a key frame covered by the next one in the collage
+#define VC_MERGE_OVERLAP_RATIO 0.25
+
 /******************************** VCSolution **************************************/
 
 // video collage ROI
@@ -67,9 +66,20 @@ protected:
 	ImageQuality* _imageQuality;
 	ImageImportance* _imageImportance;
 	ShotInfo* _shotInfo;
+	// scores of every frame, computed once before the key frame selection
+	FrameScorer* _scorer;
+	// file keeping the scores between runs, NULL to always score the sequence
+	char* _scoreFile;
+
+public:
+	// keep the frame scores in a file, they are loaded from it when it 
+	// matches the sequence
+	void SetScoreFile(char* fileName);
 
-	
 protected:
+	// score all frames of the sequence in one pass, or load the scores
+	void ScoreFrames();
+
 	virtual VCSolution* GetSolution(ShotInfo* shotInfo);
 	// couting the number of frame in solution 
 	// by counting subshot, some subshot may return 2 frames
@@ -83,16 +93,9 @@ protected:
 
 	// select the keyframe of the pan / tilt SubShot
 	virtual void KeyFrameSelection2(SubShot* subShot, int* key);
-<<<<<<< .mine
-};
-
-// test tang video collage
-// @param: filename of shotinfo & filename of sequence
-void TestTangVideoCollage(char* sequencename, char* shotname);=======
 };
 
 
 // test tang video collage
 // @param: filename of shotinfo & filename of sequence
 void TestTangVideoCollage(char* sequencename, char* shotname);
->>>>>>> .r136
@@ -30,6 +30,10 @@ public:
 	VideoCollage()
 	{		
 	}
+	VideoCollage(VideoSequence* sequence)
+	{
+		_sequence = sequence;
+	}
 	~VideoCollage(void){}
 protected:
 	VideoSequence* _sequence;
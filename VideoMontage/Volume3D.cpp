@@ -19,6 +19,7 @@ IplImage* Volume3D::GetFrame(int time)
 	}	
 	
 	IplImage* frame = (IplImage*)*(_firstFrame + time);
+	return frame;
 }
 
  
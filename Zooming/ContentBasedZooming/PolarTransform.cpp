@@ -6,6 +6,38 @@ Zooming::PolarTransform::PolarTransform(double unitAngle, int resolution)
 	 width = resolution;
 	 height = 360 / unitAngle;
 	 this->unitAngle = unitAngle;
+	 offsetX = new float[width * height];
+	 offsetY = new float[width * height];
+	 tableOuterRadius = -1;
+	 tableInnerRadius = -1;
+}
+
+Zooming::PolarTransform::~PolarTransform()
+{
+	delete[] offsetX;
+	delete[] offsetY;
+}
+
+void Zooming::PolarTransform::UpdateTable(int outerRadius, int innerRadius)
+{
+	if(outerRadius == tableOuterRadius && innerRadius == tableInnerRadius)
+		return;
+
+	double increment = (double)(outerRadius - innerRadius) / (width - 1);
+	for(int y = 0; y < height; y++)
+	{
+		double angle = y * unitAngle * PI / 180;
+		double sinAngle = sin(angle);
+		double cosAngle = cos(angle);
+		for(int x = 0; x < width; x++)
+		{
+			double radius = innerRadius + x * increment;
+			offsetX[y * width + x] = radius * sinAngle;
+			offsetY[y * width + x] = radius * cosAngle;
+		}
+	}
+	tableOuterRadius = outerRadius;
+	tableInnerRadius = innerRadius;
 }
 
 IplImage* Zooming::PolarTransform::CreatePolarImage(
@@ -16,36 +48,57 @@ IplImage* Zooming::PolarTransform::CreatePolarImage(
 {
 	int inputWidth = image->width;
 	int inputHeight = image->height;
+	int channels = image->nChannels;
 
 	IplImage* result = cvCreateImage(cvSize(width, height), image->depth, image->nChannels);
+	UpdateTable(outerRadius, innerRadius);
 
-	double increment = (outerRadius - innerRadius) / (width - 1);
-
-	for(int x = 0; x < width; x++)
+	if(image->depth != IPL_DEPTH_8U)
+	{
+		// other depths: nearest pixel through the generic accessors
 		for(int y = 0; y < height; y++)
-		{
-			double angle = y * unitAngle;
-			double radius = innerRadius + x * increment;
+			for(int x = 0; x < width; x++)
+			{
+				// get target pixel, shifted by the center
+				// get the border pixel if the region is out of image
+				int targetX = MIN(MAX((int)offsetX[y * width + x] + center.x, 0), inputWidth - 1);
+				int targetY = MIN(MAX((int)offsetY[y * width + x] + center.y, 0), inputHeight - 1);
+
+				CvScalar value = cvGet2D(image, targetY, targetX);
+				cvSet2D(result, y, x, value);
+			}
+		return result;
+	}
 
-			// get target pixel
-			Point2D target = GetCartersianCoordination(angle, radius);
-			// shift
-			target.x += center.x;
-			target.y += center.y;		
-			
+	for(int y = 0; y < height; y++)
+	{
+		unsigned char* resultRow = (unsigned char*)(result->imageData + y * result->widthStep);
+		float* rowX = offsetX + y * width;
+		float* rowY = offsetY + y * width;
+		for(int x = 0; x < width; x++)
+		{
+			// get target pixel, shifted by the center
 			// get the border pixel if the region is out of image
-			if(target.x < 0)
-				target.x = 0;
-			if(target.x > inputWidth - 1)
-				target.x = inputWidth - 1;
-			if(target.y < 0)
-				target.y = 0;
-			if(target.y > inputHeight - 1)
-				target.y = inputHeight - 1;
-
-			CvScalar value = cvGet2D(image, target.y, target.x);
-			cvSet2D(result, y, x, value);
+			float targetX = MIN(MAX(center.x + rowX[x], 0.0f), (float)(inputWidth - 1));
+			float targetY = MIN(MAX(center.y + rowY[x], 0.0f), (float)(inputHeight - 1));
+
+			int x0 = (int)targetX;
+			int y0 = (int)targetY;
+			int x1 = MIN(x0 + 1, inputWidth - 1);
+			int y1 = MIN(y0 + 1, inputHeight - 1);
+			float weightX = targetX - x0;
+			float weightY = targetY - y0;
+
+			unsigned char* top = (unsigned char*)(image->imageData + y0 * image->widthStep);
+			unsigned char* bottom = (unsigned char*)(image->imageData + y1 * image->widthStep);
+			for(int c = 0; c < channels; c++)
+			{
+				float valueTop = top[x0 * channels + c] * (1 - weightX) + top[x1 * channels + c] * weightX;
+				float valueBottom = bottom[x0 * channels + c] * (1 - weightX) + bottom[x1 * channels + c] * weightX;
+				resultRow[x * channels + c] = (unsigned char)(valueTop * (1 - weightY) + valueBottom * weightY + 0.5f);
+			}
 		}
+	}
 	return result;
 }
 
@@ -59,24 +112,15 @@ Zooming::Path* Zooming::PolarTransform::GetOriginalPath(Point2D center, int oute
 	result->size = path->size;
 
 	Pixel* pixelList = path->pixelList;
-	double increment = (outerRadius - innerRadius) / (width - 1);
+	UpdateTable(outerRadius, innerRadius);
 
 	for(int i = 0; i < path->size; i++)
 	{
-		int x = pixelList[i].x;
-		int y = pixelList[i].y;
-
-		double angle = y * unitAngle;
-		double radius = innerRadius + x * increment;
-
-		// get target pixel
-		Point2D target = GetCartersianCoordination(angle, radius);
-		// shift
-		target.x += center.x;
-		target.y += center.y;
-		
-		result->pixelList[i].x = target.x;
-		result->pixelList[i].y = target.y;
+		int index = pixelList[i].y * width + pixelList[i].x;
+
+		// get target pixel, shifted by the center
+		result->pixelList[i].x = cvRound(offsetX[index]) + center.x;
+		result->pixelList[i].y = cvRound(offsetY[index]) + center.y;
 	}
 	return result;
 }
@@ -29,19 +29,36 @@ namespace Zooming
 		int width;
 		int height;
 		double unitAngle;		
+
+		// position of every polar pixel relative to the center, width x height.
+		// Only depends on the angle step, resolution and radii, so it is built 
+		// once for the radii last used and moving the center is an offset
+		float* offsetX;
+		float* offsetY;
+		int tableOuterRadius;
+		int tableInnerRadius;
 	public:
 		// unitAngle in degree
 		// resolution: number of pixel taken in 1 radius
 		PolarTransform(double unitAngle, int resolution);
+		~PolarTransform();
 
 	public:
 		// create a polar transformation 
 		// the folding with start from the right hand size, then anti-clockwise
+		// 8 bit images are sampled bilinearly, other depths take the nearest pixel
 		IplImage* CreatePolarImage(IplImage* image, Point2D center, int  outerRadius, int innerRadius);
 
 		// transform a list of point back to the image
 		Path* GetOriginalPath(Point2D center, int outerRadius, int innerRadius, Path* path);
+	protected:
+		// build the offset table if the radii differ from the ones it was built for
+		void UpdateTable(int outerRadius, int innerRadius);
 	private:
+		// owns the offset table, not copyable
+		PolarTransform(const PolarTransform&);
+		PolarTransform& operator=(const PolarTransform&);
+
 		// angle is in degree
 		Point2D GetCartersianCoordination(double angle, double radius)
 		{
@@ -1,109 +1,216 @@
 #include "StdAfx.h"
 #include "EnergyPath.h"
  
+// first channel of every pixel of a row, as cvGet2D(...).val[0]
+template <class T>
+static void ReadEnergyRows(IplImage* image, float* energy)
+{
+	int channels = image->nChannels;
+	for(int y = 0; y < image->height; y++)
+	{
+		T* row = (T*)(image->imageData + y * image->widthStep);
+		float* energyRow = energy + y * image->width;
+		for(int x = 0; x < image->width; x++)
+			energyRow[x] = (float)row[x * channels];
+	}
+}
 
 Zooming::SeamCarving::~SeamCarving()
 {
+	ReleaseMaps();
+}
+
+void Zooming::SeamCarving::ReleaseMaps()
+{
+	delete[] _energy;
+	delete[] _energyMap;
+	delete[] _pathInfo;
+	delete[] _column;
+	_energy = NULL;
+	_energyMap = NULL;
+	_pathInfo = NULL;
+	_column = NULL;
 }
 
 Zooming::Path* Zooming::SeamCarving::GetEnergyPath()
 {		
-	int width = energy->width;
-	int height = energy->height;
-
-	IplImage* energyMap = cvCloneImage(energy);
-	IplImage* pathInfo = cvCreateImage(cvSize(width, height), IPL_DEPTH_8S, 1);
-	
-	PreprocessEnergyMap(energy, energyMap, pathInfo);
-	
-	int minPosition = GetMinPosition(energyMap);
-
-	Path* path = GeneratePath(minPosition, pathInfo);
-	
-	cvReleaseImage(&energyMap);
-	cvReleaseImage(&pathInfo);
-
-	return path;
+	Initialize();
+
+	int* path = new int[_height];
+	GetMinPath(path);
+	Path* result = GeneratePath(path);
+	delete[] path;
+	return result;
 }
 
-void Zooming::SeamCarving::PreprocessEnergyMap(IplImage *energy, IplImage *energyMap, IplImage *pathInfo)
+Zooming::Path** Zooming::SeamCarving::GetEnergyPaths(int count)
 {
-	int width = energy->width;
-	int height = energy->height;
-
-	//energyMap = cvCreateImage(cvSize(width, height), inputEnergy->depth, inputEnergy->nChannels);
-	//energyMap = cvCloneImage(inputEnergy);
+	Initialize();
 
-	//if(pathInfo != 0) cvReleaseImage(&pathInfo);
-	//cvReleaseImage(&pathInfo);
-	//pathInfo = cvCreateImage(cvSize(width, height), IPL_DEPTH_8S, 1);
-
-	for(int y = 1; y < height; y++)
+	Path** result = new Path*[count];
+	int* path = new int[_height];
+	for(int i = 0; i < count; i++)
 	{
-		for(int x = 0; x < width; x++)
+		if(_width <= 1)
 		{
-			int position;
-			// favor the directly above pixel
-			double min = GetMinOfThree<double>(
-				GetValue(energyMap, x - 1, y - 1), 						
-				GetValue(energyMap, x, y - 1),
-				GetValue(energyMap, x + 1, y - 1), 						
-				&position);
-
-			double energyValue = min + GetValue(energy, x, y);
-			SetValue(energyMap, x, y, energyValue);
-
-			//position = position * 40;
-			position = position - 2; // make it to the range -1 0 1	 
-			SetValue(pathInfo, x, y, position);
+			result[i] = NULL;
+			continue;
 		}
+		GetMinPath(path);
+		result[i] = GeneratePath(path);
+		if(i < count - 1)
+			RemovePath(path);
 	}
+	delete[] path;
+	return result;
 }
-Zooming::Path* Zooming::SeamCarving::GeneratePath(int position, IplImage *pathInfo)
+
+void Zooming::SeamCarving::Initialize()
 {
-	// from bottom up
-	Path* path = new Path();
-	path->size = pathInfo->height;
-	Pixel* pixelList = new Pixel[path->size];
+	ReleaseMaps();
+	_width = energy->width;
+	_height = energy->height;
+
+	int size = _width * _height;
+	_energy = new float[size];
+	_energyMap = new float[size];
+	_pathInfo = new signed char[size];
+	_column = new int[size];
+
+	// read the rows directly, the depth is switched on once
+	switch(energy->depth)
+	{
+	case IPL_DEPTH_8U: ReadEnergyRows<unsigned char>(energy, _energy); break;
+	case IPL_DEPTH_8S: ReadEnergyRows<signed char>(energy, _energy); break;
+	case IPL_DEPTH_16U: ReadEnergyRows<unsigned short>(energy, _energy); break;
+	case IPL_DEPTH_16S: ReadEnergyRows<short>(energy, _energy); break;
+	case IPL_DEPTH_32S: ReadEnergyRows<int>(energy, _energy); break;
+	case IPL_DEPTH_32F: ReadEnergyRows<float>(energy, _energy); break;
+	case IPL_DEPTH_64F: ReadEnergyRows<double>(energy, _energy); break;
+	}
+	for(int y = 0; y < _height; y++)
+		for(int x = 0; x < _width; x++)
+			_column[y * energy->width + x] = x;
 
-	pixelList[0].y = path->size - 1;
-	pixelList[0].x = position;
+	for(int x = 0; x < _width; x++)
+	{
+		_energyMap[x] = _energy[x];
+		_pathInfo[x] = 0;
+	}
+	int changedStart;
+	int changedEnd;
+	for(int y = 1; y < _height; y++)
+		ProcessRow(y, 0, _width - 1, &changedStart, &changedEnd);
+}
 
-	for(int i = 1; i < path->size; i++)
+void Zooming::SeamCarving::ProcessRow(int y, int start, int end, int* changedStart, int* changedEnd)
+{
+	int stride = energy->width;
+	float* above = _energyMap + (y - 1) * stride;
+	float* row = _energyMap + y * stride;
+	float* energyRow = _energy + y * stride;
+	signed char* info = _pathInfo + y * stride;
+
+	*changedStart = end + 1;
+	*changedEnd = start - 1;
+	for(int x = start; x <= end; x++)
 	{
-		int currentY = path->size - i;
-		pixelList[i].y = currentY;				
-
-		int increment = (int) GetValue(pathInfo, position, currentY);
-		//printf("position: %i Y: %i", position, currentY);
-		//printf("Incre: %i \n" , increment);
-		//if(i == path->size - 1)
-		//	printf("end \n");
-		
-		double value = GetValue(pathInfo, position, currentY);		
-		position += value;
-		pixelList[i].x = position;
+		// favor the directly above pixel, then the left one, as GetMinOfThree
+		float min = above[x];
+		signed char position = 0;
+		if(x < _width - 1 && above[x + 1] < min)
+		{
+			min = above[x + 1];
+			position = 1;
+		}
+		if(x > 0 && above[x - 1] <= min && (position != 0 || above[x - 1] < min))
+		{
+			min = above[x - 1];
+			position = -1;
+		}
+
+		float value = min + energyRow[x];
+		if(value != row[x])
+		{
+			if(*changedStart > x)
+				*changedStart = x;
+			*changedEnd = x;
+		}
+		row[x] = value;
+		info[x] = position;
 	}
+}
 
-	path->pixelList = pixelList;
-	return path;
+void Zooming::SeamCarving::GetMinPath(int* path)
+{
+	int stride = energy->width;
+	float* last = _energyMap + (_height - 1) * stride;
+	int position = 0;
+	for(int x = 1; x < _width; x++)
+		if(last[x] < last[position])
+			position = x;
+
+	for(int y = _height - 1; y >= 0; y--)
+	{
+		path[y] = position;
+		position += _pathInfo[y * stride + position];
+	}
 }
 
-int Zooming::SeamCarving::GetMinPosition(IplImage* energyMap)
+void Zooming::SeamCarving::RemovePath(int* path)
 {
-	int width = energyMap->width;			
-	int height = energyMap->height;
+	int stride = energy->width;
+	_width--;
 
-	double min = double::MaxValue;
-	int position;
-	for(int i = 0; i < width; i++)
+	// columns whose energy map changed in the row above
+	int changedStart = _width;
+	int changedEnd = -1;
+	for(int y = 0; y < _height; y++)
 	{
-		double value = GetValue(energyMap, i, height - 1);
-		if(value < min) 
+		int x = path[y];
+		int offset = y * stride;
+		int count = _width - x;
+		memmove(_energy + offset + x, _energy + offset + x + 1, count * sizeof(float));
+		memmove(_energyMap + offset + x, _energyMap + offset + x + 1, count * sizeof(float));
+		memmove(_pathInfo + offset + x, _pathInfo + offset + x + 1, count * sizeof(signed char));
+		memmove(_column + offset + x, _column + offset + x + 1, count * sizeof(int));
+
+		if(y == 0)
+		{
+			changedStart = _width;
+			changedEnd = -1;
+			continue;
+		}
+
+		// pixels next to the removed one have new neighbors above, 
+		// pixels below a change may change too
+		int start = x - 2;
+		int end = x + 1;
+		if(changedStart <= changedEnd)
 		{
-			min = value;
-			position = i;
+			start = MIN(start, changedStart - 1);
+			end = MAX(end, changedEnd + 1);
 		}
+		start = MAX(start, 0);
+		end = MIN(end, _width - 1);
+		ProcessRow(y, start, end, &changedStart, &changedEnd);
+	}
+}
+
+Zooming::Path* Zooming::SeamCarving::GeneratePath(int* path)
+{
+	// from bottom up
+	Path* result = new Path();
+	result->size = _height;
+	Pixel* pixelList = new Pixel[_height];
+
+	for(int i = 0; i < _height; i++)
+	{
+		int y = _height - 1 - i;
+		pixelList[i].y = y;
+		pixelList[i].x = _column[y * energy->width + path[y]];
 	}
-	return position;
-}
\ No newline at end of file
+
+	result->pixelList = pixelList;
+	return result;
+}
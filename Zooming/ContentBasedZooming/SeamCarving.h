@@ -1,4 +1,5 @@
 #pragma once
+#include <string.h>
 #include "MinEnergyPath.h"
 #include "MinMax.h"
 #include "OpenCVEx.h"
@@ -14,25 +15,56 @@ namespace Zooming
 		SeamCarving(IplImage* energy)
 		{
 			this->energy = energy;
+			_width = 0;
+			_height = 0;
+			_energy = NULL;
+			_energyMap = NULL;
+			_pathInfo = NULL;
+			_column = NULL;
 		}
 		~SeamCarving();
 	public:
 		virtual Path* GetEnergyPath();
+
+		// count min paths, each one found with the paths before it removed.
+		// The energy map and path info are kept between paths, only the part
+		// the last removed path can change is computed again.
+		// Pixels are given in the coordinates of the energy image
+		Path** GetEnergyPaths(int count);
 	private:
 		// this is the input to the algorithm
 		// the energy of any image can be passed so the energy calculation can be de-coupled
 		IplImage* energy;
 
-		// create a energy map whether energy of each pixel denotes the min energy to reach to that pixel
-		// at the same time create a path info in order to retrieve the min path, instead of checking min pixel bottom up
-		// path info image only contains -1 0 1 denotes the path should go left, up or right
-		void PreprocessEnergyMap(IplImage* energy, IplImage* energyMap, IplImage* pathInfo);
+		// current width, paths removed so far make it smaller
+		int _width;
+		int _height;
+		// rows of energy->width values each, the first _width of a row in use
+		float* _energy;
+		// min energy to reach each pixel from the top row
+		float* _energyMap;
+		// -1 0 1: the path to the pixel comes from the left, directly above or the right
+		signed char* _pathInfo;
+		// x in the energy image of each pixel
+		int* _column;
+
+		// read the energy and create the energy map and path info
+		void Initialize();
+		void ReleaseMaps();
+
+		// energy map and path info of row y from column start to end (inclusive)
+		// return the first and last column where the energy map changed, 
+		// start > end when none did
+		void ProcessRow(int y, int start, int end, int* changedStart, int* changedEnd);
 		
-		// Generate path given a position to start following the path
-		Path* GeneratePath(int position, IplImage* pathInfo);
+		// follow the path info up from the min of the last row
+		void GetMinPath(int* path);
+
+		// take the path out of every row and update the energy map below it
+		void RemovePath(int* path);
 
-		// Get the min position of the energy path by searching the last row
-		int GetMinPosition(IplImage* energyMap);
+		// path in the coordinates of the energy image, from bottom up
+		Path* GeneratePath(int* path);
 	};
 
 }
@@ -0,0 +1,330 @@
+#include "PatchMatch.h"
+#include <vector>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+using namespace std;
+
+// xorshift, seeded per band and iteration so the random search does not
+// depend on which thread runs a band
+static unsigned int NextRandom(unsigned int& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static unsigned int BandSeed(unsigned int seed, int iteration, int band)
+{
+	unsigned int state = seed ^ (iteration * 0x9e3779b9u) ^ (band * 0x85ebca6bu);
+	return state == 0 ? 1 : state;
+}
+
+static int RandomIn(unsigned int& state, int low, int high)
+{
+	return low + NextRandom(state) % (high - low + 1);
+}
+
+PatchMatch::PatchMatch(int patchX, int patchY, int patchT)
+{
+	_patchX = patchX;
+	_patchY = patchY;
+	_patchT = patchT;
+	_iterations = 5;
+	_threads = 0;
+	_seed = 5489;
+}
+
+void PatchMatch::SetIterations(int iterations)
+{
+	_iterations = iterations;
+}
+
+void PatchMatch::SetThreads(int threads)
+{
+	_threads = threads;
+}
+
+void PatchMatch::SetSeed(unsigned int seed)
+{
+	_seed = seed;
+}
+
+void PatchMatch::GetGrid(const PatchVolume& volume, int grid[3])
+{
+	grid[0] = volume.sizeX - _patchX + 1;
+	grid[1] = volume.sizeY - _patchY + 1;
+	grid[2] = volume.sizeT - _patchT + 1;
+}
+
+float PatchMatch::Distance(const PatchVolume& source, int sourceOffset, const PatchVolume& target, int targetOffset, float cutoff)
+{
+	int sourcePlane = source.sizeX * source.sizeY * source.sizeT;
+	int targetPlane = target.sizeX * target.sizeY * target.sizeT;
+	int sourceFrame = source.sizeX * source.sizeY;
+	int targetFrame = target.sizeX * target.sizeY;
+
+	// runs along x are contiguous, check the cutoff after each of them
+	float sum = 0;
+	for(int t = 0; t < _patchT; t++)
+		for(int y = 0; y < _patchY; y++)
+		{
+			const float* sourceRun = source.data + sourceOffset + t * sourceFrame + y * source.sizeX;
+			const float* targetRun = target.data + targetOffset + t * targetFrame + y * target.sizeX;
+			for(int c = 0; c < source.channels; c++)
+			{
+				const float* s = sourceRun + c * sourcePlane;
+				const float* d = targetRun + c * targetPlane;
+				float run = 0;
+				for(int x = 0; x < _patchX; x++)
+				{
+					float diff = s[x] - d[x];
+					run += diff * diff;
+				}
+				sum += run;
+			}
+			if(sum >= cutoff)
+				return sum;
+		}
+	return sum;
+}
+
+void PatchMatch::Match(const PatchVolume& source, const PatchVolume& target, const int* initial, int* match, float* distance)
+{
+	int sourceGrid[3];
+	int targetGrid[3];
+	GetGrid(source, sourceGrid);
+	GetGrid(target, targetGrid);
+	int sourceCount = sourceGrid[0] * sourceGrid[1] * sourceGrid[2];
+	int targetCount = targetGrid[0] * targetGrid[1] * targetGrid[2];
+	int lines = sourceGrid[1] * sourceGrid[2];
+	int threads = _threads;
+#ifdef _OPENMP
+	if(threads <= 0)
+		threads = omp_get_max_threads();
+#endif
+
+	vector<float> best(sourceCount);
+	vector<int> previous(sourceCount);
+
+	// the patch a source patch id matches starts at target pixel
+	// x + sizeX * (y + sizeY * t) of its target grid coordinates
+	#define PM_TARGET_OFFSET(x, y, t) ((x) + target.sizeX * ((y) + target.sizeY * (t)))
+
+	// initial guesses, random where there are none
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+	for(int line = 0; line < lines; line++)
+	{
+		unsigned int state = BandSeed(_seed, -1, line);
+		int y = line % sourceGrid[1];
+		int t = line / sourceGrid[1];
+		for(int x = 0; x < sourceGrid[0]; x++)
+		{
+			int id = line * sourceGrid[0] + x;
+			int guess = -1;
+			if(initial != NULL && initial[id] >= 0 && initial[id] < targetCount)
+				guess = initial[id];
+			else
+				guess = NextRandom(state) % targetCount;
+			match[id] = guess;
+
+			int mx = guess % targetGrid[0];
+			int my = (guess / targetGrid[0]) % targetGrid[1];
+			int mt = guess / (targetGrid[0] * targetGrid[1]);
+			best[id] = Distance(source, x + source.sizeX * (y + source.sizeY * t), target, PM_TARGET_OFFSET(mx, my, mt), 3.4e38f);
+		}
+	}
+
+	int bands = (lines + PM_BAND_LINES - 1) / PM_BAND_LINES + 1;
+	int maxRadius = targetGrid[0] > targetGrid[1] ? targetGrid[0] : targetGrid[1];
+	if(targetGrid[2] > maxRadius)
+		maxRadius = targetGrid[2];
+
+	for(int iteration = 0; iteration < _iterations; iteration++)
+	{
+		// even passes scan forward and take the match of the previous patch
+		// along each dimension, odd ones scan backward. Neighbours outside
+		// the band of a patch are read as they were before this pass, and
+		// bands shift by half a band every other pass so the matches travel
+		// across their borders
+		int direction = iteration % 2 == 0 ? 1 : -1;
+		int shift = (iteration / 2) % 2 == 0 ? 0 : PM_BAND_LINES / 2;
+		memcpy(&previous[0], match, sourceCount * sizeof(int));
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+		for(int band = 0; band < bands; band++)
+		{
+			unsigned int state = BandSeed(_seed, iteration, band);
+			int first = band * PM_BAND_LINES - shift;
+			int last = first + PM_BAND_LINES;
+			if(first < 0)
+				first = 0;
+			if(last > lines)
+				last = lines;
+
+			for(int i = 0; i < last - first; i++)
+			{
+				int line = direction > 0 ? first + i : last - 1 - i;
+				int y = line % sourceGrid[1];
+				int t = line / sourceGrid[1];
+				for(int j = 0; j < sourceGrid[0]; j++)
+				{
+					int x = direction > 0 ? j : sourceGrid[0] - 1 - j;
+					int id = line * sourceGrid[0] + x;
+					int sourceOffset = x + source.sizeX * (y + source.sizeY * t);
+					int current = match[id];
+					int mx = current % targetGrid[0];
+					int my = (current / targetGrid[0]) % targetGrid[1];
+					int mt = current / (targetGrid[0] * targetGrid[1]);
+
+					// propagation: the neighbour's match, shifted back by one
+					int neighbours[3];
+					int count = 0;
+					if(x - direction >= 0 && x - direction < sourceGrid[0])
+						neighbours[count++] = 0;
+					if(y - direction >= 0 && y - direction < sourceGrid[1])
+						neighbours[count++] = 1;
+					if(t - direction >= 0 && t - direction < sourceGrid[2])
+						neighbours[count++] = 2;
+					for(int k = 0; k < count; k++)
+					{
+						int neighbourLine = line;
+						int neighbourX = x;
+						if(neighbours[k] == 0)
+							neighbourX -= direction;
+						else if(neighbours[k] == 1)
+							neighbourLine -= direction;
+						else
+							neighbourLine -= direction * sourceGrid[1];
+						int neighbourId = neighbourLine * sourceGrid[0] + neighbourX;
+						int candidate = neighbourLine >= first && neighbourLine < last ? match[neighbourId] : previous[neighbourId];
+
+						int cx = candidate % targetGrid[0];
+						int cy = (candidate / targetGrid[0]) % targetGrid[1];
+						int ct = candidate / (targetGrid[0] * targetGrid[1]);
+						if(neighbours[k] == 0)
+							cx += direction;
+						else if(neighbours[k] == 1)
+							cy += direction;
+						else
+							ct += direction;
+						if(cx < 0 || cx >= targetGrid[0] || cy < 0 || cy >= targetGrid[1] || ct < 0 || ct >= targetGrid[2])
+							continue;
+
+						float d = Distance(source, sourceOffset, target, PM_TARGET_OFFSET(cx, cy, ct), best[id]);
+						if(d < best[id])
+						{
+							best[id] = d;
+							mx = cx;
+							my = cy;
+							mt = ct;
+						}
+					}
+
+					// random search around the best match, halving the window
+					for(int radius = maxRadius; radius >= 1; radius /= 2)
+					{
+						int cx = RandomIn(state, mx - radius > 0 ? mx - radius : 0, mx + radius < targetGrid[0] ? mx + radius : targetGrid[0] - 1);
+						int cy = RandomIn(state, my - radius > 0 ? my - radius : 0, my + radius < targetGrid[1] ? my + radius : targetGrid[1] - 1);
+						int ct = RandomIn(state, mt - radius > 0 ? mt - radius : 0, mt + radius < targetGrid[2] ? mt + radius : targetGrid[2] - 1);
+						float d = Distance(source, sourceOffset, target, PM_TARGET_OFFSET(cx, cy, ct), best[id]);
+						if(d < best[id])
+						{
+							best[id] = d;
+							mx = cx;
+							my = cy;
+							mt = ct;
+						}
+					}
+
+					match[id] = mx + targetGrid[0] * (my + targetGrid[1] * mt);
+				}
+			}
+		}
+	}
+	#undef PM_TARGET_OFFSET
+
+	if(distance != NULL)
+		memcpy(distance, &best[0], sourceCount * sizeof(float));
+}
+
+void PatchMatch::BidirectionalUpdate(const PatchVolume& source, const float* sourceWeights, const int* sourceMatch,
+									 const int* targetMatch, float completeWeight, float cohereWeight, PatchVolume& target)
+{
+	int sourceGrid[3];
+	int targetGrid[3];
+	GetGrid(source, sourceGrid);
+	GetGrid(target, targetGrid);
+	int sourceCount = sourceGrid[0] * sourceGrid[1] * sourceGrid[2];
+	int targetCount = targetGrid[0] * targetGrid[1] * targetGrid[2];
+	int sourcePlane = source.sizeX * source.sizeY * source.sizeT;
+	int targetPlane = target.sizeX * target.sizeY * target.sizeT;
+	int threads = _threads;
+#ifdef _OPENMP
+	if(threads <= 0)
+		threads = omp_get_max_threads();
+#endif
+
+	vector<float> weights(targetPlane);
+	float completeUnit = completeWeight / sourceCount;
+	float cohereUnit = cohereWeight / targetCount;
+
+	// one task per channel and one for the weights, each writes its own plane
+	// and adds the votes in the same order as the Matlab version
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+	for(int c = 0; c <= target.channels; c++)
+	{
+		bool weightPlane = c == target.channels;
+		float* plane = weightPlane ? &weights[0] : target.data + c * targetPlane;
+		const float* sourceData = source.data + (weightPlane ? 0 : c * sourcePlane);
+		memset(plane, 0, targetPlane * sizeof(float));
+
+		for(int pass = 0; pass < 2; pass++)
+		{
+			int count = pass == 0 ? sourceCount : targetCount;
+			for(int i = 0; i < count; i++)
+			{
+				// completeness: source patch i at its match, coherence: the match
+				// of target patch i at i
+				int sourceId = pass == 0 ? i : targetMatch[i];
+				int targetId = pass == 0 ? sourceMatch[i] : i;
+				float weight = (pass == 0 ? completeUnit : cohereUnit) * sourceWeights[sourceId];
+
+				int sx = sourceId % sourceGrid[0];
+				int sy = (sourceId / sourceGrid[0]) % sourceGrid[1];
+				int st = sourceId / (sourceGrid[0] * sourceGrid[1]);
+				int tx = targetId % targetGrid[0];
+				int ty = (targetId / targetGrid[0]) % targetGrid[1];
+				int tt = targetId / (targetGrid[0] * targetGrid[1]);
+
+				for(int t = 0; t < _patchT; t++)
+					for(int y = 0; y < _patchY; y++)
+					{
+						float* out = plane + tx + target.sizeX * (ty + y + target.sizeY * (tt + t));
+						if(weightPlane)
+						{
+							for(int x = 0; x < _patchX; x++)
+								out[x] += weight;
+						}
+						else
+						{
+							const float* in = sourceData + sx + source.sizeX * (sy + y + source.sizeY * (st + t));
+							for(int x = 0; x < _patchX; x++)
+								out[x] += weight * in[x];
+						}
+					}
+			}
+		}
+	}
+
+	// pixels no patch covers keep 0, as weight 0 is taken as 0.1
+#pragma omp parallel for num_threads(threads)
+	for(int i = 0; i < targetPlane; i++)
+	{
+		float weight = weights[i] == 0 ? 0.1f : weights[i];
+		for(int c = 0; c < target.channels; c++)
+			target.data[c * targetPlane + i] /= weight;
+	}
+}
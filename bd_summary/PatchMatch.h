@@ -0,0 +1,59 @@
+#pragma once
+
+// rows of the patch grid (lines along x) a thread scans at a time. The band
+// layout does not depend on the number of threads, so neither do the matches
+#define PM_BAND_LINES 16
+
+// an image or a spatio-temporal volume in Matlab layout: x (rows) fastest,
+// then y, then t, one plane per channel. Images have sizeT = 1
+struct PatchVolume
+{
+	float* data;
+	int sizeX;
+	int sizeY;
+	int sizeT;
+	int channels;
+};
+
+// randomized PatchMatch nearest neighbours between the patches of two volumes,
+// with the patch distance of nn_match: squared difference summed over every
+// pixel and channel. Patches are numbered as extract_patches and
+// extract_3d_patches number their centers, from 0
+class PatchMatch
+{
+public:
+	// sizes are odd, patchT = 1 for images
+	PatchMatch(int patchX, int patchY, int patchT);
+protected:
+	int _patchX;
+	int _patchY;
+	int _patchT;
+	int _iterations;
+	int _threads;
+	unsigned int _seed;
+protected:
+	// number of patch centers along each dimension
+	void GetGrid(const PatchVolume& volume, int grid[3]);
+	// distance of two patches given by their first pixel, stops once it
+	// reaches cutoff
+	float Distance(const PatchVolume& source, int sourceOffset, const PatchVolume& target, int targetOffset, float cutoff);
+public:
+	// propagation and random search passes, 5 by default
+	void SetIterations(int iterations);
+	// non-positive: as many as available
+	void SetThreads(int threads);
+	void SetSeed(unsigned int seed);
+
+	// best patch of target for every patch of source. initial, if not NULL,
+	// holds a guess for every source patch, typically the matches of the
+	// previous scale mapped to this one (interpolate_matches2_2d/3d).
+	// distance, if not NULL, receives the distance of each match
+	void Match(const PatchVolume& source, const PatchVolume& target, const int* initial, int* match, float* distance);
+
+	// same as bidirect_update_2d/3d: every source patch votes at its match in
+	// target (completeness) and every target patch gets its match in source
+	// (coherence), weighted by sourceWeights. target is overwritten with the
+	// weighted average
+	void BidirectionalUpdate(const PatchVolume& source, const float* sourceWeights, const int* sourceMatch,
+		const int* targetMatch, float completeWeight, float cohereWeight, PatchVolume& target);
+};
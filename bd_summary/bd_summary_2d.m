@@ -4,12 +4,18 @@ function bd_summary_2d(img_folder,config_file)
 %
 tic
 eval(config_file);
+if (~exist('use_patchmatch','var'))
+    use_patchmatch = 0;
+    pm_iterations = 5;
+    pm_threads = 0;
+end
 
 img_files = dir([data_folder,img_folder,'/*',img_ext]);
 img_names = cell(length(img_files),1);
 origins = cell(length(img_files),1);
 sources = cell(length(img_files),1);
 source_patches = cell(length(img_files),1);
+source_labs = cell(length(img_files),1);
 for i = 1 : length(img_files)
     img_names{i} = img_files(i).name;
     img = imread([data_folder,img_folder,'/',img_files(i).name]);
@@ -17,7 +23,12 @@ for i = 1 : length(img_files)
     sources{i} = imresize(img,[size(img,1)*scaling_factor,size(img,2)*scaling_factor]);
     fprintf('Starting patch extraction ... ');
     tic
-    source_patches{i} = extract_patches(RGB2Lab(sources{i}),patch_size,R);
+    source_labs{i} = RGB2Lab(sources{i});
+    if (use_patchmatch)
+        source_patches{i} = patch_grid(size(source_labs{i}),patch_size);
+    else
+        source_patches{i} = extract_patches(source_labs{i},patch_size,R);
+    end
     t = toc;
     fprintf('%f seconds\n',t);
     clear img;
@@ -46,13 +57,21 @@ while (resize_gap(1)>resize_target(1) | resize_gap(2)>resize_target(2))
     while (diff>converge_thresh)    
         target_patches = cell(length(img_files),1);
         for i = 1 : length(img_files)
-            target_patches{i} = extract_patches(targets{i},patch_size,R);
+            if (use_patchmatch)
+                target_patches{i} = patch_grid(size(targets{i}),patch_size);
+            else
+                target_patches{i} = extract_patches(targets{i},patch_size,R);
+            end
         end
         
         sources_match_array = cell(length(img_files),1);
         targets_match_array = cell(length(img_files),1);
         for i = 1 : length(img_files)
-            [s_matchId,t_matchId] = nn_match(source_patches{i},target_patches{i});
+            if (use_patchmatch)
+                [s_matchId,t_matchId] = pm_match(source_labs{i},targets{i},patch_size,[],[],pm_iterations,pm_threads);
+            else
+                [s_matchId,t_matchId] = nn_match(source_patches{i},target_patches{i});
+            end
             sources_match_array{i} = [sources_match_array{i};s_matchId];
             targets_match_array{i} = [targets_match_array{i};t_matchId];
         end
@@ -66,8 +85,13 @@ while (resize_gap(1)>resize_target(1) | resize_gap(2)>resize_target(2))
         for i = 1 : length(img_files)
             new_targets{i} = zeros(size(targets{i}));
             target = zeros(size(targets{i}));
-            new_targets{i} = bidirect_update_2d(target,patch_size,complete_weight,cohere_weight,source_patches_weights{i},...
-                                                source_patches{i},sources_match_array{i},target_patches{i},targets_match_array{i});
+            if (use_patchmatch)
+                new_targets{i} = pm_bidirect_update(source_labs{i},size(target),patch_size,complete_weight,cohere_weight,...
+                                                    source_patches_weights{i},sources_match_array{i},targets_match_array{i},pm_threads);
+            else
+                new_targets{i} = bidirect_update_2d(target,patch_size,complete_weight,cohere_weight,source_patches_weights{i},...
+                                                    source_patches{i},sources_match_array{i},target_patches{i},targets_match_array{i});
+            end
         end
         
         old_diff = diff;
@@ -116,7 +140,12 @@ while (scaling_factor*upsample_factor<1)
     for i = 1 : length(img_files)
         old_s_sizes(i,:) = [size(sources{i},1),size(sources{i},2)];
         sources{i} = imresize(origins{i},[size(origins{i},1)*scaling_factor,size(origins{i},2)*scaling_factor]);
-        source_patches{i} = extract_patches(RGB2Lab(sources{i}),patch_size,R);
+        source_labs{i} = RGB2Lab(sources{i});
+        if (use_patchmatch)
+            source_patches{i} = patch_grid(size(source_labs{i}),patch_size);
+        else
+            source_patches{i} = extract_patches(source_labs{i},patch_size,R);
+        end
     end 
     
     diff = 100; old_diff = 0;
@@ -124,7 +153,11 @@ while (scaling_factor*upsample_factor<1)
         old_target_patches = target_patches;        
         target_patches = cell(length(img_files),1);
         for i = 1 : length(img_files)
-            target_patches{i} = extract_patches(targets{i},patch_size,R);
+            if (use_patchmatch)
+                target_patches{i} = patch_grid(size(targets{i}),patch_size);
+            else
+                target_patches{i} = extract_patches(targets{i},patch_size,R);
+            end
         end
         
         for i = 1 : length(img_files)
@@ -149,7 +182,15 @@ while (scaling_factor*upsample_factor<1)
         sources_match_array = cell(length(img_files),1);
         targets_match_array = cell(length(img_files),1);
         for i = 1 : length(img_files)
-            if (~exist('old_sources_match_array') || ~exist('old_targets_match_array'))
+            if (use_patchmatch)
+                % the interpolated matches of the previous scale seed the search
+                if (~exist('old_sources_match_array') || ~exist('old_targets_match_array'))
+                    [s_matchId,t_matchId] = pm_match(source_labs{i},targets{i},patch_size,[],[],pm_iterations,pm_threads);
+                else
+                    [s_matchId,t_matchId] = pm_match(source_labs{i},targets{i},patch_size,old_sources_match_array{i},...
+                                                     old_targets_match_array{i},pm_iterations,pm_threads);
+                end
+            elseif (~exist('old_sources_match_array') || ~exist('old_targets_match_array'))
                 [s_matchId,t_matchId] = nn_match(source_patches{i},target_patches{i});
             else
                 [s_matchId,t_matchId] = nn_match(source_patches{i},target_patches{i},old_sources_match_array{i},old_targets_match_array{i});
@@ -167,8 +208,13 @@ while (scaling_factor*upsample_factor<1)
         for i = 1 : length(img_files)
             new_targets{i} = zeros(size(targets{i}));
             target = zeros(size(targets{i}));
-            new_targets{i} = bidirect_update_2d(target,patch_size,complete_weight,cohere_weight,source_patches_weights{i},...
-                                                source_patches{i},sources_match_array{i},target_patches{i},targets_match_array{i});
+            if (use_patchmatch)
+                new_targets{i} = pm_bidirect_update(source_labs{i},size(target),patch_size,complete_weight,cohere_weight,...
+                                                    source_patches_weights{i},sources_match_array{i},targets_match_array{i},pm_threads);
+            else
+                new_targets{i} = bidirect_update_2d(target,patch_size,complete_weight,cohere_weight,source_patches_weights{i},...
+                                                    source_patches{i},sources_match_array{i},target_patches{i},targets_match_array{i});
+            end
         end
         
         old_diff = diff;
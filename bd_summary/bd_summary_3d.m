@@ -4,6 +4,11 @@ function bd_summary_3d(img_folder,config_file)
 %
 tic
 eval(config_file);
+if (~exist('use_patchmatch','var'))
+    use_patchmatch = 0;
+    pm_iterations = 5;
+    pm_threads = 0;
+end
 
 img_files = dir([data_folder,img_folder,'/*',img_ext]);
 img_names = cell(length(img_files),1);
@@ -29,7 +34,11 @@ for i = 1 : size(sources{1},3)
     sources_frame(:,:,3) = sources{3}(:,:,i);
     imwrite(uint8(Lab2RGB(sources_frame)),sources_name,'bmp');
 end
-source_patches = extract_3d_patches(sources,patch_size,R);
+if (use_patchmatch)
+    source_patches = patch_grid(size(sources{1}),patch_size);
+else
+    source_patches = extract_3d_patches(sources,patch_size,R);
+end
 
 if (resize_gap(1)>resize_target(1))
     resize_gap(1) = resize_gap(1)*resize_increase_factor;
@@ -56,15 +65,26 @@ while (resize_gap(1)>resize_target(1) || resize_gap(2)>resize_target(2) || resiz
             scaling_factor(1),scaling_factor(2),scaling_factor(3),resize_gap(1),resize_gap(2),resize_gap(3));
     diff = 100; old_diff = 0;    
     while (diff>converge_thresh)
-        target_patches = extract_3d_patches(targets,patch_size,R);      
-        [source_matches,target_matches] = nn_match(source_patches,target_patches);
+        if (use_patchmatch)
+            target_patches = patch_grid(size(targets{1}),patch_size);
+            [source_matches,target_matches] = pm_match(cat(4,sources{:}),cat(4,targets{:}),patch_size,[],[],pm_iterations,pm_threads);
+        else
+            target_patches = extract_3d_patches(targets,patch_size,R);      
+            [source_matches,target_matches] = nn_match(source_patches,target_patches);
+        end
                 
         new_targets = cell(3,1);
         new_targets{1} = zeros(size(targets{1}));
         new_targets{2} = zeros(size(targets{2}));
         new_targets{3} = zeros(size(targets{3}));
-        new_targets = bidirect_update_3d(new_targets,patch_size,complete_weight,cohere_weight,ones(size(source_patches.features,1),1),...
-                                         source_patches,source_matches,target_patches,target_matches);
+        if (use_patchmatch)
+            updated = pm_bidirect_update(cat(4,sources{:}),size(targets{1}),patch_size,complete_weight,cohere_weight,...
+                                         ones(size(source_patches.centers,1),1),source_matches,target_matches,pm_threads);
+            new_targets = {updated(:,:,:,1);updated(:,:,:,2);updated(:,:,:,3)};
+        else
+            new_targets = bidirect_update_3d(new_targets,patch_size,complete_weight,cohere_weight,ones(size(source_patches.features,1),1),...
+                                             source_patches,source_matches,target_patches,target_matches);
+        end
         
         old_diff = diff;
         diff = 0;
@@ -119,13 +139,21 @@ while (scaling_factor*upsample_factor<1)
     old_source_patches = source_patches;
     old_s_sizes = size(sources{1});
     sources = resize_3d(sources,upsample_factor.*ones(1,3));
-    source_patches = extract_3d_patches(sources,patch_size,R);
+    if (use_patchmatch)
+        source_patches = patch_grid(size(sources{1}),patch_size);
+    else
+        source_patches = extract_3d_patches(sources,patch_size,R);
+    end
     
     diff = 100; old_diff = 0;
     while (diff>converge_thresh)
         tic;
         old_target_patches = target_patches;        
-        target_patches = extract_3d_patches(targets,patch_size,R);        
+        if (use_patchmatch)
+            target_patches = patch_grid(size(targets{1}),patch_size);
+        else
+            target_patches = extract_3d_patches(targets,patch_size,R);        
+        end
         
         if (old_diff==0)
             new_s_size = [size(sources{1},1),size(sources{1},2),size(sources{1},3)];
@@ -142,7 +170,11 @@ while (scaling_factor*upsample_factor<1)
         fprintf('Time spent: %f secs.\n',toc);
  
         tic;
-        if (~exist('old_source_matches') || ~exist('old_target_matches'))
+        if (use_patchmatch)
+            % the interpolated matches of the previous scale seed the search
+            [source_matches,target_matches] = pm_match(cat(4,sources{:}),cat(4,targets{:}),patch_size,old_source_matches,...
+                                                       old_target_matches,pm_iterations,pm_threads);
+        elseif (~exist('old_source_matches') || ~exist('old_target_matches'))
             [source_matches,target_matches] = nn_match(source_patches,target_patches);
         else
             [source_matches,target_matches] = nn_match(source_patches,target_patches,old_source_matches,old_target_matches);
@@ -154,8 +186,14 @@ while (scaling_factor*upsample_factor<1)
         new_targets{1} = zeros(size(targets{1}));
         new_targets{2} = zeros(size(targets{2}));
         new_targets{3} = zeros(size(targets{3}));
-        new_targets = bidirect_update_3d(new_targets,patch_size,complete_weight,cohere_weight,ones(size(source_patches.features,1),1),...
-                                         source_patches,source_matches,target_patches,target_matches);
+        if (use_patchmatch)
+            updated = pm_bidirect_update(cat(4,sources{:}),size(targets{1}),patch_size,complete_weight,cohere_weight,...
+                                         ones(size(source_patches.centers,1),1),source_matches,target_matches,pm_threads);
+            new_targets = {updated(:,:,:,1);updated(:,:,:,2);updated(:,:,:,3)};
+        else
+            new_targets = bidirect_update_3d(new_targets,patch_size,complete_weight,cohere_weight,ones(size(source_patches.features,1),1),...
+                                             source_patches,source_matches,target_patches,target_matches);
+        end
         fprintf('Time spent: %f secs.\n',toc);
         
         old_diff = diff;
@@ -16,5 +16,11 @@ cohere_weight = 1;
 % NN search radius
 R = 1;
 
+% PatchMatch (pm_match, see make.m) instead of the exact NN search, with
+% its number of passes and threads (0: all cores)
+use_patchmatch = 0;
+pm_iterations = 5;
+pm_threads = 0;
+
 data_folder = '../data/';
 result_folder = '../results/';
\ No newline at end of file
@@ -0,0 +1,33 @@
+function make
+%MAKE Build the native PatchMatch functions of bd_summary.
+%  MAKE compiles PM_MATCH and PM_BIDIRECT_UPDATE with OpenMP, using
+%  Matlab's default MEX compiler. If the MEX compiler has not been set-up
+%  before, please run
+%
+%    mex -setup
+%
+%  before using this MAKE file.
+
+
+% compilation parameters
+
+compstr = computer;
+compile_params = cell(0);
+if (strcmp(compstr(end-1:end),'64'))
+  compile_params{1} = '-largeArrayDims';
+end
+
+if (ispc)
+  openmp_params = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+  openmp_params = {'CXXFLAGS="\$CXXFLAGS -fopenmp"','LDFLAGS="\$LDFLAGS -fopenmp"'};
+end
+
+
+% Compile files %
+
+disp('Compiling pm_match...');
+mex('pm_match.cpp','PatchMatch.cpp',compile_params{:},openmp_params{:});
+
+disp('Compiling pm_bidirect_update...');
+mex('pm_bidirect_update.cpp','PatchMatch.cpp',compile_params{:},openmp_params{:});
@@ -0,0 +1,18 @@
+function patches=patch_grid(vol_size,patch_size)
+% Centers of all patches of an image or a video, in the order of
+% extract_patches / extract_3d_patches, without their features or
+% neighbours. Used with pm_match, which reads the patches itself.
+
+dims = length(patch_size);
+ranges = cell(dims,1);
+for d = 1 : dims
+    ranges{d} = [(patch_size(d)-1)/2+1 : vol_size(d)-(patch_size(d)-1)/2];
+end
+
+if (dims==2)
+    [y,x] = meshgrid(ranges{2},ranges{1});
+    patches.centers = [x(:),y(:)];
+else
+    [y,x,z] = meshgrid(ranges{2},ranges{1},ranges{3});
+    patches.centers = [x(:),y(:),z(:)];
+end
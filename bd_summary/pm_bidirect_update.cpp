@@ -0,0 +1,146 @@
+/**************************************************************************
+ *
+ * File name: pm_bidirect_update.cpp
+ *
+ * TARGET = PM_BIDIRECT_UPDATE(SOURCE,TARGET_SIZE,PATCH_SIZE,COMPLETE_WEIGHT,COHERE_WEIGHT,
+ *                             S_PATCH_WEIGHTS,S_MATCHID,T_MATCHID,THREADS)
+ *
+ * Native BIDIRECT_UPDATE_2D / BIDIRECT_UPDATE_3D, reading the patches
+ * from the Lab volume SOURCE (H x W x 3 or H x W x T x 3) rather than from
+ * extracted patch features. TARGET_SIZE is [H W] or [H W T] and the
+ * result has the channels of SOURCE last.
+ *
+ *************************************************************************/
+
+#include "mex.h"
+#include "PatchMatch.h"
+#include <vector>
+using namespace std;
+
+
+/* Input Arguments */
+
+#define SOURCE_IN     prhs[0]
+#define T_SIZE_IN     prhs[1]
+#define SZ_IN         prhs[2]
+#define COMPLETE_IN   prhs[3]
+#define COHERE_IN     prhs[4]
+#define WEIGHTS_IN    prhs[5]
+#define S_MATCH_IN    prhs[6]
+#define T_MATCH_IN    prhs[7]
+#define THREADS_IN    prhs[8]
+
+
+/* Output Arguments */
+
+#define TARGET_OUT    plhs[0]
+
+
+/* 1-based Matlab ids to 0-based ids, checked against the patch count */
+
+static void GetIds(const mxArray* array, mwSize count, mwSize range, vector<int>& ids)
+{
+    if (mxGetNumberOfElements(array) != count) {
+        mexErrMsgTxt("Matches should have one entry per patch.");
+    }
+    ids.resize(count);
+    const double* data = mxGetPr(array);
+    for (mwIndex i=0; i<count; ++i) {
+        ids[i] = (int)(data[i] + 0.5) - 1;
+        if (ids[i] < 0 || ids[i] >= (int)range) {
+            mexErrMsgTxt("Match out of range.");
+        }
+    }
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    if (nrhs < 8 || nrhs > 9) {
+        mexErrMsgTxt("Invalid number of input arguments.");
+    }
+    else if (nlhs > 1) {
+        mexErrMsgTxt("Too many output arguments.");
+    }
+    
+    int dims = (int)mxGetNumberOfElements(SZ_IN);
+    if (!mxIsDouble(SZ_IN) || dims < 2 || dims > 3 || (int)mxGetNumberOfElements(T_SIZE_IN) < dims) {
+        mexErrMsgTxt("Invalid patch or target size.");
+    }
+    if (!mxIsDouble(SOURCE_IN) || mxIsComplex(SOURCE_IN) || (int)mxGetNumberOfDimensions(SOURCE_IN) != dims+1) {
+        mexErrMsgTxt("SOURCE should be a Lab double array with channels last.");
+    }
+    const double* patchSize = mxGetPr(SZ_IN);
+    const double* targetSize = mxGetPr(T_SIZE_IN);
+    const mwSize* sourceSize = mxGetDimensions(SOURCE_IN);
+    
+    /* float copy of the source */
+    
+    mwSize sourceElements = mxGetNumberOfElements(SOURCE_IN);
+    vector<float> sourceBuffer(sourceElements);
+    const double* sourceData = mxGetPr(SOURCE_IN);
+    for (mwIndex i=0; i<sourceElements; ++i) {
+        sourceBuffer[i] = (float)sourceData[i];
+    }
+    PatchVolume source;
+    source.data = &sourceBuffer[0];
+    source.sizeX = (int)sourceSize[0];
+    source.sizeY = (int)sourceSize[1];
+    source.sizeT = dims == 3 ? (int)sourceSize[2] : 1;
+    source.channels = (int)sourceSize[dims];
+    
+    PatchVolume target;
+    target.sizeX = (int)(targetSize[0] + 0.01);
+    target.sizeY = (int)(targetSize[1] + 0.01);
+    target.sizeT = dims == 3 ? (int)(targetSize[2] + 0.01) : 1;
+    target.channels = source.channels;
+    mwSize targetElements = (mwSize)target.sizeX * target.sizeY * target.sizeT * target.channels;
+    vector<float> targetBuffer(targetElements);
+    target.data = &targetBuffer[0];
+    
+    int patchX = (int)(patchSize[0] + 0.01);
+    int patchY = (int)(patchSize[1] + 0.01);
+    int patchT = dims == 3 ? (int)(patchSize[2] + 0.01) : 1;
+    if (source.sizeX < patchX || source.sizeY < patchY || source.sizeT < patchT ||
+        target.sizeX < patchX || target.sizeY < patchY || target.sizeT < patchT) {
+        mexErrMsgTxt("Patch size too large.");
+    }
+    mwSize sourceCount = (mwSize)(source.sizeX-patchX+1) * (source.sizeY-patchY+1) * (source.sizeT-patchT+1);
+    mwSize targetCount = (mwSize)(target.sizeX-patchX+1) * (target.sizeY-patchY+1) * (target.sizeT-patchT+1);
+    
+    /* patch weights and matches */
+    
+    if (mxGetNumberOfElements(WEIGHTS_IN) != sourceCount) {
+        mexErrMsgTxt("S_PATCH_WEIGHTS should have one entry per source patch.");
+    }
+    vector<float> weights(sourceCount);
+    const double* weightData = mxGetPr(WEIGHTS_IN);
+    for (mwIndex i=0; i<sourceCount; ++i) {
+        weights[i] = (float)weightData[i];
+    }
+    vector<int> sourceMatch, targetMatch;
+    GetIds(S_MATCH_IN, sourceCount, targetCount, sourceMatch);
+    GetIds(T_MATCH_IN, targetCount, sourceCount, targetMatch);
+    
+    PatchMatch matcher(patchX, patchY, patchT);
+    if (nrhs > 8) {
+        matcher.SetThreads((int)mxGetScalar(THREADS_IN));
+    }
+    matcher.BidirectionalUpdate(source, &weights[0], &sourceMatch[0], &targetMatch[0],
+        (float)mxGetScalar(COMPLETE_IN), (float)mxGetScalar(COHERE_IN), target);
+    
+    /* result, channels last */
+    
+    mwSize outSize[4];
+    outSize[0] = target.sizeX;
+    outSize[1] = target.sizeY;
+    if (dims == 3) {
+        outSize[2] = target.sizeT;
+    }
+    outSize[dims] = target.channels;
+    TARGET_OUT = mxCreateNumericArray(dims+1, outSize, mxDOUBLE_CLASS, mxREAL);
+    double* out = mxGetPr(TARGET_OUT);
+    for (mwIndex i=0; i<targetElements; ++i) {
+        out[i] = targetBuffer[i];
+    }
+}
@@ -0,0 +1,154 @@
+/**************************************************************************
+ *
+ * File name: pm_match.cpp
+ *
+ * [S_MATCHID,T_MATCHID] = PM_MATCH(SOURCE,TARGET,PATCH_SIZE,S_INIT,T_INIT,ITERATIONS,THREADS)
+ *
+ * PatchMatch replacement of NN_MATCH. SOURCE and TARGET are Lab images
+ * (H x W x 3) or videos (H x W x T x 3). S_MATCHID holds the nearest
+ * target patch of every source patch and T_MATCHID the nearest source
+ * patch of every target patch, numbered as EXTRACT_PATCHES and
+ * EXTRACT_3D_PATCHES number their centers. S_INIT and T_INIT are initial
+ * guesses, e.g. from INTERPOLATE_MATCHES2_2D, or [] for random ones.
+ * THREADS non-positive uses all available cores.
+ *
+ *************************************************************************/
+
+#include "mex.h"
+#include "PatchMatch.h"
+#include <vector>
+using namespace std;
+
+
+/* Input Arguments */
+
+#define SOURCE_IN     prhs[0]
+#define TARGET_IN     prhs[1]
+#define SZ_IN         prhs[2]
+#define S_INIT_IN     prhs[3]
+#define T_INIT_IN     prhs[4]
+#define ITERATIONS_IN prhs[5]
+#define THREADS_IN    prhs[6]
+
+
+/* Output Arguments */
+
+#define S_MATCH_OUT   plhs[0]
+#define T_MATCH_OUT   plhs[1]
+
+
+/* float copy of a Lab volume, with patch dimensions dims (2 or 3) */
+
+static PatchVolume GetVolume(const mxArray* array, int dims, vector<float>& buffer, const char* name)
+{
+    PatchVolume volume;
+    const mwSize* size = mxGetDimensions(array);
+    mwSize count = mxGetNumberOfElements(array);
+    
+    if (!mxIsDouble(array) || mxIsComplex(array) || (int)mxGetNumberOfDimensions(array) != dims+1) {
+        mexErrMsgIdAndTxt("pm_match:input", "%s should be a %d-D Lab double array with channels last.", name, dims);
+    }
+    
+    buffer.resize(count);
+    const double* data = mxGetPr(array);
+    for (mwIndex i=0; i<count; ++i) {
+        buffer[i] = (float)data[i];
+    }
+    
+    volume.data = &buffer[0];
+    volume.sizeX = (int)size[0];
+    volume.sizeY = (int)size[1];
+    volume.sizeT = dims == 3 ? (int)size[2] : 1;
+    volume.channels = (int)size[dims];
+    return volume;
+}
+
+
+/* 1-based Matlab ids to 0-based ids, -1 for none */
+
+static void GetInitial(const mxArray* array, mwSize count, vector<int>& ids)
+{
+    if (mxIsEmpty(array)) {
+        ids.clear();
+        return;
+    }
+    if (mxGetNumberOfElements(array) != count) {
+        mexErrMsgIdAndTxt("pm_match:input", "Initial matches should have one entry per patch.");
+    }
+    ids.resize(count);
+    const double* data = mxGetPr(array);
+    for (mwIndex i=0; i<count; ++i) {
+        ids[i] = (int)(data[i] + 0.5) - 1;
+    }
+}
+
+
+static mxArray* ToMatlab(const vector<int>& ids)
+{
+    mxArray* array = mxCreateDoubleMatrix(ids.size(), 1, mxREAL);
+    double* data = mxGetPr(array);
+    for (size_t i=0; i<ids.size(); ++i) {
+        data[i] = ids[i] + 1;
+    }
+    return array;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    vector<float> sourceBuffer, targetBuffer;
+    vector<int> sourceInitial, targetInitial;
+    
+    if (nrhs < 3 || nrhs > 7) {
+        mexErrMsgTxt("Invalid number of input arguments.");
+    }
+    else if (nlhs > 2) {
+        mexErrMsgTxt("Too many output arguments.");
+    }
+    
+    int dims = (int)mxGetNumberOfElements(SZ_IN);
+    if (!mxIsDouble(SZ_IN) || dims < 2 || dims > 3) {
+        mexErrMsgTxt("Invalid patch size.");
+    }
+    const double* patchSize = mxGetPr(SZ_IN);
+    int patchX = (int)(patchSize[0] + 0.01);
+    int patchY = (int)(patchSize[1] + 0.01);
+    int patchT = dims == 3 ? (int)(patchSize[2] + 0.01) : 1;
+    
+    PatchVolume source = GetVolume(SOURCE_IN, dims, sourceBuffer, "SOURCE");
+    PatchVolume target = GetVolume(TARGET_IN, dims, targetBuffer, "TARGET");
+    if (source.channels != target.channels) {
+        mexErrMsgTxt("SOURCE and TARGET should have the same channels.");
+    }
+    if (source.sizeX < patchX || source.sizeY < patchY || source.sizeT < patchT ||
+        target.sizeX < patchX || target.sizeY < patchY || target.sizeT < patchT) {
+        mexErrMsgTxt("Patch size too large.");
+    }
+    
+    mwSize sourceCount = (mwSize)(source.sizeX-patchX+1) * (source.sizeY-patchY+1) * (source.sizeT-patchT+1);
+    mwSize targetCount = (mwSize)(target.sizeX-patchX+1) * (target.sizeY-patchY+1) * (target.sizeT-patchT+1);
+    if (nrhs > 3) {
+        GetInitial(S_INIT_IN, sourceCount, sourceInitial);
+    }
+    if (nrhs > 4) {
+        GetInitial(T_INIT_IN, targetCount, targetInitial);
+    }
+    
+    PatchMatch matcher(patchX, patchY, patchT);
+    if (nrhs > 5) {
+        matcher.SetIterations((int)(mxGetScalar(ITERATIONS_IN) + 0.01));
+    }
+    if (nrhs > 6) {
+        matcher.SetThreads((int)mxGetScalar(THREADS_IN));
+    }
+    
+    vector<int> sourceMatch(sourceCount);
+    matcher.Match(source, target, sourceInitial.empty() ? NULL : &sourceInitial[0], &sourceMatch[0], NULL);
+    S_MATCH_OUT = ToMatlab(sourceMatch);
+    
+    if (nlhs > 1) {
+        vector<int> targetMatch(targetCount);
+        matcher.Match(target, source, targetInitial.empty() ? NULL : &targetInitial[0], &targetMatch[0], NULL);
+        T_MATCH_OUT = ToMatlab(targetMatch);
+    }
+}
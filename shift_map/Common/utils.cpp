@@ -1313,46 +1313,57 @@ Picture *Reduce(Picture *src)
   //cout << "Reducing image to " << Width << "x" << Height << endl;
   Picture *result = new Picture(Width, Height);
 
+  for (int j = 0; j < Height; j++)
+	for (int i = 0; i < Width; i++)
+	  result->SetPixelIntensity(i, j, ReducePixel(src, i, j, Width));
+
+  return result;
+}
+
+/* computes the single pixel (i,j) of Reduce(src), where Width is the
+ * width of the reduced image. Lets a caller refresh only part of a
+ * pyramid level instead of reducing the whole picture again
+ */
+intensityType ReducePixel(Picture *src, int i, int j, int Width)
+{
+#ifdef USE_TRACEBACK
+  Trace->Add(__FILE__, __LINE__);
+#endif
   /* weights as suggested in the Burt-Adelson's paper */
-  double weight[5] = { 0.05, 0.25, 0.4, 0.25, 0.05 };
+  static const double weight[5] = { 0.05, 0.25, 0.4, 0.25, 0.05 };
 
   intensityType g0, g1;
-
-  for (int j = 0; j < Height; j++)
-	for (int i = 0; i < Width; i++) {
-	  memset((void *) &g1, 0, sizeof(intensityType));
-
-	  for (int m = -2; m < 3; m++)
-		for (int n = -2; n < 3; n++) {
-		  int x = (2 * i) + m;
-		  int y = (2 * j) + n;
-
-		  /* for boundary conditions, use a reflection across the edge node */
-		  if (x >= src->GetWidth())
-			x = x - abs(Width - (x + 1));
-		  if (y >= src->GetHeight())
-			y = y - abs(src->GetHeight() - (y + 1));
-		  if (x < 0)
-			x = abs(x);
-		  if (y < 0)
-			y = abs(y);
-
-		  int mp = m + 2;
-		  int np = n + 2;
-		  if (src->Inside(x, y)) {
-			try {
-			  g0 = src->GetPixelIntensity(x, y);
-			  g1.r = (int) round((weight[mp] * weight[np] * g0.r) + g1.r);
-			  g1.g = (int) round((weight[mp] * weight[np] * g0.g) + g1.g);
-			  g1.b = (int) round((weight[mp] * weight[np] * g0.b) + g1.b);
-			}
-			catch (IndexOutOfBoundsException ex) {}
-		  }
+  memset((void *) &g1, 0, sizeof(intensityType));
+
+  for (int m = -2; m < 3; m++)
+	for (int n = -2; n < 3; n++) {
+	  int x = (2 * i) + m;
+	  int y = (2 * j) + n;
+
+	  /* for boundary conditions, use a reflection across the edge node */
+	  if (x >= src->GetWidth())
+		x = x - abs(Width - (x + 1));
+	  if (y >= src->GetHeight())
+		y = y - abs(src->GetHeight() - (y + 1));
+	  if (x < 0)
+		x = abs(x);
+	  if (y < 0)
+		y = abs(y);
+
+	  int mp = m + 2;
+	  int np = n + 2;
+	  if (src->Inside(x, y)) {
+		try {
+		  g0 = src->GetPixelIntensity(x, y);
+		  g1.r = (int) round((weight[mp] * weight[np] * g0.r) + g1.r);
+		  g1.g = (int) round((weight[mp] * weight[np] * g0.g) + g1.g);
+		  g1.b = (int) round((weight[mp] * weight[np] * g0.b) + g1.b);
 		}
-	  result->SetPixelIntensity(i, j, g1);
+		catch (IndexOutOfBoundsException ex) {}
+	  }
 	}
 
-  return result;
+  return g1;
 }
 
 /* expands an image, as described in the Burt-Adelson paper */
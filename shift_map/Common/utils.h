@@ -120,6 +120,7 @@ Matrix *Register(Picture *I1, Picture *I2, pointType InitialPoints[2][4]);
 
 Picture *Sharpening(Picture *src);
 Picture *Reduce(Picture *src);
+intensityType ReducePixel(Picture *src, int i, int j, int Width);
 Picture *Expand(Picture *src);
 Picture *Laplacian(Picture *g1, Picture *g0);
 pyramidType *GaussianPyramid(Picture *src);
@@ -211,6 +211,161 @@ double smoothFn(int p1, int p2, int l1, int l2, void *data)
 		return cost;
 }
 
+struct ForLayerSmoothFn
+{
+	ForSmoothFn *context;
+	int offset;				// site of the multi-grid graph where the layer starts
+};
+
+double layerSmoothFn(int p1, int p2, int l1, int l2, void *data)
+{
+	ForLayerSmoothFn *myData = (ForLayerSmoothFn *) data;
+	return smoothFn(p1+myData->offset, p2+myData->offset, l1, l2, myData->context);
+}
+
+/*
+ * energy of a labeling of the multi-grid graph: the 4-connected pairs 
+ * inside every layer plus the links of each pixel to the same pixel in 
+ * every other layer
+ */
+double ContextEnergy(int *labels, ForSmoothFn *toSmoothFn)
+{
+	int width = toSmoothFn->target_size.width;
+	int height = toSmoothFn->target_size.height;
+	int layers = toSmoothFn->src->GetLength();
+	int layer_size = width*height;
+	double energy = 0.0;
+
+	#pragma omp parallel for reduction(+:energy)
+	for (int t = 0; t < layers; t++)
+	{
+		double layer_energy = 0.0;
+		for (int i = 0; i < layer_size; i++)
+		{
+			int p = t*layer_size+i;
+			if (i % width > 0)
+				layer_energy += smoothFn(p, p-1, labels[p], labels[p-1], toSmoothFn);
+			if (i / width > 0)
+				layer_energy += smoothFn(p, p-width, labels[p], labels[p-width], toSmoothFn);
+			for (int n = 0; n < t; n++)
+			{
+				int q = n*layer_size+i;
+				layer_energy += smoothFn(p, q, labels[p], labels[q], toSmoothFn);
+			}
+		}
+		energy += layer_energy;
+	}
+
+	return energy;
+}
+
+/*
+ * solves layer t on its own grid graph with the labels of all other 
+ * layers held fixed, so the links to the other layers become data terms. 
+ * The layer starts from its labels in labels and ends in new_labels
+ */
+void SolveContextLayer(int t, int *labels, int *new_labels, ForSmoothFn *toSmoothFn, int num_labels)
+{
+	int width = toSmoothFn->target_size.width;
+	int height = toSmoothFn->target_size.height;
+	int layers = toSmoothFn->src->GetLength();
+	int layer_size = width*height;
+	int offset = t*layer_size;
+
+	// cross-layer links of every pixel, once per label
+	GCoptimization::EnergyTermType *data = new GCoptimization::EnergyTermType[layer_size*num_labels];
+	for (int i = 0; i < layer_size; i++)
+	{
+		int p = offset+i;
+		for (int l = 0; l < num_labels; l++)
+		{
+			double cost = 0.0;
+			for (int n = 0; n < layers; n++)
+			{
+				if (n == t)
+					continue;
+				int q = n*layer_size+i;
+				if (q < p)
+					cost += smoothFn(p, q, l, labels[q], toSmoothFn);
+				else
+					cost += smoothFn(q, p, labels[q], l, toSmoothFn);
+			}
+			data[i*num_labels+l] = cost;
+		}
+	}
+
+	try{
+		GCoptimizationGridGraph *gc = new GCoptimizationGridGraph(width,height,num_labels);
+		gc->setDataCost(data);
+
+		ForLayerSmoothFn toLayerSmoothFn;
+		toLayerSmoothFn.context = toSmoothFn;
+		toLayerSmoothFn.offset = offset;
+		gc->setSmoothCost(&layerSmoothFn, &toLayerSmoothFn);
+
+		for (int i = 0; i < layer_size; i++)
+			gc->setLabel(i,labels[offset+i]);
+		gc->expansion();
+
+		for (int i = 0; i < layer_size; i++)
+			new_labels[offset+i] = gc->whatLabel(i);
+		delete gc;
+	}
+	catch (GCException e){
+		e.Report();
+	}
+
+	delete [] data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// layer-parallel version: block-coordinate descent over the layers of the 
+// multi-grid graph. Each sweep solves all layers at once against the labels 
+// of the previous sweep; if that raises the energy, the sweep is redone one 
+// layer at a time, which never increases it. Stops once a sweep does 
+// not lower the energy
+//
+int *ContextLayers_GraphCut(ForSmoothFn *toSmoothFn, int num_labels, int sweeps)
+{
+	int layers = toSmoothFn->src->GetLength();
+	int num_pixels = toSmoothFn->target_size.width*toSmoothFn->target_size.height*layers;
+	int *labels = new int[num_pixels];
+	int *new_labels = new int[num_pixels];
+	for (int i = 0; i < num_pixels; i++)
+		labels[i] = 0;
+
+	double energy = ContextEnergy(labels,toSmoothFn);
+	printf("Before optimization energy is %f\n",energy);
+	for (int k = 0; k < sweeps; k++)
+	{
+		#pragma omp parallel for schedule(dynamic)
+		for (int t = 0; t < layers; t++)
+			SolveContextLayer(t,labels,new_labels,toSmoothFn,num_labels);
+
+		double new_energy = ContextEnergy(new_labels,toSmoothFn);
+		if (new_energy > energy)
+		{
+			memcpy(new_labels,labels,num_pixels*sizeof(int));
+			for (int t = 0; t < layers; t++)
+				SolveContextLayer(t,new_labels,new_labels,toSmoothFn,num_labels);
+			new_energy = ContextEnergy(new_labels,toSmoothFn);
+		}
+		printf("Sweep %d: energy is %f\n",k,new_energy);
+
+		int *tmp = labels;
+		labels = new_labels;
+		new_labels = tmp;
+		bool converged = (new_energy >= energy);
+		energy = new_energy;
+		if (converged)
+			break;
+	}
+	printf("After optimization energy is %f\n",energy);
+
+	delete [] new_labels;
+	return labels;
+}
+
 PictureList *SaveRetargetPicture(int *labels, PictureList *src, int num_labels_x, int width, int height, char *name)
 {
 	PictureList *result = new PictureList(-1,-1,src->GetLength());
@@ -251,10 +406,11 @@ PictureList *SaveRetargetPicture(int *labels, PictureList *src, int num_labels_x
 
 ////////////////////////////////////////////////////////////////////////////////
 // in this version, set data and smoothness terms using arrays
-// grid neighborhood structure is assumed
+// grid neighborhood structure is assumed. With sweeps>0 the layers are 
+// solved separately by ContextLayers_GraphCut instead of as one graph
 //
 int *ContextGridGraph_GraphCut(PictureList *src, PictureList *&output, int *assignments, videoSize &target_size, videoSize &previous_size,
-							   int num_labels_x, int num_labels_y, float alpha, float beta, char *target_name)
+							   int num_labels_x, int num_labels_y, float alpha, float beta, char *target_name, int sweeps)
 {
 	int num_pixels = target_size.width*
 					 target_size.height*
@@ -262,13 +418,9 @@ int *ContextGridGraph_GraphCut(PictureList *src, PictureList *&output, int *assi
 	int *result = new int[num_pixels];   // stores result of optimization
 
 	try{
-		GCoptimizationMultiGridGraph *gc = new GCoptimizationMultiGridGraph(target_size.width,
-																			target_size.height,
-																			src->GetLength(),
-																			num_labels_x*num_labels_y);
-
 		// set up the needed data to pass to function for the data costs
 		gradient2D *gradient = new gradient2D[src->GetLength()];
+		#pragma omp parallel for
 		for (int i = 0; i < src->GetLength(); i++)
 			gradient[i] = *(Gradient(src->GetPicture(i)));
 
@@ -280,7 +432,6 @@ int *ContextGridGraph_GraphCut(PictureList *src, PictureList *&output, int *assi
 		toDataFn.num_labels_y = num_labels_y;
 		toDataFn.previous_size = previous_size;
 		toDataFn.target_size = target_size;
-		gc->setDataCost(&dataFn,&toDataFn);
 
 		// smoothness comes from function pointer
 		ForSmoothFn toSmoothFn;
@@ -293,11 +444,30 @@ int *ContextGridGraph_GraphCut(PictureList *src, PictureList *&output, int *assi
 		toSmoothFn.target_size = target_size;
 		toSmoothFn.alpha = alpha;
 		toSmoothFn.beta = beta;
-		gc->setSmoothCost(&smoothFn, &toSmoothFn);
 
-		printf("Before optimization energy is %f\n",gc->compute_energy());
-		gc->expansion();// run expansion for 2 iterations. For swap use gc->swap(num_iterations);
-		printf("After optimization energy is %f\n",gc->compute_energy());
+		int *labels;
+		if (sweeps > 0)
+		{
+			labels = ContextLayers_GraphCut(&toSmoothFn,num_labels_x*num_labels_y,sweeps);
+		}
+		else
+		{
+			GCoptimizationMultiGridGraph *gc = new GCoptimizationMultiGridGraph(target_size.width,
+																				target_size.height,
+																				src->GetLength(),
+																				num_labels_x*num_labels_y);
+			gc->setDataCost(&dataFn,&toDataFn);
+			gc->setSmoothCost(&smoothFn, &toSmoothFn);
+
+			printf("Before optimization energy is %f\n",gc->compute_energy());
+			gc->expansion();// run expansion for 2 iterations. For swap use gc->swap(num_iterations);
+			printf("After optimization energy is %f\n",gc->compute_energy());
+
+			labels = new int[num_pixels];
+			for (int i = 0; i < num_pixels; i++)
+				labels[i] = gc->whatLabel(i);
+			delete gc;
+		}
 		
 		int s, x, y, t;
 		int assign_idx, assignment;
@@ -312,11 +482,11 @@ int *ContextGridGraph_GraphCut(PictureList *src, PictureList *&output, int *assi
 			
 			if (assignment>=0)
 			{
-				result[i] = max(assignment+gc->whatLabel(i)-1,0);
+				result[i] = max(assignment+labels[i]-1,0);
 			}
 			else
 			{
-				result[i] = gc->whatLabel(i);
+				result[i] = labels[i];
 			}			
 		}		
 
@@ -331,7 +501,7 @@ int *ContextGridGraph_GraphCut(PictureList *src, PictureList *&output, int *assi
 			delete gradient[i].dy;
 		}
 		delete [] gradient;
-		delete gc;
+		delete [] labels;
 	}
 	catch (GCException e){
 		e.Report();
@@ -353,10 +523,12 @@ int main(int argc, char **argv)
 
 	if (argc<7)
 	{
-		cout << "Usage: contextual_shift_map_2d <input_folder> <alpha> <beta> <y_ratio> <x_ratio> <output_folder>" << endl;
+		cout << "Usage: contextual_shift_map_2d <input_folder> <alpha> <beta> <y_ratio> <x_ratio> <output_folder> [layer_sweeps]" << endl;
 		return 0;
 		//default parameters
 	}
+	// 0 solves all layers as one multi-grid graph
+	int sweeps = (argc > 7) ? atoi(argv[7]) : 0;
 
 	// load input video
 	cout << "Load Image List ... \n" << endl;
@@ -392,7 +564,7 @@ int main(int argc, char **argv)
 
 			// smoothness and data costs are set up using functions
 			new_assignments = ContextGridGraph_GraphCut(&(lpyramid->Lists[i]),retarget,assignments,target_size,previous_size,
-														num_labels_x,num_labels_y,atof(argv[2]),atof(argv[3]),argv[6]);
+														num_labels_x,num_labels_y,atof(argv[2]),atof(argv[3]),argv[6],sweeps);
 			delete [] assignments;
 			assignments = new_assignments;
 			input = retarget;
@@ -417,7 +589,7 @@ int main(int argc, char **argv)
 
 				// smoothness and data costs are set up using functions
 				new_assignments = ContextGridGraph_GraphCut(&(lpyramid->Lists[i]),retarget,assignments,target_size,previous_size,
-															num_labels_x,1,atof(argv[2]),atof(argv[3]),argv[6]);
+															num_labels_x,1,atof(argv[2]),atof(argv[3]),argv[6],sweeps);
 				delete [] assignments;
 				assignments = new_assignments;
 				input = retarget;
@@ -446,7 +618,7 @@ int main(int argc, char **argv)
 				previous_size.time = 0;
 				// smoothness and data costs are set up using functions
 				new_assignments = ContextGridGraph_GraphCut(input,retarget,assignments,target_size,previous_size,
-															1,num_labels_y,atof(argv[2]),atof(argv[3]),argv[6]);
+															1,num_labels_y,atof(argv[2]),atof(argv[3]),argv[6],sweeps);
 				delete [] assignments;
 				assignments = new_assignments;
 			}
@@ -470,7 +642,7 @@ int main(int argc, char **argv)
 			target_size.time = time;
 
 			new_assignments = ContextGridGraph_GraphCut(&(lpyramid->Lists[i]),assignments,target_size,previous_size,
-														num_labels_x,num_labels_y,atof(argv[2]),atof(argv[3]),argv[6]);
+														num_labels_x,num_labels_y,atof(argv[2]),atof(argv[3]),argv[6],sweeps);
 			delete [] assignments;
 			assignments = new_assignments;
 			*/
@@ -53,6 +53,10 @@ double dataFn(int p, int l, void *data)
 	return( myData->data[p*numLab+l] );
 }
 
+// With more than two labels, label l marks the pixels between manifold l-1
+// and manifold l, so labels never decrease from left to right. A pair of
+// neighbours whose labels differ by n is crossed by n manifolds and pays
+// the cost of one crossing n times.
 double smoothBEFn(int p1, int p2, int l1, int l2, void *data)
 {
 //printf("p1=%i	p2=%i	l1=%i	l2=%i\n", p1,p2,l1,l2);
@@ -80,22 +84,22 @@ double smoothBEFn(int p1, int p2, int l1, int l2, void *data)
 	if (l1==l2)		cost=0;
 	// same frame
 	// horizontal
-	else if (f1==f2 && x1==x2 && y1>y2 && l1==1 && l2==0)	cost=gradXY[f1].Get(x2+1,y2+1);		//gradXY->Get(x2+1,y2+1);
-	else if (f1==f2 && x1==x2 && y1>y2 && l1==0 && l2==1)	cost=MAX_COST_VALUE;
+	else if (f1==f2 && x1==x2 && y1>y2 && l1==l2+1)	cost=gradXY[f1].Get(x2+1,y2+1);		//gradXY->Get(x2+1,y2+1);
+	else if (f1==f2 && x1==x2 && y1>y2)	cost=MAX_COST_VALUE;		// manifolds may not cross or merge
 	// diagonal */*
-	else if (f1==f2 && x1>x2 && y1<y2 && l1==0 && l2==1)	cost=0;
-	else if (f1==f2 && x1>x2 && y1<y2 && l1==1 && l2==0)	cost=MAX_COST_VALUE;
+	else if (f1==f2 && x1>x2 && y1<y2 && l1<l2)	cost=0;
+	else if (f1==f2 && x1>x2 && y1<y2 && l1>l2)	cost=MAX_COST_VALUE;
 	// diagonal *\*
-	else if (f1==f2 && x1>x2 && y1>y2 && l1==0 && l2==1)	cost=MAX_COST_VALUE;
-	else if (f1==f2 && x1>x2 && y1>y2 && l1==1 && l2==0)	cost=0;
+	else if (f1==f2 && x1>x2 && y1>y2 && l1<l2)	cost=MAX_COST_VALUE;
+	else if (f1==f2 && x1>x2 && y1>y2 && l1>l2)	cost=0;
 	
 	// diff frame
 	// diagonal *\*
-	else if (f1>f2 && x1==x2 && y1<y2 && l1==0 && l2==1)	cost=0;
-	else if (f1>f2 && x1==x2 && y1<y2 && l1==1 && l2==0)	cost=MAX_COST_VALUE;
+	else if (f1>f2 && x1==x2 && y1<y2 && l1<l2)	cost=0;
+	else if (f1>f2 && x1==x2 && y1<y2 && l1>l2)	cost=MAX_COST_VALUE;
 	// diagonal */*
-	else if (f1>f2 && x1==x2 && y1>y2 && l1==1 && l2==0)	cost=0;
-	else if (f1>f2 && x1==x2 && y1>y2 && l1==0 && l2==1)	cost=MAX_COST_VALUE;
+	else if (f1>f2 && x1==x2 && y1>y2 && l1>l2)	cost=0;
+	else if (f1>f2 && x1==x2 && y1>y2 && l1<l2)	cost=MAX_COST_VALUE;
 
 //printf("smoothFn: computing cost between (%d,%d,%d) and (%d,%d,%d) with labels %d and %d : %d\n",f1,y1,x1,f2,y2,x2,l1,l2,cost);
 	return cost;
@@ -126,39 +130,297 @@ double smoothFEFn(int p1, int p2, int l1, int l2, void *data)
 	Matrix *temp_nLU = ((ForSmoothFEFn*)data)->temp_nLU;
 
 	if (l1==l2)			cost=0;
-	else if (f1==f2 && x1==x2 && y1>y2 && l1==1 && l2==0)	cost=LR[f1].Get(x2+1,y2+1);
-	else if (f1==f2 && x1==x2 && y1>y2 && l1==0 && l2==1)	cost=MAX_COST_VALUE;
+	else if (f1==f2 && x1==x2 && y1>y2 && l1==l2+1)	cost=LR[f1].Get(x2+1,y2+1);
+	else if (f1==f2 && x1==x2 && y1>y2)	cost=MAX_COST_VALUE;		// manifolds may not cross or merge
 
-	else if (f1==f2 && x1>x2 && y1==y2 && l1==0 && l2==1)	cost=pLU[f1].Get(x1+1,y1+1);
-	else if (f1==f2 && x1>x2 && y1==y2 && l1==1 && l2==0)	cost=nLU[f1].Get(x2+1,y2+1);
+	else if (f1==f2 && x1>x2 && y1==y2 && l1<l2)	cost=(l2-l1)*pLU[f1].Get(x1+1,y1+1);
+	else if (f1==f2 && x1>x2 && y1==y2 && l1>l2)	cost=(l1-l2)*nLU[f1].Get(x2+1,y2+1);
 
-	else if (f1==f2 && x1>x2 && y1>y2 && l1==1 && l2==0)	cost=0;
-	else if (f1==f2 && x1>x2 && y1>y2 && l1==0 && l2==1)	cost=MAX_COST_VALUE;
+	else if (f1==f2 && x1>x2 && y1>y2 && l1>l2)	cost=0;
+	else if (f1==f2 && x1>x2 && y1>y2 && l1<l2)	cost=MAX_COST_VALUE;
 
-	else if (f1==f2 && x1>x2 && y1<y2 && l1==1 && l2==0)	cost=MAX_COST_VALUE;
-	else if (f1==f2 && x1>x2 && y1<y2 && l1==0 && l2==1)	cost=0;
+	else if (f1==f2 && x1>x2 && y1<y2 && l1>l2)	cost=MAX_COST_VALUE;
+	else if (f1==f2 && x1>x2 && y1<y2 && l1<l2)	cost=0;
 
-	else if (f1>f2 && x1==x2 && y1==y2 && l1==1 && l2==0)	cost=temp_pLU[x1].Get(f2+1,y1+1);//cost=0;
-	else if (f1>f2 && x1==x2 && y1==y2 && l1==0 && l2==1)	cost=temp_nLU[x1].Get(f1+1,y1+1);//cost=0;
+	else if (f1>f2 && x1==x2 && y1==y2 && l1>l2)	cost=(l1-l2)*temp_pLU[x1].Get(f2+1,y1+1);//cost=0;
+	else if (f1>f2 && x1==x2 && y1==y2 && l1<l2)	cost=(l2-l1)*temp_nLU[x1].Get(f1+1,y1+1);//cost=0;
 
-	else if (f1>f2 && x1==x2 && y1>y2 && l1==1 && l2==0)	cost=0;
-	else if (f1>f2 && x1==x2 && y1>y2 && l1==0 && l2==1)	cost=MAX_COST_VALUE;
+	else if (f1>f2 && x1==x2 && y1>y2 && l1>l2)	cost=0;
+	else if (f1>f2 && x1==x2 && y1>y2 && l1<l2)	cost=MAX_COST_VALUE;
 
-	else if (f1>f2 && x1==x2 && y1<y2 && l1==0 && l2==1)	cost=0;
-	else if (f1>f2 && x1==x2 && y1<y2 && l1==1 && l2==0)	cost=MAX_COST_VALUE;
+	else if (f1>f2 && x1==x2 && y1<y2 && l1<l2)	cost=0;
+	else if (f1>f2 && x1==x2 && y1<y2 && l1>l2)	cost=MAX_COST_VALUE;
 
 //printf("smoothFn: computing cost between (%d,%d,%d) and (%d,%d,%d) with labels %d and %d : %d\n",f1,y1,x1,f2,y2,x2,l1,l2,cost);
 	return cost;
 }
 
-int *CalcPixelCost(GCoptimization *gc, int num_labels, int width, int height, int time, int *data)
+// Gaussian pyramid kept alive across manifold removals. Level l is only
+// brought back in sync with level l-1 once level l-1 has lost two columns,
+// and then only the columns whose Reduce footprint touches the removed
+// manifolds are recomputed; the rest of each row is shifted. The manifold
+// found on a coarse level is cached and reused for the following seams for
+// as long as that level has not been synced again.
+typedef struct {
+	listPyramidType *pyramid;
+	int **labels;		// cached manifold of each coarse level, NULL if out of date
+	int *pending;		// manifolds removed from level l-1 since level l was synced
+	int **lo;			// leftmost changed column of level l-1, per (frame,row)
+	int **hi;			// rightmost changed column of level l-1, per (frame,row)
+} seamPyramidType;
+
+seamPyramidType *SeamPyramid(PictureList *src, int levels)
+{
+	seamPyramidType *spyramid = new seamPyramidType;
+	spyramid->pyramid = ListPyramid(src, levels);
+
+	levels = spyramid->pyramid->Levels;
+	spyramid->labels = new int*[levels];
+	spyramid->pending = new int[levels];
+	spyramid->lo = new int*[levels];
+	spyramid->hi = new int*[levels];
+	for ( int l = 0; l < levels; l++ )
+	{
+		spyramid->labels[l] = NULL;
+		spyramid->pending[l] = 0;
+		spyramid->lo[l] = NULL;
+		spyramid->hi[l] = NULL;
+		if ( l > 0 )
+		{
+			PictureList *finer = &(spyramid->pyramid->Lists[l-1]);
+			int rows = finer->GetMaxHeight()*finer->GetLength();
+			spyramid->lo[l] = new int[rows];
+			spyramid->hi[l] = new int[rows];
+		}
+	}
+	return spyramid;
+}
+
+void DeleteSeamPyramid(seamPyramidType *spyramid)
+{
+	for ( int l = 0; l < spyramid->pyramid->Levels; l++ )
+	{
+		delete [] spyramid->labels[l];
+		delete [] spyramid->lo[l];
+		delete [] spyramid->hi[l];
+	}
+	delete [] spyramid->labels;
+	delete [] spyramid->pending;
+	delete [] spyramid->lo;
+	delete [] spyramid->hi;
+	delete [] spyramid->pyramid->Lists;
+	delete spyramid->pyramid;
+	delete spyramid;
+}
+
+// returns, for every (frame,row), the column of manifold j, i.e. the 
+// last pixel labelled j or lower before the labels rise above j
+int *ManifoldColumns(int *labels, int width, int height, int time, int j)
+{
+	int *cols = new int[height*time];
+	for ( int r = 0; r < height*time; r++ )
+	{
+		int *row = labels + r*width;
+		int x = 0;
+		while ( x < width-1 && !(row[x]<=j && row[x+1]>j) )
+			x++;
+		cols[r] = x;
+	}
+	return cols;
+}
+
+// removes column cols[t*height+y] from every row of the list, in place
+void RemoveColumns(PictureList *list, int *cols)
+{
+	int width = list->GetMaxWidth();
+	int height = list->GetMaxHeight();
+	int time = list->GetLength();
+	string str;
+
+	for ( int t = 0; t < time; t++ )
+	{
+		Picture *old = list->GetPicture(t);
+		Picture *frame = new Picture(width-1,height);
+		str = old->GetName();
+		if ( str.find("seam_")==0 )
+			str = str.erase(0,5);
+		frame->SetName(str.c_str());
+
+		for ( int y = 0; y < height; y++ )
+		{
+			int col = cols[t*height+y];
+			for ( int x = 0; x < width-1; x++ )
+				frame->SetPixelIntensity(x,y,old->GetPixelIntensity((x<col) ? x : x+1,y));
+		}
+		*old = *frame;
+		delete frame;
+	}
+	list->SetMinWidth(width-1);
+	list->SetMaxWidth(width-1);
+}
+
+// Brings level l back in sync with level l-1 after two manifolds have been
+// removed from it. A coarse pixel whose 5x5 footprint lies left of every
+// changed column is kept, one that lies right of them is the old pixel one
+// column further right, and only the pixels in between are reduced again.
+// lo/hi receive the columns of level l that were recomputed.
+void SyncPyramidLevel(seamPyramidType *spyramid, int l, int *&lo, int *&hi)
+{
+	PictureList *finer = &(spyramid->pyramid->Lists[l-1]);
+	PictureList *coarser = &(spyramid->pyramid->Lists[l]);
+	int fine_width = finer->GetMaxWidth();
+	int fine_height = finer->GetMaxHeight();
+	int width = coarser->GetMaxWidth()-1;
+	int height = coarser->GetMaxHeight();
+	int time = coarser->GetLength();
+
+	lo = new int[height*time];
+	hi = new int[height*time];
+
+	for ( int t = 0; t < time; t++ )
+	{
+		Picture *old = coarser->GetPicture(t);
+		Picture *fine = finer->GetPicture(t);
+		Picture *frame = new Picture(width,height);
+		frame->SetName(old->GetName());
+
+		for ( int j = 0; j < height; j++ )
+		{
+			int flo = fine_width;
+			int fhi = -1;
+			for ( int y = 2*j-2; y <= 2*j+2; y++ )
+			{
+				if ( y < 0 || y >= fine_height )
+					continue;
+				if ( spyramid->lo[l][t*fine_height+y] < flo )
+					flo = spyramid->lo[l][t*fine_height+y];
+				if ( spyramid->hi[l][t*fine_height+y] > fhi )
+					fhi = spyramid->hi[l][t*fine_height+y];
+			}
+			int ilo = (flo-1)/2;
+			int ihi = (fhi+2)/2;
+			if ( ilo < 0 )			ilo = 0;
+			if ( ihi > width-1 )	ihi = width-1;
+
+			for ( int i = 0; i < width; i++ )
+			{
+				// the last two columns reflect across the right edge
+				if ( (i >= ilo && i <= ihi) || i >= width-2 )
+					frame->SetPixelIntensity(i,j,ReducePixel(fine,i,j,width));
+				else if ( i < ilo )
+					frame->SetPixelIntensity(i,j,old->GetPixelIntensity(i,j));
+				else
+					frame->SetPixelIntensity(i,j,old->GetPixelIntensity(i+1,j));
+			}
+			lo[t*height+j] = ilo;
+			hi[t*height+j] = ihi;
+		}
+		*old = *frame;
+		delete frame;
+	}
+	coarser->SetMinWidth(width);
+	coarser->SetMaxWidth(width);
+
+	spyramid->pending[l] = 0;
+	delete [] spyramid->labels[l];
+	spyramid->labels[l] = NULL;
+}
+
+// removes column cols[t*height+y] of every row from level 0 and propagates
+// the change up the pyramid as far as the levels actually need syncing.
+// Takes ownership of cols.
+void RemovePyramidColumns(seamPyramidType *spyramid, int *cols)
+{
+	listPyramidType *lpyramid = spyramid->pyramid;
+	int *lo = cols;
+	int *hi = NULL;
+	RemoveColumns(&(lpyramid->Lists[0]), lo);
+
+	for ( int l = 1; l < lpyramid->Levels && lo != NULL; l++ )
+	{
+		PictureList *finer = &(lpyramid->Lists[l-1]);
+		int rows = finer->GetMaxHeight()*finer->GetLength();
+		for ( int r = 0; r < rows; r++ )
+		{
+			int rlo = lo[r];
+			int rhi = (hi!=NULL) ? hi[r] : lo[r];
+			if ( spyramid->pending[l]==0 || rlo < spyramid->lo[l][r] )
+				spyramid->lo[l][r] = rlo;
+			if ( spyramid->pending[l]==0 || rhi > spyramid->hi[l][r] )
+				spyramid->hi[l][r] = rhi;
+		}
+		spyramid->pending[l]++;
+		delete [] lo;
+		delete [] hi;
+		lo = hi = NULL;
+
+		if ( spyramid->pending[l]==2 )
+			SyncPyramidLevel(spyramid, l, lo, hi);
+	}
+	delete [] lo;
+	delete [] hi;
+}
+
+// removes the selected manifolds of a cut with num_labels labels from 
+// level 0, one at a time from left to right
+void RemovePyramidManifolds(seamPyramidType *spyramid, int *labels, int num_labels, bool *selected)
+{
+	PictureList *src = &(spyramid->pyramid->Lists[0]);
+	int width = src->GetMaxWidth();
+	int height = src->GetMaxHeight();
+	int time = src->GetLength();
+	int removed = 0;
+
+	for ( int j = 0; j < num_labels-1; j++ )
+	{
+		if ( !selected[j] )
+			continue;
+		// columns are found on the uncarved labeling, so shift them left
+		// by the number of manifolds already taken out of each row
+		int *cols = ManifoldColumns(labels, width, height, time, j);
+		for ( int r = 0; r < height*time; r++ )
+			cols[r] -= removed;
+		RemovePyramidColumns(spyramid, cols);
+		removed++;
+	}
+}
+
+// Picks the manifolds of one cut that are removed: the cheapest one and 
+// every other one whose energy is within (1+tolerance) of it, cheapest 
+// first and at most max_count of them. Returns the number picked.
+int SelectManifolds(double *energies, int num_seams, double tolerance, 
+					int max_count, bool *selected)
+{
+	int count = 0;
+	int best = -1;
+
+	for ( int j = 0; j < num_seams; j++ )
+		selected[j] = false;
+
+	while ( count < max_count )
+	{
+		int next = -1;
+		for ( int j = 0; j < num_seams; j++ )
+			if ( !selected[j] && (next==-1 || energies[j] < energies[next]) )
+				next = j;
+		if ( next==-1 )
+			break;
+		if ( best!=-1 && energies[next] > (1.0+tolerance)*energies[best] )
+			break;
+		if ( best==-1 )
+			best = next;
+		selected[next] = true;
+		count++;
+	}
+	return count;
+}
+
+int *CalcPixelCost(int *prev_labels, int prev_width, int prev_height, int num_labels, 
+				   int width, int height, int time, int *data)
 {
-	int prev_width = width/2;
-	int prev_height = height/2;
 	int prev_tot_pix = prev_width*prev_height*time;
 	
-	int ctl,ctr,cbl,cbr;
-	int pixel_per_fme,fme,col,row;
+	int pixel_per_fme,fme,col,row,lab,x,y,site;
 	pixel_per_fme = prev_width*prev_height;
 
 	for ( int i = 0; i <prev_tot_pix; i++ )
@@ -167,43 +429,29 @@ int *CalcPixelCost(GCoptimization *gc, int num_labels, int width, int height, in
 		col = (i-pixel_per_fme*fme)%prev_width;
 		row = (i-pixel_per_fme*fme)/prev_width;
 
-		if ( i < prev_tot_pix-1 && gc->whatLabel(i)==0 && gc->whatLabel(i+1)==0 )
+		if ( i < prev_tot_pix-1 && prev_labels[i]==prev_labels[i+1] )
 		{
-			ctl = (row*2*width)+(col*2)+(fme*width*height);//ctl = (row*2*width)+(col*2)+(fme*2*width*height);
-			ctr = ctl+1;
-			cbl = ctl+width;
-			cbr = ctr+width;
-			
-			data[ctl*num_labels+0] = 0;
-			data[ctl*num_labels+1] = MAX_COST_VALUE;
-			data[ctr*num_labels+0] = 0;
-			data[ctr*num_labels+1] = MAX_COST_VALUE;
-			data[cbl*num_labels+0] = 0;
-			data[cbl*num_labels+1] = MAX_COST_VALUE;
-			data[cbr*num_labels+0] = 0;
-			data[cbr*num_labels+1] = MAX_COST_VALUE;
-		}
-		else if ( i < prev_tot_pix-1 && gc->whatLabel(i)==1 && gc->whatLabel(i+1)==1 )
-		{
-			ctl = (row*2*width)+(col*2)+(fme*width*height);//ctl = (row*2*width)+(col*2)+(fme*2*width*height);
-			ctr = ctl+1;
-			cbl = ctl+width;
-			cbr = ctr+width;
-			
-			data[ctl*num_labels+0] = MAX_COST_VALUE;
-			data[ctl*num_labels+1] = 0;
-			data[ctr*num_labels+0] = MAX_COST_VALUE;
-			data[ctr*num_labels+1] = 0;
-			data[cbl*num_labels+0] = MAX_COST_VALUE;
-			data[cbl*num_labels+1] = 0;
-			data[cbr*num_labels+0] = MAX_COST_VALUE;
-			data[cbr*num_labels+1] = 0;
+			// fix the 2x2 block under this pixel to its label. A level that 
+			// lags one column behind its finer level may map past the edge.
+			lab = prev_labels[i];
+			for ( int dy = 0; dy < 2; dy++ )
+				for ( int dx = 0; dx < 2; dx++ )
+				{
+					x = col*2+dx;
+					y = row*2+dy;
+					if ( x >= width || y >= height )
+						continue;
+					site = (y*width)+x+(fme*width*height);
+					for ( int l = 0; l < num_labels; l++ )
+						data[site*num_labels+l] = (l==lab) ? 0 : MAX_COST_VALUE;
+				}
 		}
 	}
 	return data;
 }
 
-int *CalcDataCost(GCoptimization *gc, int width, int height, int time, int num_labels)
+int *CalcDataCost(int *prev_labels, int prev_width, int prev_height, 
+				  int width, int height, int time, int num_labels)
 {
 	int num_pixels = width*height*time;
 	// first set up the array for data costs
@@ -221,76 +469,21 @@ int *CalcDataCost(GCoptimization *gc, int width, int height, int time, int num_l
 
 			if (col==0 && l==0)								
 				data[i*num_labels+0] = 0;							// setting cost=0 preserves that pixel
-			else if (col==width-1 && l==1)
-				data[i*num_labels+1] = 0;							// setting cost=0 preserves that pixel
+			else if (col==width-1 && l==num_labels-1)
+				data[i*num_labels+l] = 0;							// setting cost=0 preserves that pixel
 			else
 				data[i*num_labels+l] = MAX_COST_VALUE;
 			
 		}
 	}
 	
-	if (gc!=NULL)				// use gc result from previous level for refining
-		data=CalcPixelCost(gc,num_labels,width,height,time,data);
+	if (prev_labels!=NULL)		// use manifold from previous level for refining
+		data=CalcPixelCost(prev_labels,prev_width,prev_height,num_labels,width,height,time,data);
 
 	return data;
 }
 
-PictureList *removeManifold(GCoptimization *gc, PictureList *src)
-{
-	int width = src->GetPicture(0)->GetWidth();
-	int height = src->GetPicture(0)->GetHeight();
-	int time = src->GetLength();
-	string str;
-	int pos;
-	const char *c;
-
-	PictureList *result = new PictureList(width-1,height,time);
-	result->SetName(src->GetName());
-	
-	Picture *frames = new Picture[time];
-	for (int tt = 0; tt< time; tt++)
-	{
-		frames[tt] = *(new Picture(width-1,height));
-		str = src->GetPicture(tt)->GetName();
-		pos = str.find("seam_");
-		if (pos!=-1)
-			str = str.erase (0,5);
-		
-		c=str.c_str();
-		frames[tt].SetName(c);
-	}
-	result->SetList(frames,time);
-	
-	int x, y, t;
-	pixelType pixel;
-	for ( int  i = 0; i < width*height*time; i++ )
-	{
-		t = i / (width*height);
-		x = (i % (width*height)) % width;
-		y = (i % (width*height)) / width;
-		
-		pixel.r = src->GetPixel(x,y,t).r;
-		pixel.g = src->GetPixel(x,y,t).g;
-		pixel.b = src->GetPixel(x,y,t).b;
-
-		if ( i < width*height*time-1 && 
-			((gc->whatLabel(i)!=0 && gc->whatLabel(i+1)!=1) ||
-			(gc->whatLabel(i) == gc->whatLabel(i+1))) )
-		{
-			if (gc->whatLabel(i)==0)
-				result->SetPixel(x,y,t,pixel);
-			else
-				result->SetPixel(x-1,y,t,pixel);		//sink pixels shift left by 1
-		}
-		else if ( i == width*height*time-1 )
-			result->SetPixel(x-1,y,t,pixel);
-	}
-	delete src;
-	return result;
-
-}
-
-void drawManifold(GCoptimization *gc, PictureList *src)
+void drawManifold(int *labels, int num_labels, bool *selected, PictureList *src)
 {
 	int width = src->GetMaxWidth();
 	int height = src->GetMaxHeight();
@@ -311,8 +504,14 @@ void drawManifold(GCoptimization *gc, PictureList *src)
 		x = (i % (width*height)) % width;
 		y = (i % (width*height)) / width;
 
-		if ( i < width*height*time-1 && gc->whatLabel(i)==0 && gc->whatLabel(i+1)==1 )
+		if ( x < width-1 && labels[i] < labels[i+1] )
 		{
+			// only mark the manifolds that are going to be removed
+			bool removed = false;
+			for ( int j = labels[i]; j < labels[i+1] && j < num_labels-1; j++ )
+				removed = removed || selected[j];
+			if ( !removed )
+				continue;
 			//printf("Found Seam\n");
 			pixel.r = 255;
 			pixel.g = 0;
@@ -374,7 +573,11 @@ void SaveRetargetVideo(int *labels, PictureList *src,int width, int height, int
 // in this version, set data and smoothness terms using arrays
 // grid neighborhood structure is assumed
 //
-GCoptimization *VideoSeamGraph_GraphCut(PictureList *src, int num_labels, int *data, int method)
+// with num_labels > 2 the cut finds num_labels-1 non-crossing manifolds at
+// once; if energies is given it receives the smooth energy of each of them
+//
+GCoptimization *VideoSeamGraph_GraphCut(PictureList *src, int num_labels, int *data, int method,
+										double *energies)
 {
 	int width = src->GetPicture(0)->GetWidth();
 	int height = src->GetPicture(0)->GetHeight();
@@ -434,8 +637,33 @@ GCoptimization *VideoSeamGraph_GraphCut(PictureList *src, int num_labels, int *d
 		}
 
 		printf("gc->setSmoothCost(&smoothFn, &toSmoothFn)\n");		
- 		gc->expansion(1);
+		if (num_labels == 2)
+ 			gc->expansion(1);
+		else
+		{
+			// start from evenly spaced straight manifolds, which is a valid
+			// ordering, and let the expansions bend them into place
+			for ( int i = 0; i < num_pixels; i++ )
+				gc->setLabel(i, ((i % width)*num_labels)/width);
+			gc->expansion();
+		}
 		printf("gc->expansion\n");
+
+		if (energies != NULL)
+		{
+			// the energy of manifold j alone is the smooth energy of the
+			// binary labeling that splits the labels at j
+			for ( int i = 0; i < num_pixels; i++ )
+				result[i] = gc->whatLabel(i);
+			for ( int j = 0; j < num_labels-1; j++ )
+			{
+				for ( int i = 0; i < num_pixels; i++ )
+					gc->setLabel(i, (result[i] > j) ? 1 : 0);
+				energies[j] = gc->giveSmoothEnergy();
+			}
+			for ( int i = 0; i < num_pixels; i++ )
+				gc->setLabel(i, result[i]);
+		}
 		
 		if (method == 1)
 		{
@@ -454,6 +682,7 @@ GCoptimization *VideoSeamGraph_GraphCut(PictureList *src, int num_labels, int *d
 		e.Report();
 	}
 
+	delete [] result;
 	//return src;
 	return gc;
 }
@@ -491,24 +720,119 @@ PictureList *Transpose_Video( PictureList *src )
 	return tvid;
 }
 
-int main(int argc, char **argv)
+// Finds the next manifolds of the level 0 video. Cached coarse manifolds are
+// reused; since syncing a level also invalidates every finer level, the 
+// valid ones always form the coarsest part of the pyramid. energies, if 
+// given, receives the energy of each manifold found on level 0.
+int *FindManifold(seamPyramidType *spyramid, int num_labels, int method, double *energies)
 {
-	PictureList *src = NULL;
-	int src_width, src_height, src_time;
-	int prev_width=0, prev_height=0, prev_time=0;
-
-	listPyramidType *lpyramid = NULL;
-	int num_labels;
+	listPyramidType *lpyramid = spyramid->pyramid;
+	int list_level = lpyramid->Levels;
+	int *prev_labels = NULL;
+	int prev_width = 0, prev_height = 0;
+	int *labels = NULL;
 	int *data;
-	GCoptimization *gc = NULL;
-	int pym_level = atoi(argv[6]);					// specify no. of pyramid levels
-	int list_level;						// 0 <= list_level < pym_level
 
-//	time_t start, end;
+	while ( list_level > 1 && spyramid->labels[list_level-1] != NULL )
+		list_level--;
+	if ( list_level < lpyramid->Levels )
+	{
+		prev_labels = spyramid->labels[list_level];
+		prev_width = lpyramid->Lists[list_level].GetMaxWidth();
+		prev_height = lpyramid->Lists[list_level].GetMaxHeight();
+		printf("\t\treusing manifold of list_level %d\n", list_level);
+	}
+	list_level--;
 
-	if (argc<6)
+	// Refines the seam from the previous level. Continue to refine until the original video size.
+	while ( list_level>=0 )
 	{
-		cout << "Usage: seam_carving_3d <src_folder> <num of v seams to remove> <num of h seams to remove> <output_folder> <method> <pyramid_level>" << endl;
+		printf("\t\tcurrent list_level is %d\n", list_level);
+		PictureList *src = &(lpyramid->Lists[list_level]);
+		int src_width = src->GetMaxWidth();
+		int src_height = src->GetMaxHeight();
+		int src_time = src->GetLength();	
+
+		data = CalcDataCost(prev_labels,prev_width,prev_height,
+							src_width,src_height,src_time,num_labels);
+		GCoptimization *gc = VideoSeamGraph_GraphCut(src,num_labels,data,method,
+													 (list_level==0) ? energies : NULL);
+		delete [] data;
+
+		labels = new int[src_width*src_height*src_time];
+		for ( int i = 0; i < src_width*src_height*src_time; i++ )
+			labels[i] = gc->whatLabel(i);
+		delete gc;
+
+		if ( list_level > 0 )
+			spyramid->labels[list_level] = labels;
+		prev_labels = labels;
+		prev_width = src_width;
+		prev_height = src_height;
+		list_level--;
+	}
+	return labels;
+}
+
+// finds and removes num_seams manifolds from the level 0 video, up to 
+// seams_per_cut of them per graph cut
+void CarveManifolds(seamPyramidType *spyramid, int num_seams, int seams_per_cut, 
+					double tolerance, int method, char *output_folder, bool transpose_last)
+{
+	int num_labels = seams_per_cut+1;
+	double *energies = new double[seams_per_cut];
+	bool *selected = new bool[seams_per_cut];
+	PictureList *src = &(spyramid->pyramid->Lists[0]);
+	PictureList *tsrc;
+
+	for( int s=1; s<=num_seams; )
+	{
+		int *labels = FindManifold(spyramid, num_labels, method, 
+								   (seams_per_cut > 1) ? energies : NULL);
+		int num_removed = 1;
+		if ( seams_per_cut > 1 )
+			num_removed = SelectManifolds(energies, seams_per_cut, tolerance, 
+										  num_seams-s+1, selected);
+		else
+			selected[0] = true;
+		printf("\t\t>>> seam #%d to #%d\n", s, s+num_removed-1);
+		bool last = (s+num_removed > num_seams);
+
+		drawManifold(labels, num_labels, selected, src);
+		if ( last && transpose_last )
+		{
+			tsrc = src->TransposePictureList();
+			SaveRetargetVideo(tsrc, output_folder);
+			delete tsrc;
+		}
+		else
+			SaveRetargetVideo(src, output_folder);
+
+		RemovePyramidManifolds(spyramid, labels, num_labels, selected);
+		if ( last && transpose_last )
+		{
+			tsrc = src->TransposePictureList();
+			SaveRetargetVideo(tsrc, output_folder);
+			delete tsrc;
+		}
+		else
+			SaveRetargetVideo(src, output_folder);
+
+		delete [] labels;
+		s += num_removed;
+	}
+	delete [] energies;
+	delete [] selected;
+}
+
+int main(int argc, char **argv)
+{
+	PictureList *src = NULL;
+	seamPyramidType *spyramid = NULL;
+
+	if (argc<7)
+	{
+		cout << "Usage: seam_carving_3d <src_folder> <num of v seams to remove> <num of h seams to remove> <output_folder> <method> <pyramid_level> [<seams per cut> <energy tolerance>]" << endl;
 		return 0;
 		//default parameters
 		/*
@@ -518,104 +842,45 @@ int main(int argc, char **argv)
 		argv[4] = "..\\VideoOutPPM\\";	// output
 		argv[5] = "1";					// 0 backward energy		1 forward energy
 		argv[6] = "2";					// number of level of pyramid
+		argv[7] = "1";					// max number of manifolds found by one graph cut
+		argv[8] = "0.0";				// a manifold of a cut is removed if its energy is within
+										// (1+tolerance) of the cheapest manifold of that cut
 		*/
 	}
 
+	int num_vseams = atoi(argv[2]);
+	int num_hseams = atoi(argv[3]);
+	int method = atoi(argv[5]);
+	int pym_level = atoi(argv[6]);					// specify no. of pyramid levels
+	int seams_per_cut = (argc>7) ? atoi(argv[7]) : 1;
+	double tolerance = (argc>8) ? atof(argv[8]) : 0.0;
+	if (seams_per_cut < 1)
+		seams_per_cut = 1;
+
 		// load input video
 	cout << "Creating gaussian pyramid for input video" << endl;
 	src = new PictureList(argv[1]);
 
-	num_labels = 2;
+	// the pyramid is built once per pass and updated after every removal
+	spyramid = SeamPyramid(src, pym_level);
+	delete src;
 
-	for( int s=1; s<=atoi(argv[2]); s++ )
+	CarveManifolds(spyramid, num_vseams, seams_per_cut, tolerance, method, argv[4], false);
+	
+	if ( num_hseams > 0 )			// if the number of hseams to be removed<=0, then skip hseam removal step.
 	{
-		printf("\t\t>>> v seam #%d\n",s);
-		list_level = pym_level - 1;
-//		time( &start );
-		lpyramid = ListPyramid(src, pym_level);
-//		time( &end );
-//		cout << "compute L Pyramid: " << difftime( end, start ) << " seconds" << endl;
-
+		src = spyramid->pyramid->Lists[0].TransposePictureList();
+		DeleteSeamPyramid(spyramid);
+		spyramid = SeamPyramid(src, pym_level);
 		delete src;
-		
-		// Refines the seam from the previous level. Continue to refine until the original video size.
-		while ( list_level>=0 )
-		{
-			printf("\t\tcurrent list_level is %d\n", list_level);
-			src = &(lpyramid->Lists[list_level]);
-			src_width = src->GetMaxWidth();
-			src_height = src->GetMaxHeight();
-			src_time = src->GetLength();	
-//			time( &start );
-			data = CalcDataCost(gc,src_width,src_height,src_time,num_labels);
-//			time( &end );
-//			cout << "CalcDataCost list_level " << list_level << ": " << difftime( end, start ) << " seconds" << endl;
-			delete gc;
-//			time( &start );
-			gc = VideoSeamGraph_GraphCut(src,num_labels,data,atoi(argv[5]));
-//			time( &end );
-//			cout << "VideoSeamGraph_GraphCut list_level " << list_level << ": " << difftime( end, start ) << " seconds" << endl;
-			delete data;
-
-			list_level--;
-		}
-		delete lpyramid;
-		
-		drawManifold(gc, src);
-		SaveRetargetVideo(src, argv[4]);
-		src = removeManifold(gc, src);
-		SaveRetargetVideo(src, argv[4]);
 
-		delete gc;
-		gc=NULL;
+		CarveManifolds(spyramid, num_hseams, seams_per_cut, tolerance, method, argv[4], true);
 	}
-	
-	if ( atoi(argv[3]) > 0 )			// if the number of hseams to be removed<=0, then skip hseam removal step.
-	{
-		src = Transpose_Video(src);
-		for( int s=1; s<=atoi(argv[3]); s++ )
-		{
-			printf("\t\t>>> h seam #%d\n",s);
-			list_level = pym_level - 1;
-			lpyramid = ListPyramid(src, pym_level);
-			delete src;
-			// Refines the seam from the previous level. Continue to refine until the original video size.
-			while ( list_level>=0 )				
-			{
-				printf("\t\tcurrent list_level is %d\n", list_level);
-				src = &(lpyramid->Lists[list_level]);
-				src_width = src->GetMaxWidth();
-				src_height = src->GetMaxHeight();
-				src_time = src->GetLength();	
-				data = CalcDataCost(gc,src_width,src_height,src_time,num_labels);
-				delete gc;
-				gc = VideoSeamGraph_GraphCut(src,num_labels,data,atoi(argv[5]));
-				delete data;
-
-				list_level--;
-			}
-			delete lpyramid;
-			
-			drawManifold(gc, src);
-			if (s==atoi(argv[3]))	
-				src = Transpose_Video(src);
-			SaveRetargetVideo(src, argv[4]);
-			if (s==atoi(argv[3]))	
-				src = Transpose_Video(src);
-			src = removeManifold(gc, src);
-			if (s==atoi(argv[3]))	
-				src = Transpose_Video(src);
-			SaveRetargetVideo(src, argv[4]);
-
-			delete gc;
-			gc=NULL;
-		}
 
-		delete src;
+	DeleteSeamPyramid(spyramid);
 	
 	//system("Pause");
 	return 0;
-	}
 }
 
-/////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+/////////////////////////////////////////////////////////////////////////////////
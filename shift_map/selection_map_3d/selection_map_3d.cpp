@@ -14,6 +14,14 @@
 #include "../Common/utils.h"
 #include "../GCoptimization/GCoptimization.h"
 
+/*
+ * coordinates of a graph site, precomputed so that the cost functions 
+ * do not have to decode them from the site index
+ */
+typedef struct {
+	int x, y, t;
+} siteCoord;
+
 /*
  * data structure for data term
  */
@@ -36,30 +44,18 @@ struct ForSmoothFn
 	videoSize src_size;
 	float alpha;
 	float beta;
+	siteCoord *coords;		// coordinates of each graph site
 };
 
 /*
- * function for data term calculation
+ * data term of pixel (x,y,t). The first and last column never become 
+ * graph sites (they are always kept), so no hard constraint is needed here
  */
-double DataFn(int p, int l, void *data)
+double DataCost(ForDataFn *myData, int x, int y, int t, int l)
 {
-	ForDataFn *myData = (ForDataFn *) data;
-	int width = myData->src_size.width;
-	int height = myData->src_size.height;
-	int time = myData->src_size.time;
-
-	int	t = p / (width*height);
-	int x = (p % (width*height)) % width;
-	int y = (p % (width*height)) / width;
-
 	double cost = 0.0;
 
-	// pixel arrangement
-	if (x==0 && l==0)
-		cost = 100000*MAX_COST_VALUE;
-	if (x==myData->src_size.width-1 && l==0)
-		cost = 100000*MAX_COST_VALUE;
-	if (x>0 && x<myData->src_size.width-1 && l==1)
+	if (l==1)
 		cost += myData->weight_1;
 	
 	return cost;
@@ -116,24 +112,19 @@ double GradientDiff(Matrix *gradient, int x1, int y1, int t1,
 }
 
 /*
- * function for smoothness term calculation
+ * smoothness term between pixels c1 and c2, where c1 comes after c2 
+ * in raster order
  */
-double smoothFn(int p1, int p2, int l1, int l2, void *data)
+double SmoothCost(ForSmoothFn *myData, siteCoord &c1, siteCoord &c2, int l1, int l2)
 {
-	ForSmoothFn *myData = (ForSmoothFn *) data;
 	double cost = 0.0;
-	//printf("smoothFn: calculating image gradient...\n");
-	int width = myData->src_size.width;
-	int height = myData->src_size.height;
-	int time = myData->src_size.time;
-	//printf("smoothFn: image width=%d and height=%d\n",width,height);
-	int	t1 = p1 / (width*height);
-	int x1 = (p1 % (width*height)) % width;
-	int y1 = (p1 % (width*height)) / width;
-
-	int	t2 = p2 / (width*height);
-	int x2 = (p2 % (width*height)) % width;
-	int y2 = (p2 % (width*height)) / width;
+	int	t1 = c1.t;
+	int x1 = c1.x;
+	int y1 = c1.y;
+
+	int	t2 = c2.t;
+	int x2 = c2.x;
+	int y2 = c2.y;
 
 	int x_offset = x2-x1;
 	int y_offset = y2-y1;
@@ -236,9 +227,99 @@ double smoothFn(int p1, int p2, int l1, int l2, void *data)
 }
 
 /*
- * Function to find the optimal selection map
+ * function for smoothness term calculation
+ */
+double smoothFn(int p1, int p2, int l1, int l2, void *data)
+{
+	ForSmoothFn *myData = (ForSmoothFn *) data;
+	return SmoothCost(myData, myData->coords[p1], myData->coords[p2], l1, l2);
+}
+
+/*
+ * neighbourhood of the forward energy 3D seam graph as (x,y,t) offsets
+ */
+static const int neighbour_offsets[14][3] = {
+	{-1, 0, 0}, {1, 0, 0}, {0,-1, 0}, {0, 1, 0},
+	{-1,-1, 0}, {1,-1, 0}, {-1, 1, 0}, {1, 1, 0},
+	{ 0, 0,-1}, {0, 0, 1}, {-1, 0,-1}, {1, 0,-1},
+	{-1, 0, 1}, {1, 0, 1}
+};
+
+/*
+ * Maps the selection of the coarser level onto the current level and 
+ * frees the pixels within radius columns of an upsampled 0-label in the 
+ * same row or the rows just above and below. All other pixels keep the 
+ * upsampled label, and the first and last column are always kept. 
+ * Without a coarser selection every interior pixel is free.
+ * Returns the labels of the level with -1 marking free pixels
+ */
+int *SelectionBand(int *coarse, videoSize coarse_size, videoSize size, int radius)
+{
+	int width = size.width;
+	int height = size.height;
+	int num_pixels = width*height*size.time;
+	int *labels = new int[num_pixels];
+
+	int i = 0;
+	for (int t = 0; t < size.time; t++)
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++, i++)
+			{
+				if (x == 0 || x == width-1)
+					labels[i] = 1;
+				else if (coarse == NULL)
+					labels[i] = -1;
+				else
+				{
+					int xc = x/2 < coarse_size.width-1 ? x/2 : coarse_size.width-1;
+					int yc = y/2 < coarse_size.height-1 ? y/2 : coarse_size.height-1;
+					labels[i] = coarse[(t*coarse_size.height + yc)*coarse_size.width + xc];
+				}
+			}
+
+	if (coarse == NULL)
+		return labels;
+
+	// zeros[row*(width+1)+x] counts the 0-labels left of x in the row
+	int *zeros = new int[size.time*height*(width+1)];
+	for (int row = 0; row < size.time*height; row++)
+	{
+		int *count = zeros + row*(width+1);
+		count[0] = 0;
+		for (int x = 0; x < width; x++)
+			count[x+1] = count[x] + (labels[row*width + x] == 0);
+	}
+
+	for (int t = 0; t < size.time; t++)
+		for (int y = 0; y < height; y++)
+			for (int x = 1; x < width-1; x++)
+			{
+				int lo = x-radius > 0 ? x-radius : 0;
+				int hi = x+radius < width-1 ? x+radius : width-1;
+				for (int yy = y-1; yy <= y+1; yy++)
+				{
+					if (yy < 0 || yy >= height)
+						continue;
+					int *count = zeros + (t*height + yy)*(width+1);
+					if (count[hi+1] > count[lo])
+					{
+						labels[(t*height + y)*width + x] = -1;
+						break;
+					}
+				}
+			}
+
+	delete [] zeros;
+	return labels;
+}
+
+/*
+ * Function to find the optimal selection map. Only the pixels marked -1 
+ * in labels become graph sites; the others keep their label and their 
+ * smoothness terms are folded into the data term of their free neighbours.
+ * The free pixels of labels are filled with the optimal labels
  */
-int *Selection_GraphCut(PictureList *src, videoSize src_size, int num_labels, 
+void Selection_GraphCut(PictureList *src, videoSize src_size, int num_labels, int *labels,
 						float weight_0, float weight_1, float alpha, float beta)
 {
 	// set up the needed data to pass to function for the data costs
@@ -249,26 +330,52 @@ int *Selection_GraphCut(PictureList *src, videoSize src_size, int num_labels,
 		gradient[t] = *(grad->dx) + *(grad->dy);
 	}
 
-	int num_pixels = src_size.width*src_size.height*src_size.time;
-	int *result = new int[num_pixels];   // stores result of optimization
+	int width = src_size.width;
+	int height = src_size.height;
+	int num_pixels = width*height*src_size.time;
 
-	try{
-		GCoptimizationFwdEn3DSeamGraph *gc = new GCoptimizationFwdEn3DSeamGraph(src_size.width,
-																				src_size.height,
-																				src_size.time,
-																				num_labels);
+	// graph sites are the free pixels, numbered in raster order so that 
+	// the site order agrees with the pixel order
+	int *site = new int[num_pixels];
+	int num_sites = 0;
+	for (int i = 0; i < num_pixels; i++)
+		site[i] = (labels[i] < 0) ? num_sites++ : -1;
+
+	siteCoord *coords = new siteCoord[num_sites > 0 ? num_sites : 1];
+	for (int i = 0; i < num_pixels; i++)
+	{
+		if (site[i] < 0)
+			continue;
+		coords[site[i]].x = i % width;
+		coords[site[i]].y = (i / width) % height;
+		coords[site[i]].t = i / (width*height);
+	}
+	printf("Selection_GraphCut: %d of %d pixels in the graph\n",num_sites,num_pixels);
+
+	if (num_sites < 2)
+	{
+		for (int i = 0; i < num_pixels; i++)
+			if (labels[i] < 0)
+				labels[i] = 1;
+		delete [] coords;
+		delete [] site;
+		delete [] gradient;
+		return;
+	}
+
+	GCoptimization::EnergyTermType *data = new GCoptimization::EnergyTermType[num_sites*num_labels];
 
+	try{
+		GCoptimizationGeneralGraph *gc = new GCoptimizationGeneralGraph(num_sites,num_labels);
 
 		// TODO: replace the hardcode of gradient threoshold
 		// for shot boundary
-		// data terms comes from function pointer
 		ForDataFn toDataFn;
 		toDataFn.src = src;
 		toDataFn.gradient = gradient;
 		toDataFn.src_size = src_size;
 		toDataFn.weight_0 = weight_0;
 		toDataFn.weight_1 = weight_1;
-		gc->setDataCost(&DataFn,&toDataFn);
 
 		// smoothness comes from function pointer
 		ForSmoothFn toSmoothFn;
@@ -277,32 +384,70 @@ int *Selection_GraphCut(PictureList *src, videoSize src_size, int num_labels,
 		toSmoothFn.src_size = src_size;
 		toSmoothFn.alpha = alpha;
 		toSmoothFn.beta = beta;
+		toSmoothFn.coords = coords;
+
+		// data terms, plus the smoothness towards neighbours with fixed labels
+		for (int s = 0; s < num_sites; s++)
+		{
+			siteCoord &c = coords[s];
+			int p = (c.t*height + c.y)*width + c.x;
+			for (int l = 0; l < num_labels; l++)
+				data[s*num_labels+l] = DataCost(&toDataFn, c.x, c.y, c.t, l);
+
+			for (int n = 0; n < 14; n++)
+			{
+				siteCoord cq;
+				cq.x = c.x + neighbour_offsets[n][0];
+				cq.y = c.y + neighbour_offsets[n][1];
+				cq.t = c.t + neighbour_offsets[n][2];
+				if (cq.x < 0 || cq.x >= width || cq.y < 0 || cq.y >= height ||
+					cq.t < 0 || cq.t >= src_size.time)
+					continue;
+
+				int q = (cq.t*height + cq.y)*width + cq.x;
+				if (site[q] >= 0)
+				{
+					if (site[q] < s)
+						gc->setNeighbors(s,site[q]);
+					continue;
+				}
+				for (int l = 0; l < num_labels; l++)
+				{
+					if (q < p)
+						data[s*num_labels+l] += SmoothCost(&toSmoothFn, c, cq, l, labels[q]);
+					else
+						data[s*num_labels+l] += SmoothCost(&toSmoothFn, cq, c, labels[q], l);
+				}
+			}
+		}
+		gc->setDataCost(data);
 		gc->setSmoothCost(&smoothFn, &toSmoothFn);
 
+		// start from keeping every pixel, which satisfies the hard constraints
+		for (int s = 0; s < num_sites; s++)
+			gc->setLabel(s,1);
+
 		printf("Before optimization energy is %f\n",gc->compute_energy());
 		gc->expansion();// run expansion for 2 iterations. For swap use gc->swap(num_iterations);
 		printf("After optimization energy is %f\n",gc->compute_energy());
 
 		// obtain the labels
-		int assign_idx, assignment;
 		for ( int  i = 0; i < num_pixels; i++ )
 		{
-			//printf("The optimal label for pixel %d is %d\n",i,gc->whatLabel(i));
-			result[i] = gc->whatLabel(i);
+			if (site[i] >= 0)
+				labels[i] = gc->whatLabel(site[i]);
 		}		
 
-		// upsampling shift-map from low-resolution to high-resolution
-		//up_result = UpsamplingShiftMap(result,ratio);	
-
-		delete [] gradient;
 		delete gc;
 	}
 	catch (GCException e){
 		e.Report();
 	}
 
-	return result;
-
+	delete [] data;
+	delete [] coords;
+	delete [] site;
+	delete [] gradient;
 }
 
 /*
@@ -348,12 +493,12 @@ int main(int argc, char **argv)
 	PictureList *src = NULL;
 	listPyramidType *vpyramid = NULL;
 	int num_labels;
-	int *map;
-	videoSize src_size;
+	int *map = NULL;
+	videoSize src_size, prev_size;
 
 	if (argc<7)
 	{
-		cout << "Usage: selection_map_3d <src_folder> <0-weight> <1-weight> <alpha> <beta> <output_folder>" << endl;
+		cout << "Usage: selection_map_3d <src_folder> <0-weight> <1-weight> <alpha> <beta> <output_folder> [band_radius] [finest_level]" << endl;
 		return 0;
 		//default parameters
 		/*
@@ -364,28 +509,41 @@ int main(int argc, char **argv)
 		argv[5] = "1";			//0 backward energy		1 forward energy
 		*/
 	}
+	int radius = (argc > 7) ? atoi(argv[7]) : 2;		// band around the coarse selection
+	int finest = (argc > 8) ? atoi(argv[8]) : 0;		// level of the output
 
 	// load input video
 	cout << "Creating gaussian pyramid for input video" << endl;
 	src = new PictureList(argv[1]);
 	int level = 3; // gpyramid->Levels-1
 	vpyramid = ListPyramid(src,level+1);
-	src = &(vpyramid->Lists[level]);
-
-	src_size.width  = src->GetPicture(0)->GetWidth();
-	src_size.height = src->GetPicture(0)->GetHeight();
-	src_size.time = src->GetLength();	
+	delete src;
 	num_labels = 2;
 
-	map = Selection_GraphCut(src,src_size,num_labels,
+	// solve the coarsest level over the whole volume, then refine the 
+	// selection level by level inside a band around it
+	for (int l = level; l >= finest; l--)
+	{
+		src = &(vpyramid->Lists[l]);
+		src_size.width  = src->GetPicture(0)->GetWidth();
+		src_size.height = src->GetPicture(0)->GetHeight();
+		src_size.time = src->GetLength();
+		printf("Selection map at level %d (%dx%d)\n",l,src_size.width,src_size.height);
+
+		int *labels = SelectionBand(map, prev_size, src_size, radius);
+		Selection_GraphCut(src,src_size,num_labels,labels,
 										atof(argv[2]),atof(argv[3]),
 										atof(argv[4]),atof(argv[5]));
+		delete [] map;
+		map = labels;
+		prev_size = src_size;
+	}
 	
 	SaveRetargetOutput(map, src, argv[6]);
 	
 	delete [] vpyramid->Lists;
 	delete vpyramid;
-	delete map;
+	delete [] map;
 	
 	system("Pause");
 	return 1;
@@ -11,6 +11,42 @@
 #include "../Common/video.h"
 #include "../Common/utils.h"
 
+/*
+ * motion energy of a frame from its two neighbours prev and next: the sum 
+ * of the thresholded frame difference weighted by its standard deviation. 
+ * Works in one pass straight on the pixel buffers, so the same value as 
+ * FrameDifference() gives without building the difference matrix
+ */
+double FrameMotionEnergy(Picture *prev, Picture *next, double threshold)
+{
+	if ((prev->GetHeight() != next->GetHeight()) ||
+		(prev->GetWidth() != next->GetWidth()))
+		throw IncompatibleDimensionsException("t_adaptive_scaling", "FrameMotionEnergy");
+
+	pixelType *p1 = prev->GetPicture();
+	pixelType *p2 = next->GetPicture();
+	int num_pixels = prev->GetWidth()*prev->GetHeight();
+
+	double sum = 0.0;
+	double sum_sq = 0.0;
+	for (int i = 0; i < num_pixels; i++)
+	{
+		int diff = abs(p1[i].r-p2[i].r) + abs(p1[i].g-p2[i].g) + abs(p1[i].b-p2[i].b);
+		if (diff > threshold)
+		{
+			sum += diff;
+			sum_sq += (double)diff*diff;
+		}
+	}
+
+	double mean = sum/num_pixels;
+	double var = (sum_sq-num_pixels*mean*mean)/(num_pixels-1);
+	if (var < 0.0)
+		var = 0.0;
+
+	return sqrt(var)*sum;
+}
+
 double *MotionEnergy(Video *src, double threshold)
 {
 #ifdef USE_TRACEBACK
@@ -18,43 +54,11 @@ double *MotionEnergy(Video *src, double threshold)
 #endif
 	double *total_dt = new double[src->GetTime()];
 
-	Matrix *tgradient = NULL;
 	for (int t=0; t<src->GetTime(); t++)
 	{
-		//results[t] = *(new Matrix(0,0));
-		// results[t] = *(Gradient(src->GetFrame(t)));
-		if (tgradient)
-			delete tgradient;
-		
-		double tdt = 0.0;
-		if (t>0 && t<(src->GetTime()-1))
-		{			
-			//results[t] += *(FrameDifference(src->GetFrame(t-1),src->GetFrame(t+1)));
-			tgradient = FrameDifference(src->GetFrame(t-1),src->GetFrame(t+1),tdt,threshold);
-		}
-		else
-		{
-			int lower_t = max(t-1,0);
-			int upper_t = min(t+1,src->GetTime()-1);
-			//results[t] += *(FrameDifference(src->GetFrame(lower_t),src->GetFrame(upper_t)));
-			tgradient = FrameDifference(src->GetFrame(lower_t),src->GetFrame(upper_t),tdt,threshold);
-		}
-
-		//total_dt[t] = tdt;
-
-		double std = 0.0;
-		double mean = tdt/(tgradient->NumOfRows()*tgradient->NumOfCols());
-		for (int x = 0; x < tgradient->NumOfRows(); x++)
-		{
-			for (int y = 0; y < tgradient->NumOfCols(); y++)
-			{
-				std += pow(tgradient->Get(x+1,y+1)-mean,2.0);
-			}
-		}
-		std /= tgradient->NumOfRows()*tgradient->NumOfCols()-1;
-		std = sqrt(std);
-		total_dt[t] = std*tdt;
-		
+		int lower_t = max(t-1,0);
+		int upper_t = min(t+1,src->GetTime()-1);
+		total_dt[t] = FrameMotionEnergy(src->GetFrame(lower_t),src->GetFrame(upper_t),threshold);
 	}
 
 	return total_dt;
@@ -88,25 +92,39 @@ double *SmoothMotionEnergy(double *energy, int time, int window_size)
 	return result;
 }
 
-void AdaptiveTemporalReduce(Video *src, double *gradient, int time, char *output_folder)
+/*
+ * chooses which of the length frames with the given motion energy make up 
+ * the time output frames. Frames whose motion jumps ahead of the schedule 
+ * are always kept; the rest are sampled evenly in accumulated motion. 
+ * Returns the time frame indices in increasing order
+ */
+int *TemporalSchedule(double *gradient, int length, int time)
 {
-	double ratio = (src->GetTime() / time);
-	int *selected = new int[src->GetTime()];
-	for (int t = 0; t < src->GetTime(); t++)
+	int *frame_ids = new int[time];
+	if (time >= length)
+	{
+		for (int t = 0; t < time; t++)
+			frame_ids[t] = min(t,length-1);
+		return frame_ids;
+	}
+
+	int *selected = new int[length];
+	for (int t = 0; t < length; t++)
 		selected[t] = 0;
 
 	double *acMotion = NULL;
 	double *mapping = NULL;
 	int *left_idices = NULL;
-	int shot_num = src->GetTime();
+	int shot_num = length;
 	int left_time;
+	int left_frames;
 	while (shot_num>0)
 	{
 		shot_num = 0;
 		left_time = time;
 		
-		int left_frames = 0;		
-		for (int t = 0; t < src->GetTime(); t++)
+		left_frames = 0;		
+		for (int t = 0; t < length; t++)
 		{
 			if (selected[t]==0)
 				left_frames++;
@@ -120,7 +138,7 @@ void AdaptiveTemporalReduce(Video *src, double *gradient, int time, char *output
 			delete [] acMotion;
 		acMotion = new double[left_frames];
 		int cur_frame = 0;
-		for (int t = 0; t < src->GetTime(); t++)
+		for (int t = 0; t < length; t++)
 		{
 			if (selected[t]==0)
 			{
@@ -142,14 +160,19 @@ void AdaptiveTemporalReduce(Video *src, double *gradient, int time, char *output
 		if (mapping!=NULL)
 			delete [] mapping;
 		mapping = new double[left_frames];
+		double range = acMotion[left_frames-1]-acMotion[0];
 		for (int t = 0; t < left_frames; t++)
 		{
-			mapping[t] = (acMotion[t]-acMotion[0])/
-							(acMotion[left_frames-1]-acMotion[0])*left_time;
-
+			// without any motion the frames are sampled evenly
+			if (range > 0.0)
+				mapping[t] = (acMotion[t]-acMotion[0])/range*left_time;
+			else
+				mapping[t] = (double)t/max(left_frames-1,1)*left_time;
 
+			if (t == 0)
+				continue;
 			double bound = ceil(mapping[t-1])+1+((ceil(mapping[t-1])-mapping[t-1])+1);
-			if (mapping[t]>bound)
+			if (mapping[t]>bound && left_time-shot_num>1)
 			{
 				selected[left_idices[t]] = 1;
 				shot_num++;
@@ -160,16 +183,15 @@ void AdaptiveTemporalReduce(Video *src, double *gradient, int time, char *output
 
 	delete [] acMotion;
 
-	cout << "Reducing video from " << src->GetTime() 
-		 << " frames to " << time << " frames..." << endl;
-	
 	int *frame_ids_left = new int[left_time];
+	for (int t = 0; t < left_time; t++)
+		frame_ids_left[t] = left_idices[left_frames-1];
 	frame_ids_left[0] = left_idices[0];
 	int last_sid = 0;
 	
 	for (int t = 1; t < left_time; t++)
 	{
-		for (int tt = last_sid+1; tt < src->GetTime()-time+left_time; tt++)
+		for (int tt = last_sid+1; tt < left_frames; tt++)
 		{
 			if (mapping[tt]==t)
 			{
@@ -179,18 +201,6 @@ void AdaptiveTemporalReduce(Video *src, double *gradient, int time, char *output
 			}
 			if (mapping[tt]>t)
 			{
-				/*
-				double lweight = t-mapping[tt-1];
-				double rweight = mapping[tt]-t;
-				
-				frames[t] = *(InterpolateFrame(src->GetFrame(tt-1),
-											   lweight/(lweight+rweight),
-											   src->GetFrame(tt),
-											   rweight/(lweight+rweight)));
-
-			    last_sid = tt-2;
-			    */
-				
 				if (t-mapping[tt-1]<=mapping[tt]-t)
 				{
 					frame_ids_left[t] = left_idices[tt-1];
@@ -210,58 +220,119 @@ void AdaptiveTemporalReduce(Video *src, double *gradient, int time, char *output
 	delete [] left_idices;
 	delete [] mapping;
 
-	int *frame_ids_selected = new int[time-left_time];
+	// merge the kept frames back in
+	int cur_left = 0;
 	int cur_frame = 0;
-	for (int t = 0; t < src->GetTime(); t++)
+	for (int t = 0; t < length; t++)
 	{
-		if (selected[t]>0)
-		{
-			frame_ids_selected[cur_frame] = t;
-			cur_frame++;
-		}
+		if (selected[t] == 0)
+			continue;
+		while (cur_left < left_time && frame_ids_left[cur_left] < t)
+			frame_ids[cur_frame++] = frame_ids_left[cur_left++];
+		frame_ids[cur_frame++] = t;
 	}
+	while (cur_left < left_time)
+		frame_ids[cur_frame++] = frame_ids_left[cur_left++];
 
 	delete [] selected;
+	delete [] frame_ids_left;
 
-	int cur_left = 0;
-	int cur_selected = 0;
-	Picture *frame;
+	return frame_ids;
+}
+
+/*
+ * saves frame as the t-th frame of the output
+ */
+void SaveOutputFrame(Picture *frame, int t, char *output_folder)
+{
+	char framename[512] = {'\0'};
+	char buf[512] = {'\0'};
+	strcat(framename,output_folder);
+	strcat(framename,itoa(t,buf,10));
+	strcat(framename,".ppm");
+	frame->Save(framename);
+}
+
+void AdaptiveTemporalReduce(Video *src, double *gradient, int time, char *output_folder)
+{
+	cout << "Reducing video from " << src->GetTime() 
+		 << " frames to " << time << " frames..." << endl;
+
+	int *frame_ids = TemporalSchedule(gradient, src->GetTime(), time);
 	for (int t = 0; t < time; t++)
+		SaveOutputFrame(src->GetFrame(frame_ids[t]), t, output_folder);
+
+	delete [] frame_ids;
+}
+
+/*
+ * streaming version of MotionEnergy followed by AdaptiveTemporalReduce: 
+ * frames are read from input_folder one window at a time and each window 
+ * is scheduled on its own, with its share of the output frames, and 
+ * written before the next one is read. At most window+2 frames are held 
+ * in memory whatever the length of the input
+ */
+void StreamTemporalReduce(char *input_folder, double ratio, int window, char *output_folder)
+{
+	vector<string> framenames = Get_FrameNames(input_folder, VIDEO_FRAME_EXT);
+	int length = framenames.size();
+	if (length == 0)
+		throw FolderNotFoundException("t_adaptive_scaling", "StreamTemporalReduce", input_folder);
+	int time = ceil(length*ratio);
+
+	cout << "Reducing video from " << length 
+		 << " frames to " << time << " frames..." << endl;
+
+	// frames currently loaded, indexed by frame number
+	Picture **frames = new Picture*[length];
+	for (int t = 0; t < length; t++)
+		frames[t] = NULL;
+
+	double *energy = new double[window];
+	int emitted = 0;
+	int loaded = 0;
+	for (int begin = 0; begin < length; begin += window)
 	{
-		char framename[512] = {'\0'};
-		char buf[512] = {'\0'};
-		strcat(framename,output_folder);
-		strcat(framename,itoa(t,buf,10));
-		strcat(framename,".ppm");
-	 
-		if ((frame_ids_left[cur_left]<frame_ids_selected[cur_selected]) &&
-			(cur_left<left_time && cur_selected<time-left_time))
+		int end = min(begin+window,length);
+
+		// the last frame of the window needs its successor
+		for (; loaded <= end && loaded < length; loaded++)
 		{
-			frame = src->GetFrame(frame_ids_left[cur_left]);
-			cur_left++;
+			string framefile = input_folder+framenames.at(loaded);
+			frames[loaded] = new Picture(framefile.c_str());
 		}
-		else if ((frame_ids_left[cur_left]>frame_ids_selected[cur_selected]) &&
-			(cur_left<left_time && cur_selected<time-left_time))
+
+		for (int t = begin; t < end; t++)
 		{
-			frame = src->GetFrame(frame_ids_selected[cur_selected]);
-			cur_selected++;
+			int lower_t = max(t-1,0);
+			int upper_t = min(t+1,length-1);
+			energy[t-begin] = FrameMotionEnergy(frames[lower_t],frames[upper_t],0.0);
 		}
-		else if ((cur_left<left_time) && cur_selected==time-left_time)
+
+		// share of the output frames that falls into this window
+		int target = (end == length) ? time : (int)floor((double)end*time/length+0.5);
+		if (target > emitted)
 		{
-			frame = src->GetFrame(frame_ids_left[cur_left]);
-			cur_left++;
+			int *frame_ids = TemporalSchedule(energy, end-begin, target-emitted);
+			for (int t = 0; t < target-emitted; t++)
+				SaveOutputFrame(frames[begin+frame_ids[t]], emitted+t, output_folder);
+			delete [] frame_ids;
+			emitted = target;
 		}
-		else if ((cur_left==left_time) && cur_selected<time-left_time)
+
+		// only the last frame is still needed, by the next window
+		for (int t = max(begin-1,0); t < end-1; t++)
 		{
-			frame = src->GetFrame(frame_ids_selected[cur_selected]);
-			cur_selected++;
+			delete frames[t];
+			frames[t] = NULL;
 		}
-
-		frame->Save(framename);
 	}
 
-	delete [] frame_ids_left;
-	delete [] frame_ids_selected;
+	for (int t = 0; t < length; t++)
+		if (frames[t])
+			delete frames[t];
+	delete [] frames;
+	delete [] energy;
 }
 
 
@@ -272,12 +343,20 @@ int main(int argc, char **argv)
 
 	if (argc<4)
 	{
-		cout << "Usage: t_adaptive_scaling <input_folder> <ratio> <output_folder>" << endl;
+		cout << "Usage: t_adaptive_scaling <input_folder> <ratio> <output_folder> [window]" << endl;
 		return 0;
 		//default parameters
 	}
 	double ratio = atof(argv[2]);
 
+	// stream the input window by window instead of loading all of it
+	int window = (argc > 4) ? atoi(argv[4]) : 0;
+	if (window > 0)
+	{
+		StreamTemporalReduce(argv[1], ratio, window, argv[3]);
+		return 1;
+	}
+
 	// load input video
 	cout << "Loading input video..." << endl;
 	input = new Video(argv[1]);	